@@ -0,0 +1,302 @@
+/**
+ * @file adaptive.c
+ * @date Oct 2026
+ * @brief This module implements the adaptive meta policy. It runs shadow simulations 
+ *        of the built-in policies on ghost page tables and, at the end of each phase, 
+ *        switches the active policy to the candidate with the fewest shadow faults 
+ *        during that phase.
+ *
+ *        The shadows see the fault stream of mmanage and the reference bits harvested 
+ *        at the end of each time interval. Accesses to pages that are resident in a 
+ *        ghost but not in main memory are therefore approximated by the harvested 
+ *        reference bits.
+ *
+ *        Each ghost runs its own instance of its candidate, the active policy runs 
+ *        another instance. Both kinds of instances see the env embedded in their 
+ *        ghost or in the adaptive state.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "policy.h"
+#include "vmem.h"
+#include "logger.h"
+#include "error.h"
+
+#define ADAPT_PHASE_TICKS 25            //!< Length of a phase in time intervals
+#define ADAPT_NCAND       3             //!< Number of candidate policies
+#define ADAPT_MARGIN      8             //!< A candidate must save 1/ADAPT_MARGIN of the shadow faults of the active policy
+
+/**
+ * Ghost page table of a candidate
+ */
+struct ghost {
+    struct policy_env env;              //!< Functions of the candidate instance; first member, see ghost_of
+    struct policy inst;                 //!< Instance of the candidate
+    int page[VMEM_NFRAMES];             //!< Page in ghost frame; VOID_IDX: unused
+    bool ref[VMEM_NFRAMES];             //!< Reference bit of ghost frame
+    int frame_of[VMEM_MAXPAGES];        //!< Ghost frame of (global) page; VOID_IDX: not in ghost memory
+    long phase_faults;                  //!< Shadow faults during current phase
+    long faults;                        //!< Shadow faults in total
+};
+
+/**
+ * State of the adaptive policy
+ */
+struct adaptive {
+    struct policy_env env;              //!< Functions of the active instance; first member, see adaptive_of
+    const struct policy_env *real_env;  //!< Functions of mmanage
+    struct policy active_inst;          //!< Instance of the active policy
+    struct ghost ghosts[ADAPT_NCAND];   //!< Shadow simulations of the candidates
+    int active;                         //!< Candidate used for the real frames
+    bool soft_ref[VMEM_NFRAMES];        //!< Harvested reference bits, kept for policies that test PTF_REF
+    int ticks;                          //!< Time intervals in current phase
+    int phase;                          //!< Number of completed phases
+    int switches;                       //!< Number of policy switches
+    long shadow_ns;                     //!< Time spent in shadow simulation
+};
+
+static const struct policy_ops *cand[ADAPT_NCAND] = { &policy_fifo, &policy_clock, &policy_aging };
+
+/**
+ *****************************************************************************************
+ *  @brief      These functions return the ghost / the adaptive state an env belongs to.
+ ****************************************************************************************/
+static struct ghost *ghost_of(const struct policy_env *env) {
+    return (struct ghost *) env;
+}
+
+static struct adaptive *adaptive_of(const struct policy_env *env) {
+    return (struct adaptive *) env;
+}
+
+static int ghost_page_of_frame(const struct policy_env *env, int frame) {
+    return ghost_of(env)->page[frame];
+}
+
+static bool ghost_test_ref(const struct policy_env *env, int frame) {
+    return ghost_of(env)->ref[frame];
+}
+
+static void ghost_clear_ref(const struct policy_env *env, int frame) {
+    ghost_of(env)->ref[frame] = false;
+}
+
+static bool ghost_pinned(const struct policy_env *env, int frame) {
+    // the shadow simulations do not know which pages would be pinned
+    return false;
+}
+
+static int active_page_of_frame(const struct policy_env *env, int frame) {
+    const struct policy_env *real = adaptive_of(env)->real_env;
+    return real->page_of_frame(real, frame);
+}
+
+static bool active_test_ref(const struct policy_env *env, int frame) {
+    const struct policy_env *real = adaptive_of(env)->real_env;
+    return adaptive_of(env)->soft_ref[frame] || real->test_ref(real, frame);
+}
+
+static void active_clear_ref(const struct policy_env *env, int frame) {
+    const struct policy_env *real = adaptive_of(env)->real_env;
+    adaptive_of(env)->soft_ref[frame] = false;
+    real->clear_ref(real, frame);
+}
+
+static bool active_pinned(const struct policy_env *env, int frame) {
+    const struct policy_env *real = adaptive_of(env)->real_env;
+    return real->pinned(real, frame);
+}
+
+static long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function simulates an access of a candidate to a page.
+ ****************************************************************************************/
+static void ghost_access(struct ghost *g, int page) {
+    const struct policy_ops *ops = g->inst.ops;
+    int frame = g->frame_of[page];
+    if (frame != VOID_IDX) {
+        g->ref[frame] = true;
+        return;
+    }
+    g->phase_faults++;
+    g->faults++;
+    for (frame = 0; (frame < g->env.nframes) && (g->page[frame] != VOID_IDX); frame++);
+    if (frame == g->env.nframes) {
+        frame = ops->choose_victim(g->inst.state, &g->env, page);
+        g->frame_of[g->page[frame]] = VOID_IDX;
+    }
+    g->page[frame] = page;
+    g->frame_of[page] = frame;
+    g->ref[frame] = true;
+    if (ops->on_fault) {
+        ops->on_fault(g->inst.state, &g->env, page, frame);
+    }
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      At the end of a phase the candidate with the fewest shadow faults 
+ *              becomes the active policy, if it saves at least 1/ADAPT_MARGIN of the 
+ *              shadow faults of the active policy. A switch restarts the policy with 
+ *              an empty state, so small gains are not worth it.
+ ****************************************************************************************/
+static void end_of_phase(struct adaptive *a) {
+    struct ghost *g = a->ghosts;
+    int best = a->active;
+    for (int k = 0; k < ADAPT_NCAND; k++) {
+        if (g[k].phase_faults < g[best].phase_faults) {
+            best = k;
+        }
+    }
+    long active_faults = g[a->active].phase_faults;
+    if (active_faults - g[best].phase_faults < (active_faults + ADAPT_MARGIN - 1) / ADAPT_MARGIN) {
+        best = a->active;
+    }
+    log_message("Adaptive phase %d: shadow faults FIFO %ld CLOCK %ld AGING %ld, active %s%s%s, overhead %ld us",
+                a->phase, g[0].phase_faults, g[1].phase_faults, g[2].phase_faults, cand[a->active]->name,
+                (best != a->active) ? " -> " : "", (best != a->active) ? cand[best]->name : "", a->shadow_ns / 1000);
+    if (best != a->active) {
+        a->active = best;
+        memset(a->soft_ref, 0, sizeof(a->soft_ref));
+        policy_stop(&a->active_inst);
+        policy_start(&a->active_inst, cand[best], &a->env);
+        a->switches++;
+    }
+    for (int k = 0; k < ADAPT_NCAND; k++) {
+        g[k].phase_faults = 0;
+    }
+    a->ticks = 0;
+    a->phase++;
+}
+
+static void adaptive_init(void *state, const struct policy_env *e) {
+    struct adaptive *a = state;
+    a->real_env = e;
+    for (int k = 0; k < ADAPT_NCAND; k++) {
+        struct ghost *g = &a->ghosts[k];
+        g->env = (struct policy_env) { e->nframes, ghost_page_of_frame, ghost_test_ref, ghost_clear_ref, ghost_pinned };
+        for (int i = 0; i < VMEM_NFRAMES; i++) {
+            g->page[i] = VOID_IDX;
+            g->ref[i] = false;
+        }
+        for (int i = 0; i < VMEM_MAXPAGES; i++) {
+            g->frame_of[i] = VOID_IDX;
+        }
+        g->phase_faults = g->faults = 0;
+        policy_start(&g->inst, cand[k], &g->env);
+    }
+    a->env = (struct policy_env) { e->nframes, active_page_of_frame, active_test_ref, active_clear_ref, active_pinned };
+    a->active = 0;
+    policy_start(&a->active_inst, cand[a->active], &a->env);
+    memset(a->soft_ref, 0, sizeof(a->soft_ref));
+}
+
+static void adaptive_on_access(void *state, const struct policy_env *env, int frame) {
+    struct adaptive *a = state;
+    long start = now_ns();
+    a->soft_ref[frame] = true;
+    for (int k = 0; k < ADAPT_NCAND; k++) {
+        ghost_access(&a->ghosts[k], env->page_of_frame(env, frame));
+    }
+    a->shadow_ns += now_ns() - start;
+    const struct policy_ops *ops = a->active_inst.ops;
+    if (ops->on_access) {
+        ops->on_access(a->active_inst.state, &a->env, frame);
+    }
+}
+
+static void adaptive_on_fault(void *state, const struct policy_env *env, int page, int frame) {
+    struct adaptive *a = state;
+    long start = now_ns();
+    for (int k = 0; k < ADAPT_NCAND; k++) {
+        ghost_access(&a->ghosts[k], page);
+    }
+    a->shadow_ns += now_ns() - start;
+    a->soft_ref[frame] = false;
+    const struct policy_ops *ops = a->active_inst.ops;
+    if (ops->on_fault) {
+        ops->on_fault(a->active_inst.state, &a->env, page, frame);
+    }
+}
+
+static void adaptive_on_release(void *state, const struct policy_env *env, int frame) {
+    struct adaptive *a = state;
+    // the ghosts keep the page, a real page fault will load it again
+    a->soft_ref[frame] = false;
+    const struct policy_ops *ops = a->active_inst.ops;
+    if (ops->on_release) {
+        ops->on_release(a->active_inst.state, &a->env, frame);
+    }
+}
+
+static void adaptive_on_tick(void *state, const struct policy_env *env) {
+    struct adaptive *a = state;
+    long start = now_ns();
+    for (int k = 0; k < ADAPT_NCAND; k++) {
+        struct ghost *g = &a->ghosts[k];
+        const struct policy_ops *ops = g->inst.ops;
+        // harvest the ghost reference bits like mmanage does for the real frames
+        if (ops->on_access) {
+            for (int i = 0; i < VMEM_NFRAMES; i++) {
+                if ((g->page[i] != VOID_IDX) && g->ref[i]) {
+                    ops->on_access(g->inst.state, &g->env, i);
+                    g->ref[i] = false;
+                }
+            }
+        }
+        if (ops->on_tick) {
+            ops->on_tick(g->inst.state, &g->env);
+        }
+    }
+    a->shadow_ns += now_ns() - start;
+    const struct policy_ops *ops = a->active_inst.ops;
+    if (ops->on_tick) {
+        ops->on_tick(a->active_inst.state, &a->env);
+    }
+    if (++a->ticks == ADAPT_PHASE_TICKS) {
+        end_of_phase(a);
+    }
+}
+
+static int adaptive_choose_victim(void *state, const struct policy_env *env, int page) {
+    struct adaptive *a = state;
+    return a->active_inst.ops->choose_victim(a->active_inst.state, &a->env, page);
+}
+
+static void adaptive_stats(void *state, const struct policy_env *env, FILE *f) {
+    struct adaptive *a = state;
+    fprintf(f, "Adaptive: active %s, %d phases, %d switches, shadow faults FIFO %ld CLOCK %ld AGING %ld, overhead %ld us\n",
+            cand[a->active]->name, a->phase, a->switches, a->ghosts[0].faults, a->ghosts[1].faults, a->ghosts[2].faults, 
+            a->shadow_ns / 1000);
+}
+
+static void adaptive_teardown(void *state) {
+    struct adaptive *a = state;
+    for (int k = 0; k < ADAPT_NCAND; k++) {
+        policy_stop(&a->ghosts[k].inst);
+    }
+    policy_stop(&a->active_inst);
+}
+
+const struct policy_ops policy_adaptive = {
+    .name = "ADAPTIVE",
+    .size = sizeof(struct adaptive),
+    .init = adaptive_init,
+    .on_access = adaptive_on_access,
+    .on_fault = adaptive_on_fault,
+    .on_release = adaptive_on_release,
+    .on_tick = adaptive_on_tick,
+    .choose_victim = adaptive_choose_victim,
+    .stats = adaptive_stats,
+    .teardown = adaptive_teardown,
+};
+
+// EOF
@@ -0,0 +1,82 @@
+/**
+ * @file bench.c
+ * @date Oct 2026
+ * @brief This module implements the measurement and reporting functions of the
+ *        benchmarks, see bench.h.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include "bench.h"
+#include "vmem.h"
+
+static int warmup = BENCH_WARMUP;       //!< Number of unrecorded runs according to the parameters
+static int reps = BENCH_REPS;           //!< Number of recorded runs according to the parameters
+static bool first_result = true;        //!< No result has been written yet
+
+/**
+ * Two-sided 95% quantiles of Student's t distribution for 1 .. 30 degrees of freedom
+ */
+static const double t95[] = { 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                              2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                              2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+
+int bench_param(const char *arg) {
+    int n;
+    if ((1 == sscanf(arg, "-warmup=%d", &n)) && (n >= 0)) {
+        warmup = n;
+        return 1;
+    }
+    if ((1 == sscanf(arg, "-reps=%d", &n)) && (n >= 1) && (n <= BENCH_MAXREPS)) {
+        reps = n;
+        return 1;
+    }
+    return 0;
+}
+
+void bench_measure(struct bench_result *r, bench_fn fn, void *arg) {
+    double v[BENCH_MAXREPS];
+    for (int i = 0; i < warmup; i++) {
+        fn(arg);
+    }
+    double sum = 0.0;
+    for (int i = 0; i < reps; i++) {
+        v[i] = fn(arg);
+        sum += v[i];
+    }
+    r->warmup = warmup;
+    r->reps = reps;
+    r->mean = sum / reps;
+    r->min = r->max = v[0];
+    double sq = 0.0;
+    for (int i = 0; i < reps; i++) {
+        sq += (v[i] - r->mean) * (v[i] - r->mean);
+        r->min = (v[i] < r->min) ? v[i] : r->min;
+        r->max = (v[i] > r->max) ? v[i] : r->max;
+    }
+    r->stddev = (reps > 1) ? sqrt(sq / (reps - 1)) : 0.0;
+    double t = (reps - 1 > 30) ? 1.960 : (reps > 1) ? t95[reps - 2] : 0.0;
+    r->ci95 = (reps > 1) ? t * r->stddev / sqrt(reps) : 0.0;
+}
+
+void bench_json_begin(FILE *f, const char *suite) {
+    fprintf(f, "{\n  \"suite\": \"%s\",\n  \"pagesize\": %d,\n  \"nframes\": %d,\n  \"results\": [",
+            suite, VMEM_PAGESIZE, VMEM_NFRAMES);
+    first_result = true;
+}
+
+void bench_json_result(FILE *f, const struct bench_result *r) {
+    fprintf(f, "%s\n    { \"name\": \"%s\", \"params\": { %s }, \"unit\": \"%s\", \"warmup\": %d, \"reps\": %d, "
+            "\"mean\": %.4g, \"stddev\": %.4g, \"ci95\": %.4g, \"min\": %.4g, \"max\": %.4g }",
+            first_result ? "" : ",", r->name, r->params, r->unit, r->warmup, r->reps,
+            r->mean, r->stddev, r->ci95, r->min, r->max);
+    first_result = false;
+    fflush(f);
+}
+
+void bench_json_end(FILE *f) {
+    fprintf(f, "\n  ]\n}\n");
+    fflush(f);
+}
+
+// EOF
@@ -0,0 +1,86 @@
+/**
+ * @file bench.h
+ * @date Oct 2026
+ * @brief Header file of the measurement and reporting functions of the benchmarks
+ *        (make bench). A benchmark runs a measurement function BENCH_WARMUP times
+ *        without recording, then BENCH_REPS times. Mean, standard deviation and the
+ *        95% confidence interval of the mean (Student's t) are reported as JSON,
+ *        so the results of two builds can be compared by a script: a difference
+ *        larger than both confidence intervals is a regression.
+ *
+ *        The JSON document written to stdout has the form
+ *        { "suite": ..., "pagesize": ..., "nframes": ..., "results": [
+ *          { "name": ..., "params": { ... }, "unit": ..., "warmup": ..., "reps": ...,
+ *            "mean": ..., "stddev": ..., "ci95": ..., "min": ..., "max": ... }, ... ] }
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+
+#define BENCH_WARMUP   2        //!< Default number of unrecorded runs
+#define BENCH_REPS     10       //!< Default number of recorded runs
+#define BENCH_MAXREPS  1000     //!< Max. number of recorded runs
+
+/**
+ * Result of a benchmark
+ */
+struct bench_result {
+    char name[48];              //!< Name of the benchmark
+    char params[96];            //!< Parameters as JSON members, e.g. "\"policy\": \"CLOCK\""; may be empty
+    char unit[16];              //!< Unit of the values, e.g. "ns/op"
+    int warmup;                 //!< Number of unrecorded runs
+    int reps;                   //!< Number of recorded runs
+    double mean;                //!< Mean of the recorded runs
+    double stddev;              //!< Sample standard deviation
+    double ci95;                //!< Half width of the 95% confidence interval of the mean
+    double min;                 //!< Smallest value
+    double max;                 //!< Largest value
+};
+
+/**
+ * A measurement: it runs the benchmark once and returns the value in the unit of
+ * the result.
+ */
+typedef double (*bench_fn)(void *arg);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function scans the common parameters -warmup=<n> and -reps=<n>.
+ *
+ *  @param      arg A parameter of the program.
+ *
+ *  @return     1 if the parameter is a common one, otherwise 0.
+ ****************************************************************************************/
+int bench_param(const char *arg);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function runs a benchmark with the warmup and repetitions
+ *              selected by the common parameters.
+ *
+ *  @param      r Result, name, params and unit are set by the caller.
+ *  @param      fn Measurement function.
+ *  @param      arg Passed to fn.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void bench_measure(struct bench_result *r, bench_fn fn, void *arg);
+
+/**
+ *****************************************************************************************
+ *  @brief      These functions write the JSON document: the header, one result
+ *              (called once per result), and the end.
+ *
+ *  @param      f Output stream.
+ *  @param      suite Name of the benchmark program.
+ *  @param      r The result.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void bench_json_begin(FILE *f, const char *suite);
+void bench_json_result(FILE *f, const struct bench_result *r);
+void bench_json_end(FILE *f);
+
+#endif /* BENCH_H */
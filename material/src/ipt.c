@@ -0,0 +1,78 @@
+/**
+ * @file ipt.c
+ * @date Oct 2026
+ * @brief This module implements the hashed inverted page table.
+ *        mmanage inserts and removes entries, vmaccess only looks up pages.
+ */
+
+#include "ipt.h"
+#include "error.h"
+
+/**
+ *****************************************************************************************
+ *  @brief      This function computes the hash anchor of a page.
+ *
+ *  @param      asid Address space id of the page.
+ *  @param      page Number of the page.
+ *
+ *  @return     Index into ipt_hash.
+ ****************************************************************************************/
+static int ipt_hash_idx(int asid, int page) {
+    unsigned int h = (unsigned int) page * 2654435761u ^ (unsigned int) asid * 40503u;
+    return h % VMEM_IPT_HASHSIZE;
+}
+
+void ipt_init(struct vmem_struct *vmem) {
+    for(int i = 0; i < VMEM_IPT_HASHSIZE; i++) {
+        vmem->ipt_hash[i] = VOID_IDX;
+    }
+    for(int i = 0; i < VMEM_NFRAMES; i++) {
+        vmem->ipt[i].asid = VOID_IDX;
+        vmem->ipt[i].page = VOID_IDX;
+        vmem->ipt[i].flags = 0;
+        vmem->ipt[i].next = VOID_IDX;
+    }
+}
+
+int ipt_lookup(struct vmem_struct *vmem, int asid, int page) {
+    int frame = vmem->ipt_hash[ipt_hash_idx(asid, page)];
+    while((frame != VOID_IDX) && ((vmem->ipt[frame].page != page) || (vmem->ipt[frame].asid != asid))) {
+        frame = vmem->ipt[frame].next;
+    }
+    return frame;
+}
+
+void ipt_insert(struct vmem_struct *vmem, int asid, int page, int frame) {
+    TEST_AND_EXIT(vmem->ipt[frame].page != VOID_IDX, (stderr, "ipt_insert: frame %d in use\n", frame));
+    int idx = ipt_hash_idx(asid, page);
+    vmem->ipt[frame].asid = asid;
+    vmem->ipt[frame].page = page;
+    vmem->ipt[frame].flags = PTF_PRESENT;
+    vmem->ipt[frame].next = vmem->ipt_hash[idx];
+    vmem->ipt_hash[idx] = frame;
+}
+
+void ipt_remove(struct vmem_struct *vmem, int frame) {
+    struct ipt_entry *e = &vmem->ipt[frame];
+    TEST_AND_EXIT(e->page == VOID_IDX, (stderr, "ipt_remove: frame %d not in use\n", frame));
+    // unlink frame from its collision chain
+    int *link = &vmem->ipt_hash[ipt_hash_idx(e->asid, e->page)];
+    while(*link != frame) {
+        TEST_AND_EXIT(*link == VOID_IDX, (stderr, "ipt_remove: frame %d not found in chain\n", frame));
+        link = &vmem->ipt[*link].next;
+    }
+    *link = e->next;
+    e->asid = VOID_IDX;
+    e->page = VOID_IDX;
+    e->flags = 0;
+    e->next = VOID_IDX;
+}
+
+int ipt_lock_idx(const struct vmem_struct *vmem, int asid, int page) {
+    if (vmem->adm.pt_mode == VMEM_PT_INVERTED) {
+        return ipt_hash_idx(asid, page) % VMEM_NPTLOCKS;
+    }
+    return (asid * VMEM_NPAGES + page) % VMEM_NPTLOCKS;
+}
+
+// EOF
@@ -0,0 +1,78 @@
+/**
+ * @file ipt.h
+ * @date Oct 2026
+ * @brief Header file of the hashed inverted page table module.
+ *        The inverted page table has one entry per frame. It is indexed by a 
+ *        hash of (address space id, page number). Its size depends on 
+ *        VMEM_NFRAMES only.
+ */
+
+#ifndef IPT_H
+#define IPT_H
+
+#include "vmem.h"
+
+/**
+ *****************************************************************************************
+ *  @brief      This function initializes an empty inverted page table.
+ *
+ *  @param      vmem Virtual memory that contains the inverted page table.
+ *
+ *  @return     void 
+ ****************************************************************************************/
+void ipt_init(struct vmem_struct *vmem);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function looks up the frame that stores a page.
+ *
+ *  @param      vmem Virtual memory that contains the inverted page table.
+ *  @param      asid Address space id of the page.
+ *  @param      page Number of the page.
+ *
+ *  @return     Frame that stores the page. VOID_IDX if the page is not present.
+ ****************************************************************************************/
+int ipt_lookup(struct vmem_struct *vmem, int asid, int page);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function enters a page into an unused frame.
+ *              The flags of the entry will be set to PTF_PRESENT.
+ *
+ *  @param      vmem Virtual memory that contains the inverted page table.
+ *  @param      asid Address space id of the page.
+ *  @param      page Number of the page.
+ *  @param      frame Number of the frame that stores the page.
+ *
+ *  @return     void 
+ ****************************************************************************************/
+void ipt_insert(struct vmem_struct *vmem, int asid, int page, int frame);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function removes the page stored in a frame from the inverted 
+ *              page table.
+ *
+ *  @param      vmem Virtual memory that contains the inverted page table.
+ *  @param      frame Number of the frame that should become unused.
+ *
+ *  @return     void 
+ ****************************************************************************************/
+void ipt_remove(struct vmem_struct *vmem, int frame);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function returns the lock of the page table entry of a page, an
+ *              index into vmem->adm.lock. With the flat page table neighbouring pages 
+ *              have different locks. In the inverted page table all pages of a 
+ *              collision chain share a lock, since a lookup walks the chain.
+ *
+ *  @param      vmem Virtual memory that contains the page tables.
+ *  @param      asid Address space id of the page.
+ *  @param      page Number of the page.
+ *
+ *  @return     Index of the lock.
+ ****************************************************************************************/
+int ipt_lock_idx(const struct vmem_struct *vmem, int asid, int page);
+
+#endif /* IPT_H */
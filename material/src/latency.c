@@ -0,0 +1,87 @@
+/**
+ * @file latency.c
+ * @date Oct 2026
+ * @brief This module implements the latency histograms, see latency.h.
+ */
+
+#include <time.h>
+#include "latency.h"
+#include "error.h"
+
+#ifndef NO_LATENCY
+bool latency_on = false;
+#endif
+
+/**
+ *****************************************************************************************
+ *  @brief      These functions map a duration to its bucket and a bucket to the
+ *              largest duration it counts.
+ ****************************************************************************************/
+static int bucket_of(unsigned long long ns) {
+    if (ns < LATENCY_SUB) {
+        return ns;
+    }
+    int e = 63 - __builtin_clzll(ns);
+    return (e - LATENCY_SUB_BITS + 1) * LATENCY_SUB + ((ns >> (e - LATENCY_SUB_BITS)) & (LATENCY_SUB - 1));
+}
+
+static unsigned long long bucket_upper(int b) {
+    if (b < LATENCY_SUB) {
+        return b;
+    }
+    int shift = b / LATENCY_SUB - 1;
+    unsigned long long lower = (unsigned long long) (LATENCY_SUB + b % LATENCY_SUB) << shift;
+    return lower + (1ULL << shift) - 1;
+}
+
+void latency_enable(void) {
+#ifdef NO_LATENCY
+    TEST_AND_EXIT(true, (stderr, "latency_enable: built with -DNO_LATENCY\n"));
+#else
+    latency_on = true;
+#endif
+}
+
+long long latency_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void latency_record(struct latency_hist *h, long long ns) {
+    if (ns < 0) {
+        ns = 0;
+    }
+    __atomic_fetch_add(&h->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->sum, ns, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->buckets[bucket_of(ns)], 1, __ATOMIC_RELAXED);
+    long old = __atomic_load_n(&h->max, __ATOMIC_RELAXED);
+    while ((old < ns) && !__atomic_compare_exchange_n(&h->max, &old, ns, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+void latency_report_header(FILE *f) {
+    fprintf(f, "%-20s %9s %9s %9s %9s %9s %9s %9s\n", "Latency (us)", "count", "mean", "p50", "p90", "p99", "p99.9", "max");
+}
+
+void latency_report(FILE *f, const struct latency_hist *h) {
+    static const double pct[] = { 0.5, 0.9, 0.99, 0.999 };
+    double val[4];
+    if (h->count == 0) {
+        return;
+    }
+    long seen = 0;
+    int b = 0;
+    for (int i = 0; i < 4; i++) {
+        // smallest bucket with at least pct of the durations at or below it
+        long need = (long) (pct[i] * h->count + 0.999999);
+        while ((b < LATENCY_NBUCKETS - 1) && (seen + h->buckets[b] < need)) {
+            seen += h->buckets[b++];
+        }
+        unsigned long long upper = bucket_upper(b);
+        val[i] = ((upper < h->max) ? upper : h->max) / 1000.0;
+    }
+    fprintf(f, "%-20s %9ld %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f\n", h->name, h->count,
+            (double) h->sum / h->count / 1000.0, val[0], val[1], val[2], val[3], h->max / 1000.0);
+}
+
+// EOF
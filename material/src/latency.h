@@ -0,0 +1,98 @@
+/**
+ * @file latency.h
+ * @date Oct 2026
+ * @brief Header file of the latency histograms.
+ *        A histogram counts durations in logarithmic buckets like an HDR histogram:
+ *        each power of two is split into LATENCY_SUB buckets, so a bucket is at most
+ *        1/LATENCY_SUB of its value wide. Durations are measured in nanoseconds with
+ *        clock_gettime(CLOCK_MONOTONIC), which is comparable between processes.
+ *
+ *        Measuring is off until latency_enable is called. While it is off, LATENCY_BEGIN
+ *        and LATENCY_END cost a test of latency_on. Built with -DNO_LATENCY, latency_on
+ *        is the constant false and the compiler removes the measurements.
+ */
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#define LATENCY_SUB_BITS 3                                  //!< log2 of the number of buckets per power of two
+#define LATENCY_SUB      (1 << LATENCY_SUB_BITS)            //!< Number of buckets per power of two
+#define LATENCY_NBUCKETS ((64 - LATENCY_SUB_BITS) * LATENCY_SUB) //!< Number of buckets of a histogram
+
+/**
+ * Histogram of durations. Several threads may record into the same histogram.
+ */
+struct latency_hist {
+    const char *name;                   //!< Name printed by latency_report
+    long count;                         //!< Number of durations
+    long sum;                           //!< Sum of the durations in ns
+    long max;                           //!< Longest duration in ns
+    long buckets[LATENCY_NBUCKETS];     //!< Number of durations in each bucket
+};
+
+#ifdef NO_LATENCY
+#define latency_on false
+#else
+extern bool latency_on;                 //!< Measuring is enabled
+#endif
+
+/**
+ * Measure the duration of a block: LATENCY_BEGIN(t) before and LATENCY_END(hist, t)
+ * after it.
+ */
+#define LATENCY_BEGIN(t)      long long t = latency_on ? latency_now() : 0
+#define LATENCY_END(hist, t)  if (latency_on) latency_record(&(hist), latency_now() - (t))
+
+/**
+ *****************************************************************************************
+ *  @brief      This function enables measuring. It fails if the program has been
+ *              built with -DNO_LATENCY.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void latency_enable(void);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function returns the current time in nanoseconds.
+ ****************************************************************************************/
+long long latency_now(void);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function counts a duration.
+ *
+ *  @param      h The histogram.
+ *  @param      ns Duration in nanoseconds; negative durations count as 0.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void latency_record(struct latency_hist *h, long long ns);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function prints the header of the lines printed by latency_report.
+ *
+ *  @param      f Output stream.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void latency_report_header(FILE *f);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function prints a line with count, mean, percentiles and max. of a
+ *              histogram in microseconds. Empty histograms are not printed. A
+ *              percentile is the upper bound of its bucket.
+ *
+ *  @param      f Output stream.
+ *  @param      h The histogram.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void latency_report(FILE *f, const struct latency_hist *h);
+
+#endif /* LATENCY_H */
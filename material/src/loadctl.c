@@ -0,0 +1,128 @@
+/**
+ * @file loadctl.c
+ * @date Oct 2026
+ * @brief This module implements the load control of mmanage, see loadctl.h.
+ *        After each action the load control waits until every running client has
+ *        completed a new window, so the effect of the action can be measured.
+ *        A client stays suspended for at least hold[] rounds of windows. Since 
+ *        resuming a client often brings the thrashing back, hold[] is doubled on each 
+ *        suspension of the client (exponential backoff).
+ */
+
+#include "loadctl.h"
+#include "pff.h"
+#include "vmem.h"
+
+#define LOADCTL_MAXHOLD 64                  //!< Max. number of rounds a client stays suspended while others run
+
+static int nclients = 1;                        //!< Number of clients
+static struct pff_window pff;                   //!< Page fault frequency of the clients
+static bool fresh[VMEM_MAXCLIENTS];             //!< Window completed since the last action
+static bool suspended[VMEM_MAXCLIENTS];         //!< Client is suspended
+static int hold[VMEM_MAXCLIENTS];               //!< Min. number of rounds of the next suspension
+static int rounds[VMEM_MAXCLIENTS];             //!< Number of rounds since the client has been suspended
+static long suspensions = 0;                    //!< Number of suspend actions
+static long resumptions = 0;                    //!< Number of resume actions
+
+static bool running(int c) {
+    return !suspended[c] && pff_running(&pff, c);
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function marks the start of an action.
+ ****************************************************************************************/
+static void act(int c, bool suspend) {
+    suspended[c] = suspend;
+    pff.pff[c] = VOID_IDX;
+    rounds[c] = 0;
+    for (int i = 0; i < nclients; i++) {
+        fresh[i] = false;
+    }
+    if (suspend) {
+        hold[c] = (hold[c] < LOADCTL_MAXHOLD) ? 2 * hold[c] : LOADCTL_MAXHOLD;
+        suspensions++;
+    } else {
+        resumptions++;
+    }
+}
+
+void loadctl_init(int n) {
+    nclients = n;
+    pff_init(&pff, LOADCTL_WINDOW, n);
+    for (int c = 0; c < nclients; c++) {
+        hold[c] = 1;
+    }
+}
+
+int loadctl_update(struct msg m, int *client) {
+    int c = m.client;
+    int nrunning = 0, sum = 0;
+
+    if (!pff_update(&pff, m)) {
+        return LOADCTL_NONE;
+    }
+    fresh[c] = true;
+
+    // wait for a new window of every running client
+    for (int i = 0; i < nclients; i++) {
+        if (running(i)) {
+            if (!fresh[i] || (pff.pff[i] == VOID_IDX)) {
+                return LOADCTL_NONE;
+            }
+            nrunning++;
+            sum += pff.pff[i];
+        }
+    }
+    for (int i = 0; i < nclients; i++) {
+        rounds[i]++;
+        fresh[i] = false;
+    }
+    if ((nrunning >= 2) && (sum / nrunning > LOADCTL_HIGH)) {
+        // thrashing: suspend the running client with the lowest priority
+        for (*client = nclients - 1; !running(*client); (*client)--);
+        act(*client, true);
+        return LOADCTL_SUSPEND;
+    }
+    if ((nrunning > 0) && (sum / nrunning < LOADCTL_LOW)) {
+        for (*client = 0; (*client < nclients) && !(suspended[*client] && (rounds[*client] >= hold[*client])); (*client)++);
+        if (*client < nclients) {
+            act(*client, false);
+            return LOADCTL_RESUME;
+        }
+    }
+    return LOADCTL_NONE;
+}
+
+int loadctl_idle(void) {
+    for (int c = 0; c < nclients; c++) {
+        if (suspended[c]) {
+            act(c, false);
+            return c;
+        }
+    }
+    return VOID_IDX;
+}
+
+bool loadctl_suspended(int client) {
+    return suspended[client];
+}
+
+bool loadctl_active(void) {
+    for (int c = 0; c < nclients; c++) {
+        if (suspended[c]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void loadctl_report(FILE *f) {
+    fprintf(f, "Load control: %ld suspensions, %ld resumptions, faults per 1000 accesses:", suspensions, resumptions);
+    for (int c = 0; c < nclients; c++) {
+        fprintf(f, " %d", pff.pff[c]);
+    }
+    fprintf(f, "\n");
+}
+
+// EOF
@@ -0,0 +1,85 @@
+/**
+ * @file loadctl.h
+ * @date Oct 2026
+ * @brief Header file of the load control of mmanage.
+ *        The page fault frequency (PFF) of each client is measured over windows of
+ *        LOADCTL_WINDOW memory accesses (g_count, see pff.h). If the mean PFF of the running
+ *        clients exceeds LOADCTL_HIGH, the system thrashes: the running client with
+ *        the lowest priority (highest client number) will be suspended. If the mean
+ *        PFF drops below LOADCTL_LOW or no client is running any more, the suspended
+ *        client with the highest priority will be resumed.
+ *
+ *        This module only decides. mmanage suspends a client by holding back its
+ *        messages and releasing its frames.
+ */
+
+#ifndef LOADCTL_H
+#define LOADCTL_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "syncdataexchange.h"
+
+#define LOADCTL_WINDOW   200    //!< Memory accesses per measurement window of a client
+#define LOADCTL_HIGH     400    //!< Page faults per 1000 accesses that indicate thrashing
+#define LOADCTL_LOW      150    //!< Page faults per 1000 accesses below which clients are resumed
+#define LOADCTL_IDLE_MS  20     //!< Time without messages after which a client is resumed
+
+#define LOADCTL_NONE     0      //!< No action
+#define LOADCTL_SUSPEND  1      //!< Suspend a client
+#define LOADCTL_RESUME   2      //!< Resume a client
+
+/**
+ *****************************************************************************************
+ *  @brief      This function initializes the load control.
+ *
+ *  @param      n Number of clients.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void loadctl_init(int n);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function accounts a message received from a client and decides
+ *              whether a client must be suspended or resumed.
+ *
+ *  @param      m The message.
+ *  @param      client Set to the client to be suspended or resumed.
+ *
+ *  @return     One of LOADCTL_*
+ ****************************************************************************************/
+int loadctl_update(struct msg m, int *client);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function is called if no message has arrived for LOADCTL_IDLE_MS
+ *              while clients are suspended. The running clients are treated as finished.
+ *
+ *  @return     The client to be resumed; VOID_IDX: none.
+ ****************************************************************************************/
+int loadctl_idle(void);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function tells whether a client is suspended.
+ ****************************************************************************************/
+bool loadctl_suspended(int client);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function tells whether any client is suspended.
+ ****************************************************************************************/
+bool loadctl_active(void);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function prints the PFF of the clients and the number of actions.
+ *
+ *  @param      f Output file.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void loadctl_report(FILE *f);
+
+#endif /* LOADCTL_H */
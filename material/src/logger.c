@@ -7,6 +7,7 @@
  *        implementation of Wolfgang Fohl.
  */
 
+#include <stdarg.h>
 #include "logger.h"
 #include "error.h"
 
@@ -22,6 +23,11 @@ void close_logger(void) {
     fclose(logfile);
 }
 
+void rotate_logger(const char *name) {
+    close_logger();
+    TEST_AND_EXIT_ERRNO(rename(MMANAGE_LOGFNAME, name) == -1, "Error renaming logfile");
+}
+
 /* Do not change!  */
 void logger(struct logevent le) {
     fprintf(logfile, "Page fault %10d, Global count %10d:\n"
@@ -31,4 +37,16 @@ void logger(struct logevent le) {
     fflush(logfile);
 }
 
+void log_message(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    // workers of mmanage log concurrently, the line must not be torn apart
+    flockfile(logfile);
+    vfprintf(logfile, fmt, ap);
+    va_end(ap);
+    fputc('\n', logfile);
+    fflush(logfile);
+    funlockfile(logfile);
+}
+
 // EOF
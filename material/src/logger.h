@@ -38,6 +38,18 @@ void open_logger(void);
  ****************************************************************************************/
 void close_logger(void);
 
+/**
+ *****************************************************************************************
+ *  @brief      This function closes the current logfile and renames it, so the log of 
+ *              a finished run is kept when the next run starts. The logfile of the next 
+ *              run must be created with open_logger.
+ *
+ *  @param      name New name of the logfile.
+ *
+ *  @return     void 
+ ****************************************************************************************/
+void rotate_logger(const char *name);
+
 /**
  *****************************************************************************************
  *  @brief      This function writes a log entity to the logfile.
@@ -48,4 +60,15 @@ void close_logger(void);
  ****************************************************************************************/
 void logger(struct logevent le);
 
+/**
+ *****************************************************************************************
+ *  @brief      This function writes a line of text to the logfile. 
+ *              It is used for events other than page faults.
+ *
+ *  @param      fmt printf like format string followed by its arguments.
+ *
+ *  @return     void 
+ ****************************************************************************************/
+void log_message(const char *fmt, ...);
+
 #endif /* LOGGER_H */
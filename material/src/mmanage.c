@@ -15,23 +15,137 @@
  * This process starts shared memory, so
  * it has to be started prior to the vmaccess process.
  *
+ * With -clients=<n> it serves n applications (vmappl -client=<i>), each with its 
+ * own address space. All of them share the frames. Internally, pages are 
+ * identified by their global page number (see vmem.h).
+ *
+ * With -workers=<n> the main thread only receives messages and hands them to a 
+ * pool of n threads, so page faults of different clients are handled concurrently.
+ * A frame passes the states free -> loading -> resident -> evicting -> loading ...
+ * A thread claims a frame by a compare-and-swap of its state and owns it until it 
+ * is resident again, so frames need no lock. A page passes the states absent -> 
+ * loading -> resident -> evicting -> absent, protected by one of MMANAGE_NPAGELOCKS 
+ * page locks. Page table entries are protected by the page table locks in the 
+ * shared memory (lock_pt), the policy by policy_mutex unless it is concurrent (see 
+ * policy.h). Faults of different pages, including their pagefile I/O, run in 
+ * parallel. Lock order: policy_mutex, page lock, page table lock.
+ *
+ * With -shards=<n> frames and pages are partitioned into n shards by page hash 
+ * (see shard_policy in policy.h). Each shard has its own policy instance and lock,
+ * pagefile region with its own file handle, message queue and worker thread, so the 
+ * shards share no replacement state. Frames are moved from cold to hot shards when 
+ * the load is skewed; only then two shards are locked.
+ *
+ * With -loadctl mmanage detects thrashing from the page fault frequency of the 
+ * clients (see loadctl.h). A suspended client gets no ACK until it is resumed, and 
+ * its frames are released to the other clients.
+ *
+ * With -quota each client replaces within its own partition of the frames like 
+ * with -local, but the partitions follow the page fault frequency of the clients 
+ * (see quota.h).
+ *
+ * Clients give access hints with vmem_advise (CMD_ADVISE). Pages advised 
+ * DONTNEED are freed at once. The pages of a WILLNEED range are loaded after the 
+ * ACK, so the client continues meanwhile. A page fault on a page advised SEQUENTIAL 
+ * loads the next pages after the ACK (read-around) and frees the pages left behind 
+ * (drop-behind).
+ *
+ * With -pin=<n> clients may pin up to n pages with vmem_pin (CMD_PIN). Pinned pages
+ * stay resident until vmem_unpin; the policies pass over their frames (see 
+ * policy.h). Each client may pin its share of n pages. Pinned pages carry 
+ * PTF_PINNED in the page table.
+ *
+ * With -dirtyblock=<n> vmaccess keeps a dirty bitmap of n byte blocks per frame 
+ * (see vmem.h). A dirty victim is written back without its clean blocks.
+ *
+ * mmanage publishes its counters in the statistics segment (see vmstats.h), so 
+ * vmmon can watch it at runtime. 
+ *
+ * With -latency mmanage measures the stages of the page faults and prints their
+ * latency histograms at exit (see latency.h). Clients started with -latency stamp 
+ * their messages, so the IPC wakeup is measured as well.
+ *
+ * With -summary=<file> mmanage appends a record of the run to file at exit (see 
+ * summary.h): geometry, policy, seed and label given by -seed= and -label=, the 
+ * counters and the timing. Sweeps read these records instead of the logfile.
+ *
+ * A client started with vmappl -reset sends CMD_RESET before its run (see 
+ * vmem_reset). mmanage finishes the previous run: it appends the summary record and 
+ * renames the logfile to logfile_<seed>_<label>_<policy>_<pagesize>.txt. Then the 
+ * memory is reset to the state after startup: the pagefile is rewritten from an image
+ * of its initial contents, page tables and frames are emptied and the policy, which 
+ * the client may change, starts anew. So one mmanage serves a whole sweep of seeds.
+ *
+ * The shared memory is a POSIX segment named VMEM_SHMNAME (see shmseg.h), so the 
+ * clients may run in any directory. With -hugepages it is backed by huge pages.
+ *
  */
 
 #include <signal.h>
 #include <string.h>
-#include <sys/ipc.h>
-#include <sys/shm.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
 
 #include "mmanage.h"
+#include "ipt.h"
+#include "latency.h"
+#include "policy.h"
 #include "debug.h"
 #include "error.h"
 #include "pagefile.h"
+#include "swapslot.h"
 #include "logger.h"
+#include "loadctl.h"
+#include "quota.h"
 #include "syncdataexchange.h"
 #include "vmem.h"
+#include "vmstats.h"
+#include "summary.h"
+#include "shmseg.h"
 
 #define FLAG_INIT 0
 
+#define FRAME_FREE     0               //!< Frame has never been used
+#define FRAME_LOADING  1               //!< Frame has been claimed for a page that is being read
+#define FRAME_EVICTING 2               //!< Frame has been claimed; its old page is being written back
+#define FRAME_RESIDENT 3               //!< Frame stores a present page
+
+#define PAGE_ABSENT    0               //!< Page is stored in the pagefile only
+#define PAGE_LOADING   1               //!< A thread loads the page
+#define PAGE_RESIDENT  2               //!< Page is present in page_frame
+#define PAGE_EVICTING  3               //!< Page is being written back
+
+#define MMANAGE_NPAGELOCKS 64          //!< Number of page locks
+
+#define MMANAGE_MAXWORKERS 8           //!< Max. number of fault handling threads
+
+#define ADVISE_READAROUND  2                    //!< Pages loaded after a fault on a page advised SEQUENTIAL
+#define ADVISE_MAXPREFETCH (VMEM_NFRAMES / 2)   //!< Max. number of pages loaded for a WILLNEED advice
+
+#define PIN_MAXFRAMES      (VMEM_NFRAMES - 1)   //!< Max. cap of pinned frames; one frame must remain for page faults
+
+#define SNAPSHOT_MAGIC 0x56534E50      //!< Identifies a snapshot file ("VSNP")
+
+/**
+ * Header of a snapshot file. It is followed by frame_page[], the state of the 
+ * policy, the shared memory and the contents of all pages in the pagefile.
+ */
+struct snapshot_header {
+    int magic;          //!< SNAPSHOT_MAGIC
+    int pagesize;       //!< VMEM_PAGESIZE of the snapshot
+    int npages;         //!< VMEM_NPAGES of the snapshot
+    int nframes;        //!< VMEM_NFRAMES of the snapshot
+    int pt_mode;        //!< Page table organisation
+    int shm_size;       //!< Size of the shared memory image
+    int g_count;        //!< g_count of vmappl at the checkpoint
+    int pf_count;       //!< Page fault counter
+    char policy[16];    //!< Name of the page replacement policy
+    int policy_size;    //!< Size of the policy state
+};
+
 /*
  * Signatures of private / static functions
  */
@@ -54,10 +168,247 @@ static void fetch_page_from_disk(int page, int frame);
  *              it will be written back to disk. The page table will be updated.
  *
  *  @param      page Number of the page that should be removed
+ *  @param      frame Frame that stores the page. It has been claimed by the caller.
  * 
  *  @return     void 
  ****************************************************************************************/
-static void remove_page_from_memory(int page);
+static void remove_page_from_memory(int page, int frame);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function selects a victim frame with the page replacement policy.
+ *              Pinned frames are not taken, even if the policy ignores pinning. The 
+ *              frame is not claimed yet, another thread may claim it meanwhile.
+ *              The caller holds the policy lock (lock_policy).
+ *
+ *  @param      req_page  The page that will be stored in the victim frame.
+ *
+ *  @return     The victim frame.
+ ****************************************************************************************/
+static int select_victim(int req_page);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function claims a frame for a page: an unused frame, a frame moved 
+ *              from another partition or a victim. If the candidates are claimed by 
+ *              other threads, it waits for the next frame that becomes resident or 
+ *              unused. The caller holds the policy lock, it is released while waiting.
+ *
+ *  @param      req_page  The page that will be stored in the frame.
+ *  @param      removed   Set to the page stored in the frame, which the caller must 
+ *                        remove from memory; VOID_IDX: the frame was unused.
+ *
+ *  @return     The frame, in state FRAME_LOADING or FRAME_EVICTING.
+ ****************************************************************************************/
+static int claim_frame(int req_page, int *removed);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function claims a resident frame for eviction (FRAME_EVICTING) and 
+ *              marks its page PAGE_EVICTING. A pinned page is not claimed.
+ *
+ *  @param      frame The frame.
+ *  @param      page  The page the frame must store; VOID_IDX: any page.
+ *  @param      unpin Claim a pinned page as well and forget its pin.
+ *
+ *  @return     The page stored in the frame; VOID_IDX: the frame was not claimed.
+ ****************************************************************************************/
+static int claim_resident(int frame, int page, bool unpin);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function claims a frame that partition_move_frame is about to move: 
+ *              an unused frame for loading, otherwise its resident page for eviction.
+ *
+ *  @param      frame The frame.
+ *  @param      removed Set to the page stored in the frame (int *); VOID_IDX: none.
+ *
+ *  @return     true if the frame was claimed.
+ ****************************************************************************************/
+static bool claim_moved_frame(int frame, void *removed);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function changes the state of a frame unless another thread has 
+ *              changed it before.
+ *
+ *  @return     true if the frame was in state from.
+ ****************************************************************************************/
+static bool change_frame_state(int frame, int from, int to);
+
+/**
+ *****************************************************************************************
+ *  @brief      These functions let a thread wait until a frame has become resident or 
+ *              unused. frame_seen is read before looking for a frame, wait_for_frame 
+ *              returns as soon as a frame event has happened since.
+ ****************************************************************************************/
+static unsigned long frame_seen(void);
+static void frame_event(void);
+static void wait_for_frame(unsigned long seen);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function hands a message to the workers or processes and 
+ *              acknowledges it in the main thread.
+ *
+ *  @param      m The message.
+ *
+ *  @return     void 
+ ****************************************************************************************/
+static void dispatch_msg(struct msg m);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function suspends a client for load control. Its resident pages 
+ *              are removed from memory, so the frames become unused.
+ *
+ *  @param      client The client to be suspended.
+ *
+ *  @return     void 
+ ****************************************************************************************/
+static void suspend_client(int client);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function resumes a client suspended by load control. A message
+ *              held back will be dispatched.
+ *
+ *  @param      client The client to be resumed.
+ *
+ *  @return     void 
+ ****************************************************************************************/
+static void resume_client(int client);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function processes a message of a client.
+ *
+ *  @param      m The message.
+ *
+ *  @return     void 
+ ****************************************************************************************/
+static void handle_msg(struct msg m);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function does the work of a message that may run after the ACK:
+ *              prefetching for WILLNEED advice and read-around / drop-behind for 
+ *              faults on pages advised SEQUENTIAL.
+ *
+ *  @param      m The acknowledged message.
+ *
+ *  @return     void 
+ ****************************************************************************************/
+static void handle_msg_after_ack(struct msg m);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function records the access hint of CMD_ADVISE for a range of pages
+ *              and frees the frames of pages advised DONTNEED.
+ *
+ *  @param      m The CMD_ADVISE message.
+ *
+ *  @return     void 
+ ****************************************************************************************/
+static void advise_pages(struct msg m);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function removes the page stored in a resident frame from memory 
+ *              and makes the frame unused. The policy is told with on_release.
+ *
+ *  @param      frame The frame.
+ *  @param      page  The page the frame must store.
+ *  @param      unpin Release a pinned page as well (load control).
+ *
+ *  @return     false if the frame does not store the page anymore, is in transit or 
+ *              the page is pinned.
+ ****************************************************************************************/
+static bool release_frame(int frame, int page, bool unpin);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function returns the frame of a resident page.
+ *
+ *  @param      page Global page number.
+ *
+ *  @return     The frame; VOID_IDX: the page is not resident.
+ ****************************************************************************************/
+static int resident_frame(int page);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function sets the state of a page and wakes the threads waiting for 
+ *              it.
+ *
+ *  @param      page  Global page number.
+ *  @param      state PAGE_*
+ *  @param      frame Frame of a resident page; VOID_IDX otherwise.
+ *
+ *  @return     void 
+ ****************************************************************************************/
+static void set_page_state(int page, int state, int frame);
+
+/**
+ *****************************************************************************************
+ *  @brief      These functions lock and unlock the page lock of a page and wait for a 
+ *              change of the pages protected by it.
+ ****************************************************************************************/
+static void lock_page(int page);
+static void unlock_page(int page);
+static void wait_page(int page);
+
+/**
+ *****************************************************************************************
+ *  @brief      These functions pin and unpin the pages of a CMD_PIN / CMD_UNPIN message.
+ *              Pinning loads a page if necessary. Pages beyond the cap of the client 
+ *              are not pinned.
+ *
+ *  @param      m The message.
+ *
+ *  @return     void 
+ ****************************************************************************************/
+static void pin_pages(struct msg m);
+static void unpin_pages(struct msg m);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function tells whether a frame stores a pinned page.
+ *              The answer may be outdated, claim_resident checks the pin again.
+ ****************************************************************************************/
+static bool frame_pinned(int frame);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function forgets the pin of a page. The caller holds the page lock.
+ ****************************************************************************************/
+static void forget_pin(int page);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function tells whether a client may pin another page.
+ ****************************************************************************************/
+static bool pin_room(int client);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function counts a pin of a client. A page beyond the cap or the 
+ *              quota of the client, or a page that could not be loaded, is refused.
+ *
+ *  @param      client The client.
+ *  @param      resident The page to be pinned is resident.
+ *
+ *  @return     true if the page may be pinned.
+ ****************************************************************************************/
+static bool take_pin(int client, bool resident);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function is the main function of a fault handling thread. It takes 
+ *              messages from the queue filled by the main thread, processes and 
+ *              acknowledges them.
+ ****************************************************************************************/
+static void *worker(void *arg);
 
 /**
  *****************************************************************************************
@@ -71,17 +422,43 @@ static void vmem_init(void);
 
 /**
  *****************************************************************************************
- *  @brief      This function finds an unused frame. At the beginning all frames are 
- *              unused. A frame will never change it's state form used to unused.
+ *  @brief      This function fills the shared memory with its initial contents: 
+ *              administrative data, lock and empty page tables.
+ *
+ *  @return     void 
+ ****************************************************************************************/
+static void init_vmem_contents(void);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function returns the page table flags of a page stored in a frame.
+ *              It hides whether the flat or the inverted page table is in use.
+ *              The caller holds the page table lock of the page (lock_pt).
+ *
+ *  @param      page Global page number.
+ *  @param      frame Number of a used frame.
+ *
+ *  @return     Reference to the flags of the page; NULL if frame does not store page.
+ ****************************************************************************************/
+static int *page_flags(int page, int frame);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function finds an unused frame and claims it (FRAME_LOADING). At 
+ *              the beginning all frames are unused. A frame will never change it's 
+ *              state form used to unused, except when it is moved between shards or 
+ *              released by load control or vmem_advise.
  *
  *              Since the log files to be compared with contain the allocated frames, unused 
  *              frames must always be assigned the same way. Here, the frames are assigned 
  *              according to ascending frame number.
+ *
+ *  @param      part With local replacement or shards only this partition is searched.
  *            
  *  @return     idx of the unused frame with the smallest idx. 
  *              If all frames are in use, VOID_IDX will be returned.
  ****************************************************************************************/
-static int find_unused_frame();
+static int claim_unused_frame(int part);
 
 /**
  *****************************************************************************************
@@ -90,14 +467,20 @@ static int find_unused_frame();
  *              replacement algorithm will be called.
  *              Please take into account that allocate_page must update the page table 
  *              and log the page fault as well.
+ *              If the page has been loaded meanwhile (by a prefetch or a fault of 
+ *              another task), nothing is done.
  *
- *  @param      req_page  The page that must be allocated due to the page fault. 
+ *  @param      req_page  The global page number of the page that must be allocated 
+ *                        due to the page fault. 
 
  *  @param      g_count   Current g_count value
  *
+ *  @param      prefetch  The page is loaded due to an access hint, not due to a page 
+ *                        fault. It is not counted as a page fault.
+ *
  *  @return     void 
  ****************************************************************************************/
-static void allocate_page(const int req_page, const int g_count);
+static void allocate_page(const int req_page, const int g_count, const bool prefetch);
 
 /**
  *****************************************************************************************
@@ -122,60 +505,144 @@ static void dump_pt(void);
 
 /**
  *****************************************************************************************
- *  @brief      This function implements page replacement algorithm aging.
+ *  @brief      This function writes the complete state of the virtual memory to the 
+ *              snapshot file: page table, frame contents, state of the page replacement 
+ *              algorithms and the pagefile.
  *
- *  @param      page Number of page that should be loaded into memory.
+ *  @param      g_count Current g_count value of vmappl
+ *
+ *  @return     void 
+ ****************************************************************************************/
+static void save_snapshot(int g_count);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function restores the state of the virtual memory from the snapshot
+ *              file. The snapshot is mapped into memory and copied in a few large blocks.
  *
- *  @param      removedPage Number of page that has been selected for replacement.
- *              If an unused frame has selected, this parameter will not be
- *              modified.
+ *  @return     void 
+ ****************************************************************************************/
+static void restore_snapshot(void);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function prints the I/O counters of the pagefile to stderr.
  *
- *  @param      frame Number of frame that will be used to store the page.
+ *  @return     void 
+ ****************************************************************************************/
+static void dump_pagefile_stats(void);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function prints quota, resident set and page fault frequency of 
+ *              each client. SIGUSR2 prints it together with the page table.
  *
+ *  @return     void 
  ****************************************************************************************/
-static void find_remove_aging(int page, int * removedPage, int *frame);
- 
+static void dump_quotas(void);
+
+
+
 /**
  *****************************************************************************************
- *  @brief      This function does aging for aging page replacement algorithm.
- *              It will be called periodic based on g_count.
- *              This function must be used only when aging algorithm is activ.
- *              Otherwise update_age_reset_ref may interfere with other page replacement 
- *              alogrithms that base on PTF_REF bit.
+ *  @brief      This function passes the reference bits of all used frames to the 
+ *              policy and resets them. It will be called periodic based on g_count.
+ *              Reference bits are harvested only if the policy implements on_access.
+ *              Otherwise resetting the bits may interfere with policies that inspect 
+ *              PTF_REF directly.
  *
  *  @return     void
  ****************************************************************************************/
-static void update_age_reset_ref(void);
+static void harvest_references(void);
+
+/**
+ *****************************************************************************************
+ *  @brief      Functions of mmanage passed to the page replacement policy. 
+ *              See struct policy_env.
+ ****************************************************************************************/
+static int env_page_of_frame(const struct policy_env *env, int frame);
+static bool env_test_ref(const struct policy_env *env, int frame);
+static void env_clear_ref(const struct policy_env *env, int frame);
+static bool env_pinned(const struct policy_env *env, int frame);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function prints the number of messages and page faults of each 
+ *              client and the message throughput of mmanage to stderr.
+ *
+ *  @return     void 
+ ****************************************************************************************/
+static void dump_client_stats(void);
 
 /**
  *****************************************************************************************
- *  @brief      This function implements page replacement algorithm fifo.
+ *  @brief      This function appends the summary record of the run to summary_file.
  *
- *  @param      page Number of page that should be loaded into memory.
+ *  @return     void 
+ ****************************************************************************************/
+static void write_summary(void);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function finishes a run: it appends the summary record and renames 
+ *              the logfile to logfile_<seed>_<label>_<policy>_<pagesize>.txt. The 
+ *              logfile is closed afterwards.
  *
- *  @param      removedPage Number of page that has been selected for replacement.
- *              If an unused frame has selected, this parameter will not be 
- *              modified.
+ *  @return     void 
+ ****************************************************************************************/
+static void finish_run(void);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function starts a new run for CMD_RESET. The previous run is 
+ *              finished, if it has received messages. The pagefile, the shared memory, 
+ *              the frames, the policy and the counters are reset to the state after 
+ *              startup. Requires a single client without worker threads and load 
+ *              control, so no other message is being processed.
  *
- *  @param      frame Number of frame that will be used to store the page.
+ *  @param      m The CMD_RESET message: seed and policy (VMEM_POLICY_*) of the new run.
+ *                The client has written the label into the shared memory.
  *
+ *  @return     void 
  ****************************************************************************************/
-static void find_remove_fifo(int page, int * removedPage, int *frame);
+static void reset_session(struct msg m);
 
 /**
  *****************************************************************************************
- *  @brief      This function implements page replacement algorithm clock.
+ *  @brief      This function makes all frames unused and initializes the policy. The 
+ *              snapshot of -restore= is restored afterwards.
  *
- *  @param      page Number of page that should be loaded into memory.
+ *  @return     void 
+ ****************************************************************************************/
+static void init_frames(void);
+
+/**
+ *****************************************************************************************
+ *  @brief      These functions lock and unlock the page table entry of a page against 
+ *              accesses of the clients. Even a single client may access the memory while 
+ *              its page fault is handled, if it uses tasks (see vmtask.h).
  *
- *  @param      removedPage Number of page that has been selected for replacement.
- *              If an unused frame has selected, this parameter will not be 
- *              modified.
+ *  @param      page Global page number.
  *
- *  @param      frame Number of frame that will be used to store the page.
+ *  @return     void 
+ ****************************************************************************************/
+static void lock_pt(int page);
+static void unlock_pt(int page);
+
+/**
+ *****************************************************************************************
+ *  @brief      These functions lock and unlock the policy, unless it is concurrent.
+ ****************************************************************************************/
+static void lock_policy(void);
+static void unlock_policy(void);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function initializes the locks of the page tables in shared memory.
  *
+ *  @return     void 
  ****************************************************************************************/
-static void find_remove_clock(int page, int * removedPage, int *frame);
+static void init_vmem_lock(void);
 
 /**
  *****************************************************************************************
@@ -188,7 +655,8 @@ static void cleanup(void) ;
 /**
  *****************************************************************************************
  *  @brief      This function scans all parameters of the porgram.
- *              The corresponding global variables page_rep_algo will be set.
+ *              The corresponding global variables policy, pt_mode and the pagefile 
+ *              options will be set.
  * 
  *  @param      argc number of parameter 
  *
@@ -215,25 +683,136 @@ static void print_usage_info_and_exit(char *err_str, char * programName);
  */
 
 static int pf_count = 0;               //!< page fault counter
-static int shm_id = -1;                //!< shared memory id. Will be used to destroy shared memory when mmanage terminates
+static struct shmseg vmem_seg;         //!< shared memory segment. Will be destroyed when mmanage terminates
+static bool hugepages = false;         //!< back shared memory by huge pages according to parameters of mmanage
+static int pt_mode = VMEM_PT_FLAT;     //!< page table organisation according to parameters of mmanage
+static int pf_backend = PAGEFILE_BACKEND_STDIO; //!< pagefile I/O backend according to parameters of mmanage
+static int pf_cluster = 1;             //!< pagefile cluster size according to parameters of mmanage
+static int pf_layout = PAGEFILE_LAYOUT_FIXED; //!< pagefile layout according to parameters of mmanage
+static char *snapshot_file = NULL;     //!< snapshot file for CMD_CHECKPOINT according to parameters of mmanage
+static char *restore_file = NULL;      //!< snapshot file restored at startup according to parameters of mmanage
+static size_t shm_size = SHMSIZE(1);   //!< size of shared memory; depends on pt_mode and nclients
+static long refs_harvested = 0;        //!< number of reference bits passed to the policy
+static int nclients = 1;               //!< number of clients according to parameters of mmanage
+static bool local_repl = false;        //!< local instead of global replacement according to parameters of mmanage
+static long msgs_total = 0;            //!< number of messages received from all clients
+static long client_msgs[VMEM_MAXCLIENTS];   //!< number of messages received from each client
+static long client_faults[VMEM_MAXCLIENTS]; //!< number of page faults of each client
+static struct timespec first_msg, last_msg; //!< time of the first and the last message
+static int nworkers = 0;               //!< number of fault handling threads according to parameters of mmanage; 0: main thread
+static pthread_t workers[MMANAGE_MAXWORKERS];
+
+static int nshards = 0;                //!< number of shards according to parameters of mmanage; 0: not sharded
+static bool loadctl = false;           //!< load control according to parameters of mmanage
+static bool quotas = false;            //!< dynamic frame quotas according to parameters of mmanage
+static bool deferred_ack = false;      //!< messages are acknowledged with sendAckToClient
+static struct msg held_msg[VMEM_MAXCLIENTS]; //!< message of a suspended client
+static bool held[VMEM_MAXCLIENTS];     //!< held_msg is valid
+static unsigned char page_advice[VMEM_MAXPAGES]; //!< VMEM_ADV_NORMAL, _RANDOM or _SEQUENTIAL for each page
+static long pages_prefetched = 0;      //!< number of pages loaded due to WILLNEED or read-around
+static long pages_dropped = 0;         //!< number of pages freed by drop-behind
+static long pages_freed = 0;           //!< number of pages freed due to DONTNEED
+static int pin_cap = 0;                //!< max. number of pinned pages according to parameters of mmanage
+static int pin_quota = 0;              //!< max. number of pinned pages of a client
+static bool page_pinned[VMEM_MAXPAGES]; //!< page has been pinned with vmem_pin
+static int npinned = 0;                //!< number of pinned pages
+static int client_pinned[VMEM_MAXCLIENTS]; //!< number of pinned pages of each client
+static int pinned_peak = 0;            //!< max. number of pinned pages at a time
+static long pins = 0;                  //!< number of pages pinned
+static long pins_refused = 0;          //!< number of pages not pinned due to the cap
+static long pinned_passed = 0;         //!< number of times a policy passed over a pinned frame
+static int block_size = 0;             //!< size of the dirty blocks according to parameters of mmanage; 0: whole pages
+static struct vmstats *stats = NULL;   //!< statistics segment read by vmmon
+static __thread long env_steps = 0;    //!< number of calls of env_test_ref and env_pinned by this thread
+static char *summary_file = NULL;      //!< file the summary record is appended to according to parameters of mmanage
+static int run_seed = -1;              //!< seed of the application according to parameters of mmanage; -1: unknown
+static char *run_label = "";           //!< label of the run according to parameters of mmanage
+static int last_g_count = 0;           //!< largest g_count received
+static struct timespec start_time;     //!< time mmanage has been started or the run has been reset
+static bool session = false;           //!< CMD_RESET has been received, each run gets its own logfile
+static char session_label[VMEM_LABELSIZE]; //!< label of the current run sent with CMD_RESET
 
-static void (*pageRepAlgo) (int, int*, int*) = NULL; //!< selected page replacement algorithm according to parameters of mmanage
-
-/* information used for ageing replacement strategy. For each frame, which stores a valid page, 
- * the age and and the corresponding page will be stored.
+/**
+ * Latency of the stages of a page fault, measured with -latency
  */
+static struct latency_hist lat_wakeup = { "ipc wakeup" };       //!< client posts message .. mmanage receives it
+static struct latency_hist lat_victim = { "victim selection" }; //!< select_victim and claim_resident
+static struct latency_hist lat_writeback = { "write back" };    //!< remove_page_from_memory
+static struct latency_hist lat_fetch = { "fetch" };             //!< fetch_page_from_disk
+static struct latency_hist lat_log = { "logger" };              //!< logger
+static struct latency_hist lat_ack = { "ack" };                 //!< sendAck / sendAckToClient
+static struct latency_hist lat_service = { "fault service" };   //!< handle_msg .. ACK sent
 
-struct age {
-   unsigned char age;  //!< 8 bit counter for aging page replacement algorithm
-   int page;           //!< page belonging to this entry
- };
-
-struct age age[VMEM_NFRAMES];
+/**
+ * Messages handed from the main thread to the workers. Each client has at most one
+ * message outstanding, so VMEM_MAXCLIENTS entries suffice. Sharded, each worker has
+ * its own queue, otherwise all workers take messages from queues[0].
+ */
+struct msg_queue {
+    struct msg msg[VMEM_MAXCLIENTS];
+    int head;                          //!< Index of the oldest message
+    int n;                             //!< Number of messages
+    pthread_mutex_t mutex;
+    pthread_cond_t nonempty;
+};
+static struct msg_queue queues[MMANAGE_MAXWORKERS];
+
+static const struct policy_ops *policy = NULL; //!< selected page replacement policy according to parameters of mmanage
+static struct policy instance;          //!< running instance of policy, started by init_frames
+
+static const struct policy_env policy_env = { VMEM_NFRAMES, env_page_of_frame, env_test_ref, env_clear_ref, env_pinned };
+static pthread_mutex_t policy_mutex = PTHREAD_MUTEX_INITIALIZER; //!< Serializes the callbacks of a policy that is not concurrent
+static pthread_mutex_t quota_mutex = PTHREAD_MUTEX_INITIALIZER; //!< Serializes quota_update and quota_donor
+
+/* For each frame, which stores a valid page, the corresponding global page number will be stored.
+ * The replacement policies use it to walk the frames directly.
+ */
+static int frame_page[VMEM_NFRAMES];
+static int frame_state[VMEM_NFRAMES];   //!< FRAME_*, changed by compare-and-swap when a thread claims the frame
+static unsigned long frame_events = 0;  //!< Number of times a frame has become resident or unused
+static int frame_waiters = 0;           //!< Number of threads in wait_for_frame
+static pthread_mutex_t wait_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t frame_changed = PTHREAD_COND_INITIALIZER; //!< frame_events has been incremented
+
+static unsigned char page_state[VMEM_MAXPAGES]; //!< PAGE_*, protected by the page lock
+static int page_frame[VMEM_MAXPAGES];   //!< Frame of a resident page, protected by the page lock
+static pthread_mutex_t page_lock[MMANAGE_NPAGELOCKS]; //!< Page p is protected by page_lock[p % MMANAGE_NPAGELOCKS]
+static pthread_cond_t page_changed[MMANAGE_NPAGELOCKS]; //!< A page of the lock has become resident or absent
+static pthread_mutex_t pin_mutex = PTHREAD_MUTEX_INITIALIZER; //!< Protects the counters of pinned pages
+static pthread_mutex_t log_mutex = PTHREAD_MUTEX_INITIALIZER; //!< Protects pf_count, pages_prefetched and the order of the log
 
 static struct vmem_struct *vmem = NULL; //!< Reference to shared memory
 
 int main(int argc, char **argv) {
     struct sigaction sigact;
+
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+    // scan parameter 
+    policy = &policy_fifo;
+    scan_params(argc, argv);
+    if (local_repl) {
+        policy = local_policy(policy, nclients);
+    }
+    if (nshards > 0) {
+        policy = shard_policy(policy, nshards);
+        nworkers = nshards;
+    }
+
+    deferred_ack = (nworkers > 0) || loadctl;
+    if (loadctl) {
+        loadctl_init(nclients);
+    }
+    if (quotas) {
+        quota_init(nclients);
+    }
+    pin_quota = (pin_cap + nclients - 1) / nclients;
+
+    set_pagefile_address_spaces(nclients);
+    set_pagefile_regions((nshards > 0) ? nshards : 1);
+    select_pagefile_backend(pf_backend);
+    set_pagefile_cluster(pf_cluster);
+    select_pagefile_layout(pf_layout);
     init_pagefile(); // init page file
     open_logger();   // open logfile
 
@@ -244,16 +823,14 @@ int main(int argc, char **argv) {
     vmem_init();
     TEST_AND_EXIT_ERRNO(!vmem, "Error initialising vmem");
     PRINT_DEBUG((stderr, "vmem successfully created\n"));
+    stats = vmstats_create(nclients, policy->name);
 
-    // init aging info
-    for(int i = 0; i < VMEM_NFRAMES; i++) {
-       age[i].page = VOID_IDX;
-       age[i].age = 0;
+    // init frame info and policy
+    for (int i = 0; i < MMANAGE_NPAGELOCKS; i++) {
+        pthread_mutex_init(&page_lock[i], NULL);
+        pthread_cond_init(&page_changed[i], NULL);
     }
-
-    // scan parameter 
-    pageRepAlgo = find_remove_fifo;
-    scan_params(argc, argv);
+    init_frames();
 
     /* Setup signal handler */
     sigact.sa_handler = sighandler;
@@ -266,53 +843,569 @@ int main(int argc, char **argv) {
     TEST_AND_EXIT_ERRNO(sigaction(SIGINT, &sigact, NULL) == -1, "Error installing signal handler for INT");
     PRINT_DEBUG((stderr, "INT handler successfully installed\n"));
 
+    if (nworkers > 0) {
+        // signals must be handled by the main thread only
+        sigset_t all, old;
+        sigfillset(&all);
+        pthread_sigmask(SIG_BLOCK, &all, &old);
+        for (int i = 0; i < nworkers; i++) {
+            pthread_mutex_init(&queues[i].mutex, NULL);
+            pthread_cond_init(&queues[i].nonempty, NULL);
+        }
+        for (int i = 0; i < nworkers; i++) {
+            struct msg_queue *q = &queues[(nshards > 0) ? i : 0];
+            TEST_AND_EXIT(pthread_create(&workers[i], NULL, worker, q) != 0, (stderr, "Cannot create worker thread\n"));
+        }
+        pthread_sigmask(SIG_SETMASK, &old, NULL);
+    }
+
     // Server Loop, waiting for commands from vmapp
     while(1) {
-		struct msg m = waitForMsg();
-        switch(m.cmd){
-			case CMD_PAGEFAULT:
-				allocate_page(m.value, m.g_count);
-				break;
-			case CMD_TIME_INTER_VAL:
-                if (pageRepAlgo == find_remove_aging) {
-                   update_age_reset_ref();
+        struct msg m;
+        int client;
+        if (loadctl && loadctl_active()) {
+            if (!waitForNextMsgTimeout(LOADCTL_IDLE_MS, &m)) {
+                // the running clients have finished
+                client = loadctl_idle();
+                if (client != VOID_IDX) {
+                    resume_client(client);
                 }
-				break;
-			default:
-				TEST_AND_EXIT(true, (stderr, "Unexpected command received from vmapp\n"));
+                continue;
+            }
+        } else {
+            m = deferred_ack ? waitForNextMsg() : waitForMsg();
+        }
+        clock_gettime(CLOCK_MONOTONIC, &last_msg);
+        if (msgs_total++ == 0) {
+            first_msg = last_msg;
+        }
+        client_msgs[m.client]++;
+        if (m.g_count > last_g_count) {
+            last_g_count = m.g_count;
+        }
+        VMSTATS_ADD(stats->msgs, 1);
+        if (latency_on && m.stamp) {
+            latency_record(&lat_wakeup, latency_now() - m.stamp);
         }
-        sendAck();
+        if (quotas) {
+            pthread_mutex_lock(&quota_mutex);
+            quota_update(m);
+            pthread_mutex_unlock(&quota_mutex);
+        }
+        if (loadctl) {
+            switch (loadctl_update(m, &client)) {
+                case LOADCTL_SUSPEND:
+                    suspend_client(client);
+                    break;
+                case LOADCTL_RESUME:
+                    resume_client(client);
+                    break;
+            }
+            if (loadctl_suspended(m.client)) {
+                held_msg[m.client] = m;
+                held[m.client] = true;
+                continue;
+            }
+        }
+        dispatch_msg(m);
     }
     return 0;
 }
 
-void scan_params(int argc, char **argv) {
-    int i = 0;
+void dispatch_msg(struct msg m) {
+    if (nworkers > 0) {
+        // faults go to the queue of the shard of the page
+        struct msg_queue *q = &queues[0];
+        if ((nshards > 0) && (m.cmd == CMD_PAGEFAULT)) {
+            q = &queues[partition_of_page(m.client * VMEM_NPAGES + m.value)];
+        }
+        pthread_mutex_lock(&q->mutex);
+        q->msg[(q->head + q->n) % VMEM_MAXCLIENTS] = m;
+        q->n++;
+        vmstats_max(&stats->queue_max, VMSTATS_ADD(stats->queue_depth, 1) + 1);
+        pthread_cond_signal(&q->nonempty);
+        pthread_mutex_unlock(&q->mutex);
+    } else {
+        LATENCY_BEGIN(t_service);
+        handle_msg(m);
+        LATENCY_BEGIN(t_ack);
+        if (deferred_ack) {
+            sendAckToClient(m);
+        } else {
+            sendAck();
+        }
+        LATENCY_END(lat_ack, t_ack);
+        if (m.cmd == CMD_PAGEFAULT) {
+            LATENCY_END(lat_service, t_service);
+        }
+        VMSTATS_ADD(stats->acks, 1);
+        handle_msg_after_ack(m);
+    }
+}
+
+void suspend_client(int client) {
+    int released = 0;
+    for (int i = 0; i < VMEM_NFRAMES; i++) {
+        // frames in transit belong to a fault that is being handled; they stay
+        int page = __atomic_load_n(&frame_page[i], __ATOMIC_RELAXED);
+        if ((page != VOID_IDX) && (page / VMEM_NPAGES == client) && release_frame(i, page, true)) {
+            released++;
+        }
+    }
+    log_message("Load control: suspend client %d, %d frames released", client, released);
+}
+
+void resume_client(int client) {
+    log_message("Load control: resume client %d", client);
+    if (held[client]) {
+        held[client] = false;
+        dispatch_msg(held_msg[client]);
+    }
+}
+
+void handle_msg(struct msg m) {
+    switch(m.cmd){
+        case CMD_PAGEFAULT:
+            TEST_AND_EXIT((m.client >= nclients) || (m.value < 0) || (m.value >= VMEM_NPAGES), 
+                          (stderr, "Page fault of client %d out of range\n", m.client));
+            client_faults[m.client]++;
+            allocate_page(m.client * VMEM_NPAGES + m.value, m.g_count, false);
+            break;
+        case CMD_TIME_INTER_VAL:
+            lock_policy();
+            harvest_references();
+            if (policy->on_tick) {
+               policy->on_tick(instance.state, &policy_env);
+            }
+            unlock_policy();
+            clean_pagefile();
+            break;
+        case CMD_CHECKPOINT:
+            if (snapshot_file) {
+                save_snapshot(m.g_count);
+            }
+            break;
+        case CMD_ADVISE:
+            TEST_AND_EXIT((m.client >= nclients) || (m.value < 0) || (m.length < 1) || (m.value + m.length > VMEM_NPAGES)
+                          || (m.hint < VMEM_ADV_NORMAL) || (m.hint > VMEM_ADV_DONTNEED),
+                          (stderr, "Advice of client %d out of range\n", m.client));
+            advise_pages(m);
+            break;
+        case CMD_PIN:
+        case CMD_UNPIN:
+            TEST_AND_EXIT((m.client >= nclients) || (m.value < 0) || (m.length < 1) || (m.value + m.length > VMEM_NPAGES),
+                          (stderr, "Pin of client %d out of range\n", m.client));
+            if (m.cmd == CMD_PIN) {
+                pin_pages(m);
+            } else {
+                unpin_pages(m);
+            }
+            break;
+        case CMD_RESET:
+            TEST_AND_EXIT((nclients > 1) || (nworkers > 0) || loadctl,
+                          (stderr, "Reset requires a single client without -workers, -shards and -loadctl\n"));
+            TEST_AND_EXIT((m.hint < VMEM_POLICY_KEEP) || (m.hint > VMEM_POLICY_ADAPTIVE)
+                          || ((m.hint != VMEM_POLICY_KEEP) && (local_repl || restore_file)),
+                          (stderr, "Policy of reset unknown or fixed by -local, -quota or -restore\n"));
+            reset_session(m);
+            break;
+        default:
+            TEST_AND_EXIT(true, (stderr, "Unexpected command received from vmapp\n"));
+    }
+}
+
+void handle_msg_after_ack(struct msg m) {
+    int prefetch[ADVISE_MAXPREFETCH];
+    int n = 0;
+    if ((m.cmd == CMD_ADVISE) && (m.hint == VMEM_ADV_WILLNEED)) {
+        int first = m.client * VMEM_NPAGES + m.value;
+        for (int p = first; (p < first + m.length) && (n < ADVISE_MAXPREFETCH); p++) {
+            prefetch[n++] = p;
+        }
+    } else if (m.cmd == CMD_PAGEFAULT) {
+        int base = m.client * VMEM_NPAGES;
+        int page = base + m.value;
+        if (page_advice[page] == VMEM_ADV_SEQUENTIAL) {
+            // drop-behind: the pages before the predecessor will not be needed again
+            for (int p = page - 2; (p >= base) && (page_advice[p] == VMEM_ADV_SEQUENTIAL); p--) {
+                int frame = resident_frame(p);
+                if ((frame != VOID_IDX) && release_frame(frame, p, false)) {
+                    __atomic_fetch_add(&pages_dropped, 1, __ATOMIC_RELAXED);
+                }
+            }
+            // read-around
+            for (int p = page + 1; (p < base + VMEM_NPAGES) && (p <= page + ADVISE_READAROUND)
+                                   && (page_advice[p] == VMEM_ADV_SEQUENTIAL); p++) {
+                prefetch[n++] = p;
+            }
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        allocate_page(prefetch[i], m.g_count, true);
+    }
+}
+
+void advise_pages(struct msg m) {
+    int first = m.client * VMEM_NPAGES + m.value;
+    for (int p = first; p < first + m.length; p++) {
+        if (m.hint == VMEM_ADV_DONTNEED) {
+            // like munlock before madvise, pinned pages must be unpinned first
+            int frame = resident_frame(p);
+            if ((frame != VOID_IDX) && release_frame(frame, p, false)) {
+                __atomic_fetch_add(&pages_freed, 1, __ATOMIC_RELAXED);
+            }
+        } else if (m.hint != VMEM_ADV_WILLNEED) {
+            page_advice[p] = m.hint;
+        }
+    }
+}
+
+bool release_frame(int frame, int page, bool unpin) {
+    if (claim_resident(frame, page, unpin) == VOID_IDX) {
+        return false;
+    }
+    lock_policy();
+    if (policy->on_release) {
+        policy->on_release(instance.state, &policy_env, frame);
+    }
+    unlock_policy();
+    // a clean page is not written back, if the pagefile still holds its contents
+    remove_page_from_memory(page, frame);
+    __atomic_store_n(&frame_page[frame], VOID_IDX, __ATOMIC_RELAXED);
+    set_page_state(page, PAGE_ABSENT, VOID_IDX);
+    __atomic_store_n(&frame_state[frame], FRAME_FREE, __ATOMIC_RELEASE);
+    frame_event();
+    return true;
+}
+
+int resident_frame(int page) {
+    lock_page(page);
+    int frame = (page_state[page] == PAGE_RESIDENT) ? page_frame[page] : VOID_IDX;
+    unlock_page(page);
+    return frame;
+}
+
+void set_page_state(int page, int state, int frame) {
+    lock_page(page);
+    page_state[page] = state;
+    page_frame[page] = frame;
+    pthread_cond_broadcast(&page_changed[page % MMANAGE_NPAGELOCKS]);
+    unlock_page(page);
+}
+
+void lock_page(int page) {
+    pthread_mutex_lock(&page_lock[page % MMANAGE_NPAGELOCKS]);
+}
+
+void unlock_page(int page) {
+    pthread_mutex_unlock(&page_lock[page % MMANAGE_NPAGELOCKS]);
+}
+
+void wait_page(int page) {
+    pthread_cond_wait(&page_changed[page % MMANAGE_NPAGELOCKS], &page_lock[page % MMANAGE_NPAGELOCKS]);
+}
+
+void pin_pages(struct msg m) {
+    int first = m.client * VMEM_NPAGES + m.value;
+    for (int p = first; p < first + m.length; p++) {
+        // the page may be evicted again until it is pinned
+        lock_page(p);
+        while (!page_pinned[p] && (page_state[p] != PAGE_RESIDENT) && pin_room(m.client)) {
+            unlock_page(p);
+            allocate_page(p, m.g_count, false);
+            lock_page(p);
+        }
+        if (!page_pinned[p] && take_pin(m.client, page_state[p] == PAGE_RESIDENT)) {
+            page_pinned[p] = true;
+            lock_pt(p);
+            *page_flags(p, page_frame[p]) |= PTF_PINNED;
+            unlock_pt(p);
+        }
+        unlock_page(p);
+    }
+}
+
+void unpin_pages(struct msg m) {
+    int first = m.client * VMEM_NPAGES + m.value;
+    for (int p = first; p < first + m.length; p++) {
+        lock_page(p);
+        if (page_pinned[p]) {
+            forget_pin(p);
+            lock_pt(p);
+            *page_flags(p, page_frame[p]) &= ~PTF_PINNED;
+            unlock_pt(p);
+        }
+        unlock_page(p);
+    }
+}
+
+bool pin_room(int client) {
+    pthread_mutex_lock(&pin_mutex);
+    bool room = (client_pinned[client] < pin_quota) && (npinned < pin_cap);
+    pthread_mutex_unlock(&pin_mutex);
+    return room;
+}
+
+bool take_pin(int client, bool resident) {
+    pthread_mutex_lock(&pin_mutex);
+    bool ok = resident && (client_pinned[client] < pin_quota) && (npinned < pin_cap);
+    if (ok) {
+        client_pinned[client]++;
+        npinned++;
+        VMSTATS_SET(stats->pinned, npinned);
+        pins++;
+        if (npinned > pinned_peak) {
+            pinned_peak = npinned;
+        }
+    } else {
+        pins_refused++;
+    }
+    pthread_mutex_unlock(&pin_mutex);
+    return ok;
+}
+
+void forget_pin(int page) {
+    if (page_pinned[page]) {
+        page_pinned[page] = false;
+        pthread_mutex_lock(&pin_mutex);
+        client_pinned[page / VMEM_NPAGES]--;
+        npinned--;
+        VMSTATS_SET(stats->pinned, npinned);
+        pthread_mutex_unlock(&pin_mutex);
+    }
+}
+
+bool frame_pinned(int frame) {
+    if (__atomic_load_n(&frame_state[frame], __ATOMIC_ACQUIRE) != FRAME_RESIDENT) {
+        return false;
+    }
+    int page = __atomic_load_n(&frame_page[frame], __ATOMIC_RELAXED);
+    return (page != VOID_IDX) && page_pinned[page];
+}
+
+void *worker(void *arg) {
+    struct msg_queue *q = arg;
+    while (1) {
+        pthread_mutex_lock(&q->mutex);
+        while (q->n == 0) {
+            pthread_cond_wait(&q->nonempty, &q->mutex);
+        }
+        struct msg m = q->msg[q->head];
+        q->head = (q->head + 1) % VMEM_MAXCLIENTS;
+        q->n--;
+        VMSTATS_ADD(stats->queue_depth, -1);
+        pthread_mutex_unlock(&q->mutex);
+        LATENCY_BEGIN(t_service);
+        handle_msg(m);
+        LATENCY_BEGIN(t_ack);
+        sendAckToClient(m);
+        LATENCY_END(lat_ack, t_ack);
+        if (m.cmd == CMD_PAGEFAULT) {
+            LATENCY_END(lat_service, t_service);
+        }
+        VMSTATS_ADD(stats->acks, 1);
+        handle_msg_after_ack(m);
+    }
+    return NULL;
+}
+
+void scan_params(int argc, char **argv) {
+    int i = 0;
     bool param_ok = false;
     char * programName = argv[0];
+    const char *cluster_str = "-cluster=";
+    const char *clients_str = "-clients=";
+    const char *workers_str = "-workers=";
+    const char *shards_str = "-shards=";
+    const char *snapshot_str = "-snapshot=";
+    const char *restore_str = "-restore=";
+    const char *policy_str = "-policy=";
+    const char *pin_str = "-pin=";
+    const char *dirtyblock_str = "-dirtyblock=";
+    const char *summary_str = "-summary=";
+    const char *seed_str = "-seed=";
+    const char *label_str = "-label=";
 
     // scan all parameters (argv[0] points to program name)
-    if (argc > 2) print_usage_info_and_exit("Wrong number of parameters.\n", programName);
+    if (argc > 21) print_usage_info_and_exit("Wrong number of parameters.\n", programName);
 
     for (i = 1; i < argc; i++) {
         param_ok = false;
         if (0 == strcasecmp("-fifo", argv[i])) {
             // page replacement strategies fifo selected 
-            pageRepAlgo = find_remove_fifo;
+            policy = &policy_fifo;
             param_ok = true;
         }
         if (0 == strcasecmp("-clock", argv[i])) {
             // page replacement strategies clock selected 
-            pageRepAlgo = find_remove_clock;
+            policy = &policy_clock;
             param_ok = true;
         }
         if (0 == strcasecmp("-aging", argv[i])) {
             // page replacement strategies aging selected 
-            pageRepAlgo = find_remove_aging;
+            policy = &policy_aging;
+            param_ok = true;
+        }
+        if (0 == strcasecmp("-adaptive", argv[i])) {
+            // switch between fifo, clock and aging at runtime 
+            policy = &policy_adaptive;
+            param_ok = true;
+        }
+        if ((0 == strncasecmp(policy_str, argv[i], strlen(policy_str))) && (argv[i][strlen(policy_str)] != '\0')) {
+            // page replacement policy from shared object selected 
+            policy = load_policy(argv[i] + strlen(policy_str));
+            param_ok = true;
+        }
+        if (0 == strcasecmp("-ipt", argv[i])) {
+            // hashed inverted page table selected 
+            pt_mode = VMEM_PT_INVERTED;
+            param_ok = true;
+        }
+        if (0 == strcasecmp("-async", argv[i])) {
+            // asynchronous pagefile I/O via io_uring selected 
+            pf_backend = PAGEFILE_BACKEND_URING;
+            param_ok = true;
+        }
+        if (0 == strcasecmp("-async=threads", argv[i])) {
+            // asynchronous pagefile I/O via pwrite threads selected 
+            pf_backend = PAGEFILE_BACKEND_THREADS;
+            param_ok = true;
+        }
+        if (0 == strcasecmp("-logswap", argv[i])) {
+            // log-structured pagefile selected 
+            pf_layout = PAGEFILE_LAYOUT_LOG;
+            param_ok = true;
+        }
+        if ((0 == strncasecmp(snapshot_str, argv[i], strlen(snapshot_str))) && (argv[i][strlen(snapshot_str)] != '\0')) {
+            // write snapshot when vmappl sends CMD_CHECKPOINT 
+            snapshot_file = argv[i] + strlen(snapshot_str);
+            param_ok = true;
+        }
+        if ((0 == strncasecmp(restore_str, argv[i], strlen(restore_str))) && (argv[i][strlen(restore_str)] != '\0')) {
+            // start from snapshot 
+            restore_file = argv[i] + strlen(restore_str);
+            param_ok = true;
+        }
+        if (0 == strncasecmp(clients_str, argv[i], strlen(clients_str))) {
+            // number of clients selected 
+            if ((1 == sscanf(argv[i] + strlen(clients_str), "%d", &nclients)) 
+                && (nclients >= 1) && (nclients <= VMEM_MAXCLIENTS)) {
+                param_ok = true;
+            }
+        }
+        if (0 == strncasecmp(workers_str, argv[i], strlen(workers_str))) {
+            // number of fault handling threads selected 
+            if ((1 == sscanf(argv[i] + strlen(workers_str), "%d", &nworkers)) 
+                && (nworkers >= 1) && (nworkers <= MMANAGE_MAXWORKERS)) {
+                param_ok = true;
+            }
+        }
+        if (0 == strncasecmp(shards_str, argv[i], strlen(shards_str))) {
+            // number of shards selected 
+            if ((1 == sscanf(argv[i] + strlen(shards_str), "%d", &nshards)) 
+                && (nshards >= 1) && (nshards <= POLICY_MAXSHARDS) && (nshards <= MMANAGE_MAXWORKERS)) {
+                param_ok = true;
+            }
+        }
+        if (0 == strcasecmp("-loadctl", argv[i])) {
+            // suspend clients when the system thrashes 
+            loadctl = true;
+            param_ok = true;
+        }
+        if (0 == strcasecmp("-quota", argv[i])) {
+            // local replacement with frame quotas adjusted by page fault frequency 
+            local_repl = true;
+            quotas = true;
             param_ok = true;
         }
+        if (0 == strncasecmp(pin_str, argv[i], strlen(pin_str))) {
+            // cap of pinned pages selected 
+            if ((1 == sscanf(argv[i] + strlen(pin_str), "%d", &pin_cap)) 
+                && (pin_cap >= 0) && (pin_cap <= PIN_MAXFRAMES)) {
+                param_ok = true;
+            }
+        }
+        if (0 == strncasecmp(dirtyblock_str, argv[i], strlen(dirtyblock_str))) {
+            // size of the dirty blocks selected, a power of two 
+            if ((1 == sscanf(argv[i] + strlen(dirtyblock_str), "%d", &block_size)) 
+                && (block_size >= 1) && (block_size <= VMEM_PAGESIZE) && !(block_size & (block_size - 1))
+                && (VMEM_PAGESIZE / block_size <= VMEM_MAXBLOCKS)) {
+                param_ok = true;
+            }
+        }
+        if (0 == strncasecmp(summary_str, argv[i], strlen(summary_str))) {
+            // summary record of the run 
+            summary_file = argv[i] + strlen(summary_str);
+            param_ok = (summary_file[0] != '\0');
+        }
+        if (0 == strncasecmp(seed_str, argv[i], strlen(seed_str))) {
+            // seed of the application, recorded in the summary 
+            if (1 == sscanf(argv[i] + strlen(seed_str), "%d", &run_seed)) {
+                param_ok = true;
+            }
+        }
+        if (0 == strncasecmp(label_str, argv[i], strlen(label_str))) {
+            // label of the run, recorded in the summary 
+            run_label = argv[i] + strlen(label_str);
+            param_ok = true;
+        }
+        if (0 == strcasecmp("-latency", argv[i])) {
+            // latency histograms of the page fault stages 
+            latency_enable();
+            param_ok = true;
+        }
+        if (0 == strcasecmp("-hugepages", argv[i])) {
+            // shared memory backed by huge pages 
+            hugepages = true;
+            param_ok = true;
+        }
+        if (0 == strcasecmp("-local", argv[i])) {
+            // local replacement within fixed partitions of the frames selected 
+            local_repl = true;
+            param_ok = true;
+        }
+        if (0 == strncasecmp(cluster_str, argv[i], strlen(cluster_str))) {
+            // pagefile cluster size selected 
+            if ((1 == sscanf(argv[i] + strlen(cluster_str), "%d", &pf_cluster)) 
+                && (pf_cluster >= 1) && (pf_cluster <= PAGEFILE_MAXCLUSTER)) {
+                param_ok = true;
+            }
+        }
         if (!param_ok) print_usage_info_and_exit("Undefined parameter.\n", programName); // undefined parameter found
     } // for loop
+    if ((pf_cluster > 1) && (pf_backend != PAGEFILE_BACKEND_STDIO)) {
+        print_usage_info_and_exit("Clustering requires synchronous pagefile I/O.\n", programName);
+    }
+    if ((pf_layout == PAGEFILE_LAYOUT_LOG) && ((pf_cluster > 1) || (pf_backend != PAGEFILE_BACKEND_STDIO))) {
+        print_usage_info_and_exit("Log-structured pagefile requires synchronous pagefile I/O without clustering.\n", programName);
+    }
+    if ((pf_layout == PAGEFILE_LAYOUT_LOG) && (snapshot_file || restore_file)) {
+        print_usage_info_and_exit("Snapshots require the fixed pagefile layout.\n", programName);
+    }
+    if ((policy == &policy_adaptive) && (snapshot_file || restore_file)) {
+        print_usage_info_and_exit("Snapshots are not supported by the adaptive policy.\n", programName);
+    }
+    if ((nclients > 1) && (snapshot_file || restore_file)) {
+        print_usage_info_and_exit("Snapshots require a single client.\n", programName);
+    }
+    if (local_repl && (nclients > VMEM_NFRAMES)) {
+        print_usage_info_and_exit("Local replacement requires a frame per client.\n", programName);
+    }
+    if ((nshards > 0) && (local_repl || (nworkers > 0))) {
+        print_usage_info_and_exit("Sharding requires global replacement and no -workers.\n", programName);
+    }
+    if (loadctl && local_repl) {
+        print_usage_info_and_exit("Load control requires global replacement.\n", programName);
+    }
+    if ((nshards > 0) && ((pf_cluster > 1) || snapshot_file || restore_file)) {
+        print_usage_info_and_exit("Sharding does not support clustering and snapshots.\n", programName);
+    }
+    if ((pin_cap > 0) && (local_repl || (nshards > 0) || snapshot_file || restore_file)) {
+        print_usage_info_and_exit("Pinning requires global replacement without snapshots.\n", programName);
+    }
+    if ((block_size > 0) && ((pf_backend != PAGEFILE_BACKEND_STDIO) || (pf_layout != PAGEFILE_LAYOUT_FIXED) || (pf_cluster > 1))) {
+        print_usage_info_and_exit("Dirty blocks require synchronous pagefile I/O with the fixed layout and without clustering.\n", programName);
+    }
 }
 
 void print_usage_info_and_exit(char *err_str, char *programName) {
@@ -321,6 +1414,29 @@ void print_usage_info_and_exit(char *err_str, char *programName) {
 	fprintf(stderr, " -fifo     : Fifo page replacement algorithm.\n");
 	fprintf(stderr, " -clock    : Clock page replacement algorithm.\n");
 	fprintf(stderr, " -aging    : Aging page replacement algorithm.\n");
+	fprintf(stderr, " -adaptive : Switch between fifo, clock and aging based on shadow simulations.\n");
+	fprintf(stderr, " -policy=<file.so> : Page replacement policy loaded from shared object.\n");
+	fprintf(stderr, " -ipt      : Use hashed inverted page table instead of flat page table.\n");
+	fprintf(stderr, " -async    : Asynchronous pagefile I/O (io_uring, fallback to threads).\n");
+	fprintf(stderr, " -async=threads : Asynchronous pagefile I/O via pwrite threads.\n");
+	fprintf(stderr, " -cluster=<n> : Read-around and write clustering of n pages (1..%d).\n", PAGEFILE_MAXCLUSTER);
+	fprintf(stderr, " -logswap  : Log-structured pagefile with segment cleaner.\n");
+	fprintf(stderr, " -snapshot=<file> : Save state to file when vmappl requests a checkpoint.\n");
+	fprintf(stderr, " -restore=<file>  : Start from state saved in file (run vmappl with -restored).\n");
+	fprintf(stderr, " -clients=<n> : Serve n clients (1..%d) with separate address spaces.\n", VMEM_MAXCLIENTS);
+	fprintf(stderr, "                Page numbers in the logfile are global: client * %d + page.\n", VMEM_NPAGES);
+	fprintf(stderr, " -workers=<n> : Handle page faults of different clients with n threads (1..%d).\n", MMANAGE_MAXWORKERS);
+	fprintf(stderr, " -shards=<n> : Partition frames and pages into n shards (1..%d) with own workers.\n", POLICY_MAXSHARDS);
+	fprintf(stderr, " -loadctl  : Suspend low priority clients (high client numbers) while the system thrashes.\n");
+	fprintf(stderr, " -quota    : Like -local, the partitions grow and shrink with the page fault frequency.\n");
+	fprintf(stderr, " -pin=<n>  : Clients may pin up to n pages (0..%d) with vmem_pin, default 0.\n", PIN_MAXFRAMES);
+	fprintf(stderr, " -dirtyblock=<n> : Write back only the dirty blocks of n bytes (power of two up to %d).\n", VMEM_PAGESIZE);
+	fprintf(stderr, " -latency  : Print latency histograms of the page fault stages at exit.\n");
+	fprintf(stderr, " -summary=<file> : Append a record of the run to file at exit (.csv: CSV, otherwise JSON Lines).\n");
+	fprintf(stderr, " -seed=<n> : Seed of vmappl, recorded in the summary.\n");
+	fprintf(stderr, " -label=<text> : Label of the run, e.g. the sort algorithm, recorded in the summary.\n");
+	fprintf(stderr, " -hugepages : Back the shared memory by huge pages (hugetlbfs, otherwise transparent huge pages).\n");
+	fprintf(stderr, " -local    : Local replacement, each client replaces within its own partition of the frames.\n");
 	fprintf(stderr, " -pagesize=[8,16,32,64] : Page size.\n");
 	fflush(stderr);
 	exit(EXIT_FAILURE);
@@ -350,13 +1466,29 @@ void dump_pt(void) {
     fprintf(stderr, "Number of Frames = \t %d\n", VMEM_NFRAMES);
 
     fprintf(stderr, "======================================\n");
-    fprintf(stderr, "shm_id: \t %x\n", shm_id);
+    fprintf(stderr, "shm: \t\t %s, %zu bytes\n", vmem_seg.backing, vmem_seg.size);
     fprintf(stderr, "pf_count: \t %d\n", pf_count);
-    for(i = 0; i < VMEM_NPAGES; i++) {
-        fprintf(stderr,
-			"Page %5d, Flags %x, Frame %10d, age 0x%2X,  \n", i,
-            vmem->pt[i].flags, vmem->pt[i].frame, age[vmem->pt[i].frame].age);
+    fprintf(stderr, "policy: \t %s\n", policy->name);
+    if (pt_mode == VMEM_PT_INVERTED) {
+        for(i = 0; i < VMEM_NFRAMES; i++) {
+            fprintf(stderr,
+                "Frame %5d, Asid %3d, Page %10d, Flags %x, Next %5d\n", i,
+                vmem->ipt[i].asid, vmem->ipt[i].page, vmem->ipt[i].flags, vmem->ipt[i].next);
+        }
+    } else {
+        for(i = 0; i < nclients * VMEM_NPAGES; i++) {
+            fprintf(stderr,
+                "Page %5d, Flags %x, Frame %10d\n", i,
+                vmem->pt[i].flags, vmem->pt[i].frame);
+        }
+    }
+    if (policy->stats) {
+        policy->stats(instance.state, &policy_env, stderr);
     }
+    if (quotas) {
+        dump_quotas();
+    }
+    dump_pagefile_stats();
     fprintf(stderr,
             "\n\n======================================\n"
             "\tData Dump\n");
@@ -371,223 +1503,637 @@ void dump_pt(void) {
     }
 }
 
-/* Your code goes here... */
+void dump_client_stats(void) {
+    double secs = (last_msg.tv_sec - first_msg.tv_sec) + (last_msg.tv_nsec - first_msg.tv_nsec) / 1e9;
+    if (nclients > 1) {
+        for (int c = 0; c < nclients; c++) {
+            fprintf(stderr, "Client %d: %ld messages, %ld page faults\n", c, client_msgs[c], client_faults[c]);
+        }
+    }
+    fprintf(stderr, "Served %ld messages in %.3f s (%.0f messages/s)\n", msgs_total, secs, 
+            (secs > 0) ? msgs_total / secs : 0.0);
+}
+
+void dump_quotas(void) {
+    int resident[VMEM_MAXCLIENTS] = { 0 };
+    for (int i = 0; i < VMEM_NFRAMES; i++) {
+        if (frame_page[i] != VOID_IDX) {
+            resident[frame_page[i] / VMEM_NPAGES]++;
+        }
+    }
+    quota_report(stderr, resident);
+}
+
+void dump_pagefile_stats(void) {
+    struct pagefile_stats st;
+    get_pagefile_stats(&st);
+    fprintf(stderr, "Pagefile: %ld reads (%.1f bytes/op), %ld writes (%.1f bytes/op), %ld staging hits\n",
+            st.read_ops, st.read_ops ? (double) st.bytes_read / st.read_ops : 0.0,
+            st.write_ops, st.write_ops ? (double) st.bytes_written / st.write_ops : 0.0,
+            st.staging_hits);
+    if (block_size > 0) {
+        long full = st.bytes_written + st.bytes_saved;
+        fprintf(stderr, "Dirty blocks of %d bytes: %ld pages written partially, %ld bytes saved (%.1f%% of write-back)\n",
+                block_size, st.partial_writes, st.bytes_saved, full ? 100.0 * st.bytes_saved / full : 0.0);
+    }
+    if (pf_layout == PAGEFILE_LAYOUT_LOG) {
+        struct swapslot_stats sw;
+        get_swapslot_stats(&sw);
+        fprintf(stderr, "Swap slots: %ld appends, %ld segments cleaned, %ld slots copied, %ld slots reclaimed\n",
+                sw.appends, sw.segments_cleaned, sw.slots_copied, sw.slots_reclaimed);
+    }
+}
+
+void save_snapshot(int g_count) {
+    size_t policy_size = policy->size;
+    void *policy_state = instance.state;
+    struct snapshot_header h = { SNAPSHOT_MAGIC, VMEM_PAGESIZE, VMEM_NPAGES, VMEM_NFRAMES, pt_mode, 
+                                 (int) shm_size, g_count, pf_count, "", (int) policy_size };
+    strncpy(h.policy, policy->name, sizeof(h.policy) - 1);
+    FILE *f = fopen(snapshot_file, "w");
+    TEST_AND_EXIT_ERRNO(!f, "Error creating snapshot file");
+    TEST_AND_EXIT_ERRNO(fwrite(&h, sizeof(h), 1, f) != 1, "Error writing snapshot file");
+    TEST_AND_EXIT_ERRNO(fwrite(frame_page, sizeof(frame_page), 1, f) != 1, "Error writing snapshot file");
+    TEST_AND_EXIT_ERRNO(policy_size && (fwrite(policy_state, policy_size, 1, f) != 1), "Error writing snapshot file");
+    TEST_AND_EXIT_ERRNO(fwrite(vmem, shm_size, 1, f) != 1, "Error writing snapshot file");
+    save_pagefile_image(f);
+    TEST_AND_EXIT_ERRNO(fclose(f) == EOF, "Error writing snapshot file");
+    PRINT_DEBUG((stderr, "Snapshot written to %s at g_count %d\n", snapshot_file, g_count));
+}
+
+void restore_snapshot(void) {
+    struct stat st;
+    size_t policy_size = policy->size;
+    void *policy_state = instance.state;
+    int fd = open(restore_file, O_RDONLY);
+    TEST_AND_EXIT_ERRNO(fd == -1, "Error opening snapshot file");
+    TEST_AND_EXIT_ERRNO(fstat(fd, &st) == -1, "Error reading snapshot file");
+    size_t expected = sizeof(struct snapshot_header) + sizeof(frame_page) + policy_size + shm_size + VMEM_NPAGES * VMEM_PAGESIZE;
+    TEST_AND_EXIT(st.st_size != expected, (stderr, "Snapshot %s does not match this configuration\n", restore_file));
+    unsigned char *image = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    TEST_AND_EXIT_ERRNO(image == MAP_FAILED, "Error mapping snapshot file");
+    close(fd);
+
+    unsigned char *pos = image;
+    struct snapshot_header h;
+    memcpy(&h, pos, sizeof(h));
+    TEST_AND_EXIT((h.magic != SNAPSHOT_MAGIC) || (h.pagesize != VMEM_PAGESIZE) || (h.npages != VMEM_NPAGES) 
+                  || (h.nframes != VMEM_NFRAMES) || (h.pt_mode != pt_mode) || (h.shm_size != shm_size)
+                  || strncmp(h.policy, policy->name, sizeof(h.policy) - 1) || (h.policy_size != policy_size),
+                  (stderr, "Snapshot %s does not match this configuration\n", restore_file));
+    pos += sizeof(h);
+    memcpy(frame_page, pos, sizeof(frame_page));
+    pos += sizeof(frame_page);
+    for (int i = 0; i < VMEM_NFRAMES; i++) {
+        frame_state[i] = (frame_page[i] == VOID_IDX) ? FRAME_FREE : FRAME_RESIDENT;
+        if (frame_page[i] != VOID_IDX) {
+            page_state[frame_page[i]] = PAGE_RESIDENT;
+            page_frame[frame_page[i]] = i;
+        }
+    }
+    memcpy(policy_state, pos, policy_size);
+    pos += policy_size;
+    memcpy(vmem, pos, shm_size);
+    pos += shm_size;
+    init_vmem_lock();
+    restore_pagefile_image(pos);
+    munmap(image, st.st_size);
+
+    pf_count = h.pf_count;
+    vmem->adm.start_g_count = h.g_count;
+    // the snapshot may have been taken with other dirty blocks
+    vmem->adm.block_size = block_size;
+    for (int i = 0; i < VMEM_NFRAMES; i++) {
+        vmem->dirty_blocks[i] = ~0ULL;
+    }
+    PRINT_DEBUG((stderr, "Snapshot %s restored at g_count %d\n", restore_file, h.g_count));
+}
 
 void cleanup(void) {
-    shmctl(shm_id,IPC_RMID,NULL);
-    shmdt(vmem);
+    shmseg_destroy(&vmem_seg, VMEM_SHMNAME);
     destroySyncDataExchange();
     cleanup_pagefile();
-    close_logger();
+    vmstats_destroy();
+    dump_pagefile_stats();
+    dump_client_stats();
+    if (loadctl) {
+        loadctl_report(stderr);
+    }
+    if (quotas) {
+        dump_quotas();
+    }
+    if (pages_prefetched + pages_dropped + pages_freed > 0) {
+        fprintf(stderr, "Advice: %ld pages prefetched, %ld pages dropped behind, %ld pages freed\n", 
+                pages_prefetched, pages_dropped, pages_freed);
+    }
+    if (pin_cap > 0) {
+        fprintf(stderr, "Pinning: %ld pages pinned (max. %d at a time, cap %d), %ld refused, %d still pinned, "
+                "%ld times passed over by the policy\n", pins, pinned_peak, pin_cap, pins_refused, npinned, pinned_passed);
+    }
+    if (latency_on) {
+        latency_report_header(stderr);
+        latency_report(stderr, &lat_wakeup);
+        latency_report(stderr, &lat_victim);
+        latency_report(stderr, &lat_writeback);
+        latency_report(stderr, &lat_fetch);
+        latency_report(stderr, &lat_log);
+        latency_report(stderr, &lat_ack);
+        latency_report(stderr, &lat_service);
+    }
+    fprintf(stderr, "Policy %s: %ld reference bits harvested\n", policy->name, refs_harvested);
+    if (policy->stats) {
+        policy->stats(instance.state, &policy_env, stderr);
+    }
+    if (session) {
+        finish_run();
+    } else if (summary_file) {
+        write_summary();
+    }
+    policy_stop(&instance);
+    if (!session) {
+        close_logger();
+    }
 }
 
-void vmem_init(void) {
+void finish_run(void) {
+    char name[128];
+    if (summary_file) {
+        write_summary();
+    }
+    snprintf(name, sizeof(name), "./logfile_%d_%s%s%s_%d.txt", run_seed, run_label, 
+             run_label[0] ? "_" : "", policy->name, VMEM_PAGESIZE);
+    rotate_logger(name);
+}
 
-    /* Create System V shared memory */
-    key_t key = ftok(SHMKEY,SHMPROCID);
-    TEST_AND_EXIT_ERRNO(key == VOID_IDX, "ERROR BY CREATING SYSTEM V SHARED MEMORY");
+void reset_session(struct msg m) {
+    static const struct policy_ops *const policies[] = { NULL, &policy_fifo, &policy_clock, &policy_aging, &policy_adaptive };
 
-    /* We are creating the shm, so set the IPC_CREAT flag */
-    shm_id = shmget(key,SHMSIZE,0664 | IPC_CREAT);
-    TEST_AND_EXIT_ERRNO(shm_id == VOID_IDX, "ERROR BY CREATING THE SHM");
+    // the reset message belongs to the new run
+    msgs_total--;
+    client_msgs[m.client]--;
+    if (msgs_total > 0) {
+        finish_run();
+        open_logger();
+    }
+    session = true;
+    snprintf(session_label, sizeof(session_label), "%.*s", VMEM_LABELSIZE - 1, vmem->adm.label);
+    run_label = session_label;
+    run_seed = m.value;
+
+    policy_stop(&instance);
+    if (m.hint != VMEM_POLICY_KEEP) {
+        policy = policies[m.hint];
+    }
+    reset_pagefile();
+    // the client waits for the ACK and does not hold the lock
+    init_vmem_contents();
+    vmstats_reset(policy->name);
+    init_frames();
+
+    // counters of the new run
+    pf_count = 0;
+    msgs_total = 1;
+    memset(client_msgs, 0, sizeof(client_msgs));
+    memset(client_faults, 0, sizeof(client_faults));
+    client_msgs[m.client] = 1;
+    VMSTATS_ADD(stats->msgs, 1);
+    last_g_count = 0;
+    first_msg = last_msg;
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+    refs_harvested = 0;
+    pages_prefetched = pages_dropped = pages_freed = 0;
+    memset(page_advice, VMEM_ADV_NORMAL, sizeof(page_advice));
+    memset(page_pinned, 0, sizeof(page_pinned));
+    memset(client_pinned, 0, sizeof(client_pinned));
+    npinned = pinned_peak = 0;
+    pins = pins_refused = pinned_passed = 0;
+}
 
-    /* Attach shared memory to vmem (virtual memory) */
-    vmem = shmat(shm_id,NULL,0);
-    TEST_AND_EXIT_ERRNO(vmem == (struct vmen_struct*) VOID_IDX,"ERROR ATTACH SHARED MEMORY TO VMEM");
+void init_frames(void) {
+    for(int i = 0; i < VMEM_NFRAMES; i++) {
+       frame_page[i] = VOID_IDX;
+       frame_state[i] = FRAME_FREE;
+    }
+    for (int i = 0; i < VMEM_MAXPAGES; i++) {
+        page_state[i] = PAGE_ABSENT;
+        page_frame[i] = VOID_IDX;
+    }
+    policy_start(&instance, policy, &policy_env);
 
-    /* Fill with zeros */
-    memset(vmem, 0, SHMSIZE);
+    if (restore_file) {
+        restore_snapshot();
+        for (int i = 0; i < VMEM_NFRAMES; i++) {
+            VMSTATS_ADD(stats->resident, frame_page[i] != VOID_IDX);
+        }
+    }
+}
 
-    for(int i = 0; i<VMEM_NPAGES;i++){
-        vmem->pt[i].flags = FLAG_INIT;
-        vmem->pt[i].frame = VOID_IDX;
+void write_summary(void) {
+    struct timespec now;
+    struct pagefile_stats st;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    get_pagefile_stats(&st);
+    summary_int("time", (long) time(NULL));
+    summary_int("seed", run_seed);
+    summary_text("label", run_label);
+    summary_text("policy", policy->name);
+    summary_int("pagesize", VMEM_PAGESIZE);
+    summary_int("npages", VMEM_NPAGES);
+    summary_int("nframes", VMEM_NFRAMES);
+    summary_int("nclients", nclients);
+    summary_text("pagetable", (pt_mode == VMEM_PT_INVERTED) ? "inverted" : "flat");
+    summary_int("workers", nworkers);
+    summary_int("faults", pf_count);
+    summary_int("g_count", last_g_count);
+    summary_int("msgs", msgs_total);
+    summary_int("acks", VMSTATS_GET(stats->acks));
+    summary_int("prefetches", VMSTATS_GET(stats->prefetches));
+    summary_int("evictions", VMSTATS_GET(stats->evictions));
+    summary_int("writebacks", VMSTATS_GET(stats->writebacks));
+    summary_int("victims", VMSTATS_GET(stats->victims));
+    summary_int("scan_steps", VMSTATS_GET(stats->scan_steps));
+    summary_int("pf_reads", st.read_ops);
+    summary_int("pf_writes", st.write_ops);
+    summary_int("pf_bytes_read", st.bytes_read);
+    summary_int("pf_bytes_written", st.bytes_written);
+    summary_real("busy_s", (last_msg.tv_sec - first_msg.tv_sec) + (last_msg.tv_nsec - first_msg.tv_nsec) / 1e9);
+    summary_real("wall_s", (now.tv_sec - start_time.tv_sec) + (now.tv_nsec - start_time.tv_nsec) / 1e9);
+    summary_write(summary_file);
+}
+
+void vmem_init(void) {
+
+    /* The flat page tables will not be allocated in inverted page table mode */
+    shm_size = (pt_mode == VMEM_PT_INVERTED) ? SHMSIZE_INVERTED : SHMSIZE(nclients);
+
+    /* Create POSIX shared memory; the clients find it by name */
+    shmseg_create(&vmem_seg, VMEM_SHMNAME, shm_size, hugepages);
+    vmem = vmem_seg.addr;
 
+    init_vmem_contents();
 }
-    }
 
-int find_unused_frame() {
-    for(int i = 0; i < VMEM_NFRAMES; i++){
-        if(!(vmem->pt[i].flags & (PTF_REF + PTF_DIRTY))){
-            return i;
+void init_vmem_contents(void) {
+    /* Fill with zeros */
+    memset(vmem, 0, shm_size);
+    vmem->adm.pt_mode = pt_mode;
+    vmem->adm.nclients = nclients;
+    vmem->adm.block_size = block_size;
+    init_vmem_lock();
+
+    ipt_init(vmem);
+    if (pt_mode == VMEM_PT_FLAT) {
+        for(int i = 0; i < nclients * VMEM_NPAGES; i++){
+            vmem->pt[i].flags = FLAG_INIT;
+            vmem->pt[i].frame = VOID_IDX;
         }
     }
-    return VOID_IDX;
 }
 
+void init_vmem_lock(void) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    for (int i = 0; i < VMEM_NPTLOCKS; i++) {
+        TEST_AND_EXIT(pthread_mutex_init(&vmem->adm.lock[i], &attr) != 0, (stderr, "Error initialising vmem lock\n"));
+    }
+    pthread_mutexattr_destroy(&attr);
+}
 
-void allocate_page(const int req_page, const int g_count) {
-    int frame = VOID_IDX;
-    int removedPage = VOID_IDX;
-    struct logevent le;
+void lock_pt(int page) {
+    pthread_mutex_t *lock = &vmem->adm.lock[ipt_lock_idx(vmem, page / VMEM_NPAGES, page % VMEM_NPAGES)];
+    int rc = pthread_mutex_lock(lock);
+    if (rc == EOWNERDEAD) {
+        // a client died during an access; the page tables are consistent anyway
+        rc = pthread_mutex_consistent(lock);
+    }
+    TEST_AND_EXIT(rc != 0, (stderr, "lock_pt: pthread_mutex_lock failed\n"));
+}
 
-    /* Log action */
-    le.req_pageno = req_page;
-    le.replaced_page = removedPage;
-    le.alloc_frame = frame;
-    le.g_count = g_count; 
-    le.pf_count = pf_count;
-    logger(le);
+void unlock_pt(int page) {
+    pthread_mutex_unlock(&vmem->adm.lock[ipt_lock_idx(vmem, page / VMEM_NPAGES, page % VMEM_NPAGES)]);
 }
 
+void lock_policy(void) {
+    if (!policy->concurrent) {
+        pthread_mutex_lock(&policy_mutex);
+    }
+}
 
- //  @brief      This function fetchs a page from disk into memory. The page table
- //              will be updated.
- //  @param      page Number of the page that should be removed
- //  @param      frame Number of frame that should contain the page.
- //
- //  @return     void
+void unlock_policy(void) {
+    if (!policy->concurrent) {
+        pthread_mutex_unlock(&policy_mutex);
+    }
+}
 
+int *page_flags(int page, int frame) {
+    if (pt_mode == VMEM_PT_INVERTED) {
+        struct ipt_entry *e = &vmem->ipt[frame];
+        return ((e->asid == page / VMEM_NPAGES) && (e->page == page % VMEM_NPAGES)) ? &e->flags : NULL;
+    }
+    struct pt_entry *pte = &vmem->pt[page];
+    return ((pte->frame == frame) && (pte->flags & PTF_PRESENT)) ? &pte->flags : NULL;
+}
 
-void fetch_page_from_disk(int page, int frame){
-    unsigned char startAddress = vmem->mainMemory[frame * VMEM_PAGESIZE];
-    fetch_page_from_pagefile(page, &startAddress);
-    vmem->mainMemory[page] = frame;
-    vmem->pt[page].flags |= PTF_PRESENT;
+int env_page_of_frame(const struct policy_env *env, int frame) {
+    return __atomic_load_n(&frame_page[frame], __ATOMIC_RELAXED);
 }
 
+bool env_test_ref(const struct policy_env *env, int frame) {
+    env_steps++;
+    if (__atomic_load_n(&frame_state[frame], __ATOMIC_ACQUIRE) != FRAME_RESIDENT) {
+        return false;
+    }
+    // the frame may be claimed by another thread meanwhile, page_flags checks the page
+    int page = __atomic_load_n(&frame_page[frame], __ATOMIC_RELAXED);
+    if (page == VOID_IDX) {
+        return false;
+    }
+    lock_pt(page);
+    int *flags = page_flags(page, frame);
+    bool ref = flags && (*flags & PTF_REF);
+    unlock_pt(page);
+    return ref;
+}
 
-/**
- *****************************************************************************************
- *  @brief      This function removes a page from main memory. If the page was modified,
- *              it will be written back to disk.f The page table will be updated.
- *
- *  @param      page Number of the page that should be removed
- *
- *  @return     void
- ****************************************************************************************/
-void remove_page_from_memory(int page) {
-    unsigned char startAddress = vmem->mainMemory[page * VMEM_PAGESIZE];
-    //page soll von der main memory entfernt werden
-    if (vmem->pt[page].flags & (PTF_DIRTY + PTF_PRESENT)) {
-        store_page_to_pagefile(page, &startAddress);
+bool env_pinned(const struct policy_env *env, int frame) {
+    env_steps++;
+    // the policy would have chosen this frame
+    if (frame_pinned(frame)) {
+        __atomic_fetch_add(&pinned_passed, 1, __ATOMIC_RELAXED);
+        return true;
     }
-    // 111 ^ 001 = 110, eventuell ohne xor und auf 0 setzen.
-    vmem->pt[page].flags ^= PTF_PRESENT;
-    vmem->pt[page].frame = VOID_IDX;
+    return false;
 }
 
-/**
- *****************************************************************************************
- *  @brief      This function implements page replacement algorithm fifo.
- *
- *  @param      page Number of page that should be loaded into memory.
- *
- *  @param      removedPage Number of page that has been selected for replacement.
- *              If an unused frame has selected, this parameter will not be
- *              modified.
- *
- *  @param      frame Number of frame that will be used to store the page.
- *
- ****************************************************************************************/
-void find_remove_fifo(int page, int* removedPage, int *frame) {
-    static int first_index = 0;
-    *frame = first_index;
-    for (int i = 0; i < VMEM_NPAGES; i++) {
-        if (vmem->pt[i].frame == *frame) {
-            *removedPage = i;
-            break;
+void env_clear_ref(const struct policy_env *env, int frame) {
+    if (__atomic_load_n(&frame_state[frame], __ATOMIC_ACQUIRE) != FRAME_RESIDENT) {
+        return;
+    }
+    int page = __atomic_load_n(&frame_page[frame], __ATOMIC_RELAXED);
+    if (page == VOID_IDX) {
+        return;
+    }
+    lock_pt(page);
+    int *flags = page_flags(page, frame);
+    if (flags) {
+        *flags &= ~PTF_REF;
+    }
+    unlock_pt(page);
+}
+
+void harvest_references(void) {
+    if (!policy->on_access) {
+        return;
+    }
+    for (int i = 0; i < VMEM_NFRAMES; i++) {
+        if (env_test_ref(&policy_env, i)) {
+            policy->on_access(instance.state, &policy_env, i);
+            env_clear_ref(&policy_env, i);
+            __atomic_fetch_add(&refs_harvested, 1, __ATOMIC_RELAXED);
         }
-        remove_page_from_memory(*removedPage);
-        first_index = (first_index + 1) % (VMEM_NFRAMES);
     }
 }
 
+bool change_frame_state(int frame, int from, int to) {
+    return __atomic_compare_exchange_n(&frame_state[frame], &from, to, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
 
+unsigned long frame_seen(void) {
+    return __atomic_load_n(&frame_events, __ATOMIC_SEQ_CST);
+}
 
-/**
- *****************************************************************************************
- *  @brief      This function implements page replacement algorithm clock.
- *
- *  @param      page Number of page that should be loaded into memory.
- *
- *  @param      removedPage Number of page that has been selected for replacement.
- *              If an unused frame has selected, this parameter will not be
- *              modified.
- *
- *  @param      frame Number of frame that will be used to store the page.
- *
- ****************************************************************************************/
+void frame_event(void) {
+    __atomic_fetch_add(&frame_events, 1, __ATOMIC_SEQ_CST);
+    // a waiter registers before it checks frame_events, so it is not missed
+    if (__atomic_load_n(&frame_waiters, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&wait_mutex);
+        pthread_cond_broadcast(&frame_changed);
+        pthread_mutex_unlock(&wait_mutex);
+    }
+}
 
-static void find_remove_clock(int page, int *removedPage, int *frame){
-    static int first_frame = 0; // index fuer das array Frame
-    *frame = first_frame; // laufvariable
-    while(true){
-        if(*frame < VMEM_NFRAMES) {
-            //001 & 110 = 000  111 & 001 = 001   4b = 0100
-            if (!(vmem->pt[*frame].flags & PTF_REF)) {
-                remove_page_from_memory(*removedPage);
-                //neue seite mit R==1
-                vmem->pt[*removedPage].frame = page;
-                vmem->pt[page].flags |= PTF_REF + PTF_DIRTY;
-                *frame = page;
-                break;
-            } else {                                  //wenn PTF_REF != 1
-                vmem->pt[page].flags ^= PTF_REF;
-                *frame = page;
-                break;
-            }
-        }
-        first_frame = (first_frame + 1) % (VMEM_NFRAMES);
+void wait_for_frame(unsigned long seen) {
+    pthread_mutex_lock(&wait_mutex);
+    __atomic_fetch_add(&frame_waiters, 1, __ATOMIC_SEQ_CST);
+    while (frame_seen() == seen) {
+        pthread_cond_wait(&frame_changed, &wait_mutex);
     }
+    __atomic_fetch_add(&frame_waiters, -1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&wait_mutex);
 }
 
-/**
- *
-static void find_remove_clock(int page, int* removedPage, int *frame) {
-    static int currentFrame = 0;
-    while (true) {
-        for (int i = 0; i < VMEM_NPAGES; i++) {
-            if (vmem->pt[i].frame == currentFrame) {
-                //status of reference-flag
-                int rFlag = vmem->pt[i].flags & PTF_REF;
-                //check reference-flag
-                if (rFlag == PTF_REF) {
-                    //reference-flag = 0
-                    vmem->pt[i].flags &= (PTF_DIRTY + PTF_PRESENT);
-                    currentFrame = (currentFrame + 1) % VMEM_NFRAMES;
-                    break;
-                } else {
-                    //remove page and set variables
-                    *removedPage = i;
-                    *frame = currentFrame;
-                    remove_page_from_memory(*removedPage);
-                    vmem->pt[page].flags |= PTF_REF;
-                    currentFrame = (currentFrame + 1) % VMEM_NFRAMES;
-                    return;
-                }
-            }
+int claim_unused_frame(int part) {
+    int list[VMEM_NFRAMES];
+    const int *frames = NULL;
+    int count = VMEM_NFRAMES;
+    if (local_repl || (nshards > 0)) {
+        count = partition_frames(part, list);
+        frames = list;
+    }
+    // frames are handed out in ascending order and become unused again only by load control and advice
+    for (int i = 0; i < count; i++) {
+        int frame = frames ? frames[i] : i;
+        if ((__atomic_load_n(&frame_state[frame], __ATOMIC_RELAXED) == FRAME_FREE) 
+            && change_frame_state(frame, FRAME_FREE, FRAME_LOADING)) {
+            return frame;
         }
     }
-}*/
-
-
-/* struct age {
-   unsigned char age;  //!< 8 bit counter for aging page replacement algorithm
-   int page;           //!< page belonging to this entry
- };
-struct age age[VMEM_NFRAMES];
- */
+    return VOID_IDX;
+}
 
-static void find_remove_aging(int page, int * removedPage, int *frame){
+int claim_resident(int frame, int page, bool unpin) {
+    if (!change_frame_state(frame, FRAME_RESIDENT, FRAME_EVICTING)) {
+        return VOID_IDX;
+    }
+    // the frame belongs to this thread now, frame_page does not change
+    int victim = frame_page[frame];
+    lock_page(victim);
+    bool keep = ((page != VOID_IDX) && (victim != page)) || (page_pinned[victim] && !unpin);
+    if (!keep) {
+        // a suspended client loses its pins
+        forget_pin(victim);
+        page_state[victim] = PAGE_EVICTING;
+    }
+    unlock_page(victim);
+    if (keep) {
+        __atomic_store_n(&frame_state[frame], FRAME_RESIDENT, __ATOMIC_RELEASE);
+        frame_event();
+        return VOID_IDX;
+    }
+    return victim;
+}
 
+bool claim_moved_frame(int frame, void *removed) {
+    *(int *) removed = VOID_IDX;
+    if (change_frame_state(frame, FRAME_FREE, FRAME_LOADING)) {
+        return true;
+    }
+    *(int *) removed = claim_resident(frame, VOID_IDX, false);
+    return *(int *) removed != VOID_IDX;
+}
 
+int select_victim(int req_page) {
+    long steps = env_steps;
+    int frame = policy->choose_victim(instance.state, &policy_env, req_page);
+    // a policy that ignores pinning gets further chances, then an unpinned frame is taken
+    for (int i = 0; frame_pinned(frame) && (i < VMEM_NFRAMES); i++) {
+        frame = policy->choose_victim(instance.state, &policy_env, req_page);
+    }
+    for (int i = 0; frame_pinned(frame) && (i < VMEM_NFRAMES); i++) {
+        frame = i;
+    }
+    VMSTATS_ADD(stats->victims, 1);
+    VMSTATS_ADD(stats->scan_steps, env_steps - steps);
+    vmstats_max(&stats->scan_max, env_steps - steps);
+    return frame;
 }
 
+int claim_frame(int req_page, int *removed) {
+    int part = (local_repl || (nshards > 0)) ? partition_of_page(req_page) : 0;
+    while (1) {
+        unsigned long seen = frame_seen();
+        *removed = VOID_IDX;
+        int frame = claim_unused_frame(part);
+        if (frame != VOID_IDX) {
+            return frame;
+        }
+        int donor = VOID_IDX;
+        if (nshards > 0) {
+            donor = partition_donor(part);
+        }
+        if (quotas) {
+            pthread_mutex_lock(&quota_mutex);
+            donor = quota_donor(part);
+            pthread_mutex_unlock(&quota_mutex);
+            if (donor != VOID_IDX) {
+                log_message("Quota: client %d takes a frame of client %d", part, donor);
+            }
+        }
+        if (donor != VOID_IDX) {
+            // skewed load or high fault rate: take a frame from a cold partition
+            frame = partition_move_frame(donor, part, claim_moved_frame, removed);
+            if (frame != VOID_IDX) {
+                return frame;
+            }
+        } else {
+            LATENCY_BEGIN(t_victim);
+            frame = select_victim(req_page);
+            *removed = claim_resident(frame, VOID_IDX, false);
+            LATENCY_END(lat_victim, t_victim);
+            if (*removed != VOID_IDX) {
+                return frame;
+            }
+        }
+        // the frame is being loaded or evicted by another thread
+        unlock_policy();
+        wait_for_frame(seen);
+        lock_policy();
+    }
+}
 
-/**
- *****************************************************************************************
- *  @brief      This function does aging for aging page replacement algorithm.
- *              It will be called periodic based on g_count.
- *              This function must be used only when aging algorithm is activ.
- *              Otherwise update_age_reset_ref may interfere with other page replacement
- *              alogrithms that base on PTF_REF bit.
- *
- *  @return     void
- ****************************************************************************************/
+void allocate_page(const int req_page, const int g_count, const bool prefetch) {
+    int removedPage = VOID_IDX;
+    struct logevent le;
 
-static void update_age_reset_ref(void){
+    // the page may still be written back after another fault evicted it, 
+    // or it may be loaded by a prefetch
+    lock_page(req_page);
+    while ((page_state[req_page] == PAGE_LOADING) || (page_state[req_page] == PAGE_EVICTING)) {
+        wait_page(req_page);
+    }
+    if (page_state[req_page] == PAGE_RESIDENT) {
+        unlock_page(req_page);
+        return;
+    }
+    page_state[req_page] = PAGE_LOADING;
+    unlock_page(req_page);
+
+    /* Use an unused frame or free one with the selected page replacement policy */
+    lock_policy();
+    int frame = claim_frame(req_page, &removedPage);
+    __atomic_store_n(&frame_page[frame], req_page, __ATOMIC_RELAXED);
+    if (policy->on_fault) {
+        policy->on_fault(instance.state, &policy_env, req_page, frame);
+    }
+    unlock_policy();
+
+    /* The frame belongs to this thread until it is resident */
+    if (removedPage != VOID_IDX) {
+        LATENCY_BEGIN(t_writeback);
+        remove_page_from_memory(removedPage, frame);
+        LATENCY_END(lat_writeback, t_writeback);
+        set_page_state(removedPage, PAGE_ABSENT, VOID_IDX);
+        __atomic_store_n(&frame_state[frame], FRAME_LOADING, __ATOMIC_RELAXED);
+    }
+    LATENCY_BEGIN(t_fetch);
+    fetch_page_from_disk(req_page, frame);
+    LATENCY_END(lat_fetch, t_fetch);
+
+    set_page_state(req_page, PAGE_RESIDENT, frame);
+    __atomic_store_n(&frame_state[frame], FRAME_RESIDENT, __ATOMIC_RELEASE);
+    frame_event();
+
+    pthread_mutex_lock(&log_mutex);
+    if (prefetch) {
+        pages_prefetched++;
+        VMSTATS_ADD(stats->prefetches, 1);
+        log_message("Prefetch: page %d into frame %d, replaced page %d", req_page, frame, removedPage);
+    } else {
+        pf_count++;
+        VMSTATS_ADD(stats->faults, 1);
+        VMSTATS_ADD(stats->client_faults[req_page / VMEM_NPAGES], 1);
+
+        /* Log action */
+        le.req_pageno = req_page;
+        le.replaced_page = removedPage;
+        le.alloc_frame = frame;
+        le.g_count = g_count; 
+        le.pf_count = pf_count;
+        LATENCY_BEGIN(t_log);
+        logger(le);
+        LATENCY_END(lat_log, t_log);
+    }
+    pthread_mutex_unlock(&log_mutex);
+}
 
+void fetch_page_from_disk(int page, int frame){
+    fetch_page_from_pagefile(page, &vmem->mainMemory[frame * VMEM_PAGESIZE]);
+    lock_pt(page);
+    vmem->dirty_blocks[frame] = 0;
+    VMSTATS_ADD(stats->resident, 1);
+    if (pt_mode == VMEM_PT_INVERTED) {
+        ipt_insert(vmem, page / VMEM_NPAGES, page % VMEM_NPAGES, frame);
+    } else {
+        vmem->pt[page].frame = frame;
+        vmem->pt[page].flags = PTF_PRESENT;
+    }
+    unlock_pt(page);
+}
 
-} 
+void remove_page_from_memory(int page, int frame) {
+    // unmap the page first, so no client accesses the frame during write back
+    lock_pt(page);
+    int *flags = (pt_mode == VMEM_PT_INVERTED) ? &vmem->ipt[frame].flags : &vmem->pt[page].flags;
+    bool dirty = *flags & PTF_DIRTY;
+    unsigned long long blocks = vmem->dirty_blocks[frame];
+    if (pt_mode == VMEM_PT_INVERTED) {
+        ipt_remove(vmem, frame);
+    } else {
+        vmem->pt[page].flags = FLAG_INIT;
+        vmem->pt[page].frame = VOID_IDX;
+    }
+    unlock_pt(page);
+    VMSTATS_ADD(stats->resident, -1);
+    VMSTATS_ADD(stats->evictions, 1);
+    VMSTATS_ADD(stats->writebacks, dirty);
+    // a clean page must be written if the pagefile has reclaimed its copy
+    if (dirty && (block_size > 0)) {
+        store_blocks_to_pagefile(page, &vmem->mainMemory[frame * VMEM_PAGESIZE], blocks, block_size);
+    } else if (dirty || !evict_clean_page(page)) {
+        store_page_to_pagefile(page, &vmem->mainMemory[frame * VMEM_PAGESIZE]);
+    }
+}
 
 // EOF
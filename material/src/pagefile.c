@@ -7,19 +7,592 @@
   * pages from the pagefile.
   * It is based on an implementation of Wolfgang Fohl, HAW Hamburg.
   *
+  * Oct 2026 : Asynchronous backend. store_page_to_pagefile copies the victim into a 
+  *            write slot, fetch_page_from_pagefile submits the queued writes together 
+  *            with the read and returns as soon as the read has landed. The writes 
+  *            finish in the background. The backend uses io_uring if available and 
+  *            a pool of pwrite threads otherwise.
+  * Oct 2026 : Clustering for the stdio backend. Dirty victims are gathered and written
+  *            with one pwritev per run of adjacent pages. A fault reads a cluster of 
+  *            neighbouring pages into a staging buffer that serves the next faults.
+  * Oct 2026 : Log-structured layout for the stdio backend, see swapslot.h.
+  * Oct 2026 : fetch, store, evict_clean_page and clean_pagefile may be called by 
+  *            several threads.
+  * Oct 2026 : Regions for the shards of mmanage. Page n is stored in region n % nregions.
+  * Oct 2026 : Write back of the dirty blocks of a page only.
+  * Oct 2026 : Reset to the initial contents for the next run of a persistent mmanage.
+  * Oct 2026 : The stdio backend reads and writes the fixed layout with pread/pwrite, 
+  *            so threads no longer serialize on io_mutex. It is kept for the log 
+  *            layout and clustering.
+  * Oct 2026 : Each region has its own file handle and I/O counters.
+  * Oct 2026 : io_uring reads of several threads are in flight at the same time. A fetch 
+  *            waits for its read without slot_mutex, one thread reaps the completions 
+  *            for all of them.
   */
 
 #include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#include "debug.h"
 #include "error.h"
 #include "vmem.h"
 #include "my_rand.h"
 #include "pagefile.h"
+#include "swapslot.h"
 
 #define MMANAGE_PFNAME "./pagefile.bin" //!< Pagefile name 
 #define SEED_PF        070514           //!< Get reproducable pseudo-random numbers to init pagefile
 
+#define PAGEFILE_NWRITESLOTS 8          //!< Max. number of page writes in flight (async backends)
+#define PAGEFILE_NWORKERS    2          //!< Number of pwrite threads (thread backend)
+#define PAGEFILE_NREADS      8          //!< Max. number of page reads in flight (io_uring backend)
+#define PAGEFILE_URING_DEPTH 16         //!< Number of io_uring entries; >= PAGEFILE_NWRITESLOTS + PAGEFILE_NREADS
+
+#define SLOT_FREE     0                 //!< Write slot unused
+#define SLOT_QUEUED   1                 //!< Page copied into slot, write not yet submitted
+#define SLOT_INFLIGHT 2                 //!< Write submitted, not yet completed
+
 static FILE *pagefile = NULL;           //!< Reference to pagefile
+static int backend = PAGEFILE_BACKEND_STDIO; //!< Backend in use
+static int cluster = 1;                 //!< Cluster size in pages; 1: no clustering
+static int layout = PAGEFILE_LAYOUT_FIXED; //!< Placement of pages in the pagefile
+static int npages = VMEM_NPAGES;        //!< Number of pages of all address spaces
+static int nregions = 1;                //!< Number of regions of the fixed layout
+static struct pagefile_stats stats;     //!< I/O counters, except those of the regions
+static unsigned char *initial_image = NULL; //!< Contents of the pagefile after init_pagefile
+static size_t initial_size = 0;         //!< Size of initial_image in bytes
+/**
+ * A region of the fixed layout. The stdio backend transfers the pages of a region 
+ * with its own handle and counts them in its own counters, so threads of different
+ * shards share nothing.
+ */
+static struct region {
+    int fd;                             //!< Handle of the pagefile
+    struct pagefile_stats stats;        //!< I/O counters of the region
+} regions[PAGEFILE_MAXREGIONS];
+
+static pthread_mutex_t io_mutex = PTHREAD_MUTEX_INITIALIZER; //!< Serializes the log layout and clustering of the stdio backend
+
+/**
+ * Read-around buffer. It contains the current contents of the pages 
+ * first .. first + npages - 1, including not yet written victims.
+ */
+static struct {
+    int first;                          //!< First page in buf; VOID_IDX: empty
+    int npages;                         //!< Number of pages in buf
+    unsigned char buf[PAGEFILE_MAXCLUSTER * VMEM_PAGESIZE];
+} staging = { .first = VOID_IDX };
+
+/**
+ * Dirty victims gathered for the next clustered write
+ */
+static struct {
+    int n;                              //!< Number of gathered pages
+    int page[PAGEFILE_MAXCLUSTER];      //!< Page numbers
+    unsigned char buf[PAGEFILE_MAXCLUSTER][VMEM_PAGESIZE]; //!< Page contents
+} writeback;
+
+/**
+ * A write slot protects an evicted page until it has been written to the pagefile.
+ * The frame of the page can be reused immediately.
+ */
+struct write_slot {
+    int state;                          //!< SLOT_*
+    int page;                           //!< Page stored in buf
+    unsigned char buf[VMEM_PAGESIZE];   //!< Copy of the evicted page
+};
+
+static struct write_slot slots[PAGEFILE_NWRITESLOTS];
+static pthread_mutex_t slot_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t slot_done = PTHREAD_COND_INITIALIZER;   //!< A write has completed
+static pthread_cond_t slot_queued = PTHREAD_COND_INITIALIZER; //!< A write has been queued (thread backend)
+static pthread_t workers[PAGEFILE_NWORKERS];
+static bool workers_stop = false;
+
+#ifdef __linux__
+/**
+ * io_uring submission and completion ring, mapped from the kernel
+ */
+static struct {
+    int fd;
+    unsigned *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    unsigned to_submit;                 //!< Number of prepared entries not yet passed to the kernel
+} uring = { .fd = -1 };
+
+/**
+ * Page reads in flight. The io_uring user data of read r is PAGEFILE_NWRITESLOTS + r, 
+ * the one of a write is its slot index. Protected by slot_mutex.
+ */
+static struct {
+    bool busy;                          //!< Tag in use by a fetch
+    bool done;                          //!< Read has completed
+} reads[PAGEFILE_NREADS];
+static bool uring_reaping = false;      //!< A thread waits for completions without slot_mutex
+static pthread_cond_t uring_reaped = PTHREAD_COND_INITIALIZER; //!< Completions have been reaped or a read tag is free
+#endif
+
+/**
+ *****************************************************************************************
+ *  @brief      This function computes the position of a page in the pagefile.
+ ****************************************************************************************/
+static off_t page_offset(int pageNo) {
+    int region_pages = (npages + nregions - 1) / nregions;
+    int slot = (pageNo % nregions) * region_pages + pageNo / nregions;
+    return (off_t) slot * sizeof(unsigned char) * VMEM_PAGESIZE;
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function writes all gathered victims. Each run of adjacent pages 
+ *              is written with a single pwritev.
+ ****************************************************************************************/
+static void flush_writeback(void) {
+    int order[PAGEFILE_MAXCLUSTER];
+    // sort gathered pages by page number (insertion sort, n is small)
+    for (int i = 0; i < writeback.n; i++) {
+        int j = i;
+        for (; (j > 0) && (writeback.page[order[j - 1]] > writeback.page[i]); j--) {
+            order[j] = order[j - 1];
+        }
+        order[j] = i;
+    }
+    for (int i = 0; i < writeback.n; ) {
+        struct iovec iov[PAGEFILE_MAXCLUSTER];
+        int run = 0;
+        do {
+            iov[run].iov_base = writeback.buf[order[i + run]];
+            iov[run].iov_len = VMEM_PAGESIZE;
+            run++;
+        } while ((i + run < writeback.n) && (writeback.page[order[i + run]] == writeback.page[order[i]] + run));
+        ssize_t n = pwritev(fileno(pagefile), iov, run, page_offset(writeback.page[order[i]]));
+        TEST_AND_EXIT_ERRNO(n != run * VMEM_PAGESIZE, "Error writing page cluster to disk");
+        stats.write_ops++;
+        stats.bytes_written += n;
+        i += run;
+    }
+    writeback.n = 0;
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function fetches a page using the staging buffer. On a miss the 
+ *              cluster containing the page is read with a single pread.
+ ****************************************************************************************/
+static void fetch_page_clustered(int pageNo, unsigned char *frame_start) {
+    // the newest contents of a victim is in the writeback buffer
+    for (int i = 0; i < writeback.n; i++) {
+        if (writeback.page[i] == pageNo) {
+            memcpy(frame_start, writeback.buf[i], VMEM_PAGESIZE);
+            stats.staging_hits++;
+            return;
+        }
+    }
+    if ((staging.first == VOID_IDX) || (pageNo < staging.first) || (pageNo >= staging.first + staging.npages)) {
+        staging.first = pageNo - pageNo % cluster;
+        staging.npages = (staging.first + cluster <= npages) ? cluster : npages - staging.first;
+        ssize_t n = pread(fileno(pagefile), staging.buf, staging.npages * VMEM_PAGESIZE, page_offset(staging.first));
+        TEST_AND_EXIT_ERRNO(n != staging.npages * VMEM_PAGESIZE, "Error reading page cluster from disk");
+        stats.read_ops++;
+        stats.bytes_read += n;
+        // gathered victims are newer than the pagefile
+        for (int i = 0; i < writeback.n; i++) {
+            if ((writeback.page[i] >= staging.first) && (writeback.page[i] < staging.first + staging.npages)) {
+                memcpy(&staging.buf[(writeback.page[i] - staging.first) * VMEM_PAGESIZE], writeback.buf[i], VMEM_PAGESIZE);
+            }
+        }
+    } else {
+        stats.staging_hits++;
+    }
+    memcpy(frame_start, &staging.buf[(pageNo - staging.first) * VMEM_PAGESIZE], VMEM_PAGESIZE);
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function counts an I/O operation of the stdio backend without 
+ *              io_mutex.
+ *
+ *  @param      ops Counter of operations.
+ *  @param      bytes Counter of bytes.
+ *  @param      n Number of bytes transferred.
+ *
+ *  @return     void
+ ****************************************************************************************/
+static void count_io(long *ops, long *bytes, long n) {
+    __atomic_fetch_add(ops, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(bytes, n, __ATOMIC_RELAXED);
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function gathers a victim for the next clustered write and keeps
+ *              the staging buffer up to date.
+ ****************************************************************************************/
+static void store_page_clustered(int pageNo, unsigned char *frame_start) {
+    if ((staging.first != VOID_IDX) && (pageNo >= staging.first) && (pageNo < staging.first + staging.npages)) {
+        memcpy(&staging.buf[(pageNo - staging.first) * VMEM_PAGESIZE], frame_start, VMEM_PAGESIZE);
+    }
+    int i;
+    for (i = 0; (i < writeback.n) && (writeback.page[i] != pageNo); i++);
+    if (i == writeback.n) {
+        if (writeback.n == cluster) {
+            flush_writeback();
+            i = 0;
+        }
+        writeback.n++;
+    }
+    writeback.page[i] = pageNo;
+    memcpy(writeback.buf[i], frame_start, VMEM_PAGESIZE);
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      These functions read and write a page with the stdio backend.
+ *              Pages of the fixed layout are transferred with pread/pwrite, which
+ *              do not use the file position, so several threads do I/O in parallel.
+ *              The log layout and clustering keep shared state and hold io_mutex.
+ ****************************************************************************************/
+static void fetch_page_stdio(int pageNo, unsigned char *frame_start) {
+    if ((layout == PAGEFILE_LAYOUT_FIXED) && (cluster == 1)) {
+        struct region *r = &regions[pageNo % nregions];
+        TEST_AND_EXIT_ERRNO(pread(r->fd, frame_start, VMEM_PAGESIZE, page_offset(pageNo)) != VMEM_PAGESIZE, 
+                            "Error reading page from disk");
+        count_io(&r->stats.read_ops, &r->stats.bytes_read, VMEM_PAGESIZE);
+        return;
+    }
+    pthread_mutex_lock(&io_mutex);
+    if (layout == PAGEFILE_LAYOUT_LOG) {
+        swapslot_read(pageNo, frame_start);
+        stats.read_ops++;
+        stats.bytes_read += VMEM_PAGESIZE;
+    } else {
+        fetch_page_clustered(pageNo, frame_start);
+    }
+    pthread_mutex_unlock(&io_mutex);
+}
+
+static void store_page_stdio(int pageNo, unsigned char *frame_start) {
+    if ((layout == PAGEFILE_LAYOUT_FIXED) && (cluster == 1)) {
+        struct region *r = &regions[pageNo % nregions];
+        TEST_AND_EXIT_ERRNO(pwrite(r->fd, frame_start, VMEM_PAGESIZE, page_offset(pageNo)) != VMEM_PAGESIZE, 
+                            "Error writing page to disk");
+        count_io(&r->stats.write_ops, &r->stats.bytes_written, VMEM_PAGESIZE);
+        return;
+    }
+    pthread_mutex_lock(&io_mutex);
+    if (layout == PAGEFILE_LAYOUT_LOG) {
+        swapslot_write(pageNo, frame_start);
+        stats.write_ops++;
+        stats.bytes_written += VMEM_PAGESIZE;
+    } else {
+        store_page_clustered(pageNo, frame_start);
+    }
+    pthread_mutex_unlock(&io_mutex);
+}
+
+#ifdef __linux__
+/**
+ *****************************************************************************************
+ *  @brief      This function sets up io_uring. 
+ *
+ *  @return     true if io_uring is available.
+ ****************************************************************************************/
+static bool uring_setup(void) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    uring.fd = syscall(__NR_io_uring_setup, PAGEFILE_URING_DEPTH, &p);
+    if (uring.fd < 0) {
+        PRINT_DEBUG((stderr, "io_uring_setup failed, use thread backend\n"));
+        return false;
+    }
+    size_t sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    size_t cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        sq_size = cq_size = (sq_size > cq_size) ? sq_size : cq_size;
+    }
+    unsigned char *sq = mmap(NULL, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring.fd, IORING_OFF_SQ_RING);
+    TEST_AND_EXIT_ERRNO(sq == MAP_FAILED, "uring_setup: mmap of submission ring failed");
+    unsigned char *cq = sq;
+    if (!(p.features & IORING_FEAT_SINGLE_MMAP)) {
+        cq = mmap(NULL, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring.fd, IORING_OFF_CQ_RING);
+        TEST_AND_EXIT_ERRNO(cq == MAP_FAILED, "uring_setup: mmap of completion ring failed");
+    }
+    uring.sqes = mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE, 
+                      MAP_SHARED | MAP_POPULATE, uring.fd, IORING_OFF_SQES);
+    TEST_AND_EXIT_ERRNO(uring.sqes == MAP_FAILED, "uring_setup: mmap of submission entries failed");
+
+    uring.sq_tail  = (unsigned *) (sq + p.sq_off.tail);
+    uring.sq_mask  = (unsigned *) (sq + p.sq_off.ring_mask);
+    uring.sq_array = (unsigned *) (sq + p.sq_off.array);
+    uring.cq_head  = (unsigned *) (cq + p.cq_off.head);
+    uring.cq_tail  = (unsigned *) (cq + p.cq_off.tail);
+    uring.cq_mask  = (unsigned *) (cq + p.cq_off.ring_mask);
+    uring.cqes     = (struct io_uring_cqe *) (cq + p.cq_off.cqes);
+    return true;
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function prepares a read or write of one page.
+ *
+ *  @param      opcode IORING_OP_READ or IORING_OP_WRITE
+ *  @param      buf Buffer to be read or written.
+ *  @param      pageNo Page number, defines the pagefile position.
+ *  @param      tag Slot index or PAGEFILE_NWRITESLOTS + read index.
+ ****************************************************************************************/
+static void uring_prep(int opcode, unsigned char *buf, int pageNo, int tag) {
+    unsigned tail = *uring.sq_tail;
+    unsigned idx = tail & *uring.sq_mask;
+    struct io_uring_sqe *sqe = &uring.sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fileno(pagefile);
+    sqe->addr = (unsigned long) buf;
+    sqe->len = VMEM_PAGESIZE;
+    sqe->off = page_offset(pageNo);
+    sqe->user_data = (unsigned long long) (long long) tag;
+    uring.sq_array[idx] = idx;
+    __atomic_store_n(uring.sq_tail, tail + 1, __ATOMIC_RELEASE);
+    uring.to_submit++;
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function prepares the writes of all queued slots.
+ ****************************************************************************************/
+static void uring_prep_writes(void) {
+    for (int s = 0; s < PAGEFILE_NWRITESLOTS; s++) {
+        if (slots[s].state == SLOT_QUEUED) {
+            uring_prep(IORING_OP_WRITE, slots[s].buf, slots[s].page, s);
+            slots[s].state = SLOT_INFLIGHT;
+        }
+    }
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function passes all prepared entries to the kernel without waiting
+ *              for completions. slot_mutex must be held by the caller.
+ ****************************************************************************************/
+static void uring_submit(void) {
+    while (uring.to_submit > 0) {
+        int ret = syscall(__NR_io_uring_enter, uring.fd, uring.to_submit, 0, 0, NULL, 0);
+        if ((ret == -1) && (errno == EINTR)) {
+            continue;
+        }
+        TEST_AND_EXIT_ERRNO(ret == -1, "io_uring_enter failed");
+        uring.to_submit -= ret;
+    }
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function processes all completions. Completed writes free their 
+ *              slots, completed reads are marked done. slot_mutex must be held by the caller.
+ ****************************************************************************************/
+static void uring_reap(void) {
+    unsigned head = *uring.cq_head;
+    while (head != __atomic_load_n(uring.cq_tail, __ATOMIC_ACQUIRE)) {
+        struct io_uring_cqe *cqe = &uring.cqes[head & *uring.cq_mask];
+        int tag = (int) cqe->user_data;
+        TEST_AND_EXIT(cqe->res != VMEM_PAGESIZE, (stderr, "Asynchronous pagefile %s failed: %s\n", 
+                      (tag >= PAGEFILE_NWRITESLOTS) ? "read" : "write", strerror(-cqe->res)));
+        if (tag >= PAGEFILE_NWRITESLOTS) {
+            reads[tag - PAGEFILE_NWRITESLOTS].done = true;
+            stats.read_ops++;
+            stats.bytes_read += cqe->res;
+        } else {
+            stats.write_ops++;
+            stats.bytes_written += cqe->res;
+            slots[tag].state = SLOT_FREE;
+        }
+        head++;
+    }
+    __atomic_store_n(uring.cq_head, head, __ATOMIC_RELEASE);
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function waits until completions have been reaped. The first thread
+ *              waits in the kernel without slot_mutex and reaps for all threads, the 
+ *              others wait for it. The caller holds slot_mutex, has submitted its entries 
+ *              and checks its condition again afterwards.
+ ****************************************************************************************/
+static void uring_wait(void) {
+    if (uring_reaping) {
+        pthread_cond_wait(&uring_reaped, &slot_mutex);
+        return;
+    }
+    uring_reaping = true;
+    pthread_mutex_unlock(&slot_mutex);
+    int ret;
+    do {
+        ret = syscall(__NR_io_uring_enter, uring.fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+    } while ((ret == -1) && (errno == EINTR));
+    TEST_AND_EXIT_ERRNO(ret == -1, "io_uring_enter failed");
+    pthread_mutex_lock(&slot_mutex);
+    uring_reap();
+    uring_reaping = false;
+    pthread_cond_broadcast(&uring_reaped);
+}
+#endif /* __linux__ */
+
+/**
+ *****************************************************************************************
+ *  @brief      Worker of the thread backend. Writes queued slots with pwrite.
+ ****************************************************************************************/
+static void *write_worker(void *arg) {
+    pthread_mutex_lock(&slot_mutex);
+    while (true) {
+        int s;
+        for (s = 0; (s < PAGEFILE_NWRITESLOTS) && (slots[s].state != SLOT_QUEUED); s++);
+        if (s == PAGEFILE_NWRITESLOTS) {
+            if (workers_stop) break;
+            pthread_cond_wait(&slot_queued, &slot_mutex);
+            continue;
+        }
+        slots[s].state = SLOT_INFLIGHT;
+        pthread_mutex_unlock(&slot_mutex);
+        ssize_t n = pwrite(fileno(pagefile), slots[s].buf, VMEM_PAGESIZE, page_offset(slots[s].page));
+        TEST_AND_EXIT_ERRNO(n != VMEM_PAGESIZE, "Error writing page to disk");
+        pthread_mutex_lock(&slot_mutex);
+        stats.write_ops++;
+        stats.bytes_written += n;
+        slots[s].state = SLOT_FREE;
+        pthread_cond_broadcast(&slot_done);
+    }
+    pthread_mutex_unlock(&slot_mutex);
+    return arg;
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function passes all queued writes to the backend and waits until 
+ *              the condition holds. slot_mutex must be held by the caller (thread backend).
+ *
+ *  @param      page Wait until no write of this page is pending. VOID_IDX: any page.
+ *  @param      need_free_slot Wait until there is a free slot.
+ *  @param      all Wait until all writes have completed.
+ ****************************************************************************************/
+static void wait_for_writes(int page, bool need_free_slot, bool all) {
+    while (true) {
+        bool pending = false, page_pending = false, has_free = false;
+        for (int s = 0; s < PAGEFILE_NWRITESLOTS; s++) {
+            if (slots[s].state == SLOT_FREE) {
+                has_free = true;
+            } else {
+                pending = true;
+                page_pending |= (slots[s].page == page);
+            }
+        }
+        if (!page_pending && (!need_free_slot || has_free) && (!all || !pending)) return;
+#ifdef __linux__
+        if (backend == PAGEFILE_BACKEND_URING) {
+            uring_prep_writes();
+            uring_submit();
+            uring_wait();
+            continue;
+        }
+#endif
+        pthread_cond_broadcast(&slot_queued);
+        pthread_cond_wait(&slot_done, &slot_mutex);
+    }
+}
+
+void select_pagefile_backend(int be) {
+    backend = be;
+}
+
+void set_pagefile_address_spaces(int n) {
+    TEST_AND_EXIT((n < 1) || (n > VMEM_MAXCLIENTS), (stderr, "set_pagefile_address_spaces: number out of range\n"));
+    npages = n * VMEM_NPAGES;
+}
+
+void set_pagefile_regions(int n) {
+    TEST_AND_EXIT((n < 1) || (n > PAGEFILE_MAXREGIONS), (stderr, "set_pagefile_regions: number out of range\n"));
+    nregions = n;
+}
+
+void set_pagefile_cluster(int pages) {
+    TEST_AND_EXIT((pages < 1) || (pages > PAGEFILE_MAXCLUSTER), (stderr, "set_pagefile_cluster: cluster size out of range\n"));
+    cluster = pages;
+}
+
+void select_pagefile_layout(int l) {
+    layout = l;
+}
+
+bool evict_clean_page(int pageNo) {
+    bool ok = true;
+    if (layout == PAGEFILE_LAYOUT_LOG) {
+        pthread_mutex_lock(&io_mutex);
+        ok = swapslot_evict_clean(pageNo);
+        pthread_mutex_unlock(&io_mutex);
+    }
+    return ok;
+}
+
+void clean_pagefile(void) {
+    if (layout == PAGEFILE_LAYOUT_LOG) {
+        pthread_mutex_lock(&io_mutex);
+        swapslot_clean();
+        pthread_mutex_unlock(&io_mutex);
+    }
+}
+
+void save_pagefile_image(FILE *f) {
+    static unsigned char image[VMEM_NPAGES * VMEM_PAGESIZE];
+    TEST_AND_EXIT(layout != PAGEFILE_LAYOUT_FIXED, (stderr, "save_pagefile_image: fixed layout required\n"));
+    TEST_AND_EXIT(npages != VMEM_NPAGES, (stderr, "save_pagefile_image: single address space required\n"));
+    if (writeback.n > 0) {
+        flush_writeback();
+    }
+    if (backend != PAGEFILE_BACKEND_STDIO) {
+        pthread_mutex_lock(&slot_mutex);
+        wait_for_writes(VOID_IDX, false, true);
+        pthread_mutex_unlock(&slot_mutex);
+    }
+    TEST_AND_EXIT_ERRNO(fflush(pagefile) == EOF, "Error writing pagefile");
+    TEST_AND_EXIT_ERRNO(pread(fileno(pagefile), image, sizeof(image), 0) != sizeof(image), "Error reading pagefile");
+    TEST_AND_EXIT_ERRNO(fwrite(image, sizeof(image), 1, f) != 1, "Error writing pagefile image");
+}
+
+void restore_pagefile_image(const unsigned char *image) {
+    TEST_AND_EXIT(layout != PAGEFILE_LAYOUT_FIXED, (stderr, "restore_pagefile_image: fixed layout required\n"));
+    TEST_AND_EXIT(npages != VMEM_NPAGES, (stderr, "restore_pagefile_image: single address space required\n"));
+    TEST_AND_EXIT_ERRNO(fflush(pagefile) == EOF, "Error writing pagefile");
+    TEST_AND_EXIT_ERRNO(pwrite(fileno(pagefile), image, VMEM_NPAGES * VMEM_PAGESIZE, 0) != VMEM_NPAGES * VMEM_PAGESIZE, 
+                        "Error restoring pagefile");
+    staging.first = VOID_IDX;
+}
+
+void get_pagefile_stats(struct pagefile_stats *s) {
+    pthread_mutex_lock(&slot_mutex);
+    *s = stats;
+    pthread_mutex_unlock(&slot_mutex);
+    for (int i = 0; i < nregions; i++) {
+        const struct pagefile_stats *r = &regions[i].stats;
+        s->read_ops += __atomic_load_n(&r->read_ops, __ATOMIC_RELAXED);
+        s->write_ops += __atomic_load_n(&r->write_ops, __ATOMIC_RELAXED);
+        s->bytes_read += __atomic_load_n(&r->bytes_read, __ATOMIC_RELAXED);
+        s->bytes_written += __atomic_load_n(&r->bytes_written, __ATOMIC_RELAXED);
+        s->partial_writes += __atomic_load_n(&r->partial_writes, __ATOMIC_RELAXED);
+        s->bytes_saved += __atomic_load_n(&r->bytes_saved, __ATOMIC_RELAXED);
+    }
+}
 
 void init_pagefile(void) {
     int i;
@@ -30,38 +603,206 @@ void init_pagefile(void) {
 
     my_srand(SEED_PF);
 
-    for(i = 0; i < (VMEM_PAGESIZE * VMEM_NPAGES * sizeof(unsigned char)); i++) {
+    for(i = 0; i < (VMEM_PAGESIZE * npages * sizeof(unsigned char)); i++) {
         unsigned char rndval = my_rand() % (UCHAR_MAX + 1);
+        if ((nregions > 1) && (i % VMEM_PAGESIZE == 0)) {
+            TEST_AND_EXIT_ERRNO(fseek(pagefile, page_offset(i / VMEM_PAGESIZE), SEEK_SET) == -1, "Positioning in pagefile failed!");
+        }
         fwrite(&rndval, 1, 1, pagefile);
     }
+    // async backends bypass stdio buffering
+    TEST_AND_EXIT_ERRNO(fflush(pagefile) == EOF, "Error writing pagefile");
+
+    // keep the initial contents for reset_pagefile
+    TEST_AND_EXIT_ERRNO(fseek(pagefile, 0, SEEK_END) == -1, "Positioning in pagefile failed!");
+    initial_size = ftell(pagefile);
+    initial_image = malloc(initial_size);
+    TEST_AND_EXIT_ERRNO(!initial_image, "init_pagefile: malloc failed");
+    TEST_AND_EXIT_ERRNO(pread(fileno(pagefile), initial_image, initial_size, 0) != initial_size, "Error reading pagefile");
+
+    for (i = 0; i < nregions; i++) {
+        regions[i].fd = open(MMANAGE_PFNAME, O_RDWR);
+        TEST_AND_EXIT_ERRNO(regions[i].fd == -1, "Error opening pagefile for a region");
+    }
+
+    if (layout == PAGEFILE_LAYOUT_LOG) {
+        swapslot_init(fileno(pagefile), npages);
+    }
+
+#ifdef __linux__
+    if ((backend == PAGEFILE_BACKEND_URING) && !uring_setup()) {
+        backend = PAGEFILE_BACKEND_THREADS;
+    }
+#else
+    if (backend == PAGEFILE_BACKEND_URING) {
+        backend = PAGEFILE_BACKEND_THREADS;
+    }
+#endif
+    if (backend == PAGEFILE_BACKEND_THREADS) {
+        // signals must be handled by the main thread of mmanage only
+        sigset_t all, old;
+        sigfillset(&all);
+        pthread_sigmask(SIG_BLOCK, &all, &old);
+        for (i = 0; i < PAGEFILE_NWORKERS; i++) {
+            TEST_AND_EXIT(pthread_create(&workers[i], NULL, write_worker, NULL) != 0, 
+                          (stderr, "init_pagefile: Cannot create write worker\n"));
+        }
+        pthread_sigmask(SIG_SETMASK, &old, NULL);
+    }
+}
+
+void reset_pagefile(void) {
+    if (writeback.n > 0) {
+        flush_writeback();
+    }
+    if (backend != PAGEFILE_BACKEND_STDIO) {
+        pthread_mutex_lock(&slot_mutex);
+        wait_for_writes(VOID_IDX, false, true);
+        pthread_mutex_unlock(&slot_mutex);
+    }
+    TEST_AND_EXIT_ERRNO(fflush(pagefile) == EOF, "Error writing pagefile");
+    TEST_AND_EXIT_ERRNO(pwrite(fileno(pagefile), initial_image, initial_size, 0) != initial_size, "Error resetting pagefile");
+    staging.first = VOID_IDX;
+    if (layout == PAGEFILE_LAYOUT_LOG) {
+        // the log segments behind the initial pages are free again
+        swapslot_init(fileno(pagefile), npages);
+    }
+    pthread_mutex_lock(&slot_mutex);
+    memset(&stats, 0, sizeof(stats));
+    pthread_mutex_unlock(&slot_mutex);
+    for (int i = 0; i < nregions; i++) {
+        memset(&regions[i].stats, 0, sizeof(regions[i].stats));
+    }
 }
 
 void fetch_page_from_pagefile(int pageNo, unsigned char *frame_start) {
     // check page pageNo
     TEST_AND_EXIT(pageNo <  0,           (stderr, "find_page: pageNo out of range\n"));
-    TEST_AND_EXIT(pageNo >= VMEM_NPAGES, (stderr, "find_page: pageNo out of range\n"));
+    TEST_AND_EXIT(pageNo >= npages,      (stderr, "find_page: pageNo out of range\n"));
     
-    int offset = pageNo * sizeof(unsigned char) * VMEM_PAGESIZE;
+    if (backend == PAGEFILE_BACKEND_STDIO) {
+        fetch_page_stdio(pageNo, frame_start);
+        return;
+    }
 
-    TEST_AND_EXIT_ERRNO(fseek(pagefile, offset, SEEK_SET) == -1, "Positioning in pagefile failed!");
-    TEST_AND_EXIT_ERRNO(fread(frame_start, sizeof(unsigned char), VMEM_PAGESIZE, pagefile) != VMEM_PAGESIZE, "Error reading page from disk");
+    // a page that is still being written must not be read before the write has landed
+    pthread_mutex_lock(&slot_mutex);
+    wait_for_writes(pageNo, false, false);
+#ifdef __linux__
+    if (backend == PAGEFILE_BACKEND_URING) {
+        // a tag is freed by its fetch, not by the reaping thread
+        int r = 0;
+        while (reads[r].busy) {
+            if (++r == PAGEFILE_NREADS) {
+                pthread_cond_wait(&uring_reaped, &slot_mutex);
+                r = 0;
+            }
+        }
+        reads[r].busy = true;
+        reads[r].done = false;
+        // submit the victim writes together with the read, 
+        // other threads fetch while this one waits for its read
+        uring_prep_writes();
+        uring_prep(IORING_OP_READ, frame_start, pageNo, PAGEFILE_NWRITESLOTS + r);
+        uring_submit();
+        while (!reads[r].done) {
+            uring_wait();
+        }
+        reads[r].busy = false;
+        pthread_cond_broadcast(&uring_reaped);
+        pthread_mutex_unlock(&slot_mutex);
+        return;
+    }
+#endif
+    // thread backend: the workers write while this thread reads
+    pthread_cond_broadcast(&slot_queued);
+    pthread_mutex_unlock(&slot_mutex);
+    TEST_AND_EXIT_ERRNO(pread(fileno(pagefile), frame_start, VMEM_PAGESIZE, page_offset(pageNo)) != VMEM_PAGESIZE, 
+                        "Error reading page from disk");
+    pthread_mutex_lock(&slot_mutex);
+    stats.read_ops++;
+    stats.bytes_read += VMEM_PAGESIZE;
+    pthread_mutex_unlock(&slot_mutex);
 }
 
 void store_page_to_pagefile(int pageNo, unsigned char *frame_start) {
     // check pageNo
     TEST_AND_EXIT(pageNo <  0,           (stderr, "store_page: pageNo out of range\n"));
-    TEST_AND_EXIT(pageNo >= VMEM_NPAGES, (stderr, "store_page: pageNo out of range\n"));
+    TEST_AND_EXIT(pageNo >= npages,      (stderr, "store_page: pageNo out of range\n"));
 
+    if (backend == PAGEFILE_BACKEND_STDIO) {
+        store_page_stdio(pageNo, frame_start);
+        return;
+    }
 
-    int offset = pageNo * sizeof(unsigned char) * VMEM_PAGESIZE;
-
-    TEST_AND_EXIT_ERRNO(fseek(pagefile, offset, SEEK_SET) == -1, "Positioning in pagefile failed! ");
-    TEST_AND_EXIT_ERRNO(fwrite(frame_start, sizeof(unsigned char), VMEM_PAGESIZE, pagefile) != VMEM_PAGESIZE, "Error writing page to disk");
+    // copy the page into a write slot, it will be submitted with the next fetch
+    pthread_mutex_lock(&slot_mutex);
+    wait_for_writes(VOID_IDX, true, false);
+    int s;
+    for (s = 0; slots[s].state != SLOT_FREE; s++);
+    memcpy(slots[s].buf, frame_start, VMEM_PAGESIZE);
+    slots[s].page = pageNo;
+    slots[s].state = SLOT_QUEUED;
+    pthread_mutex_unlock(&slot_mutex);
 }
 
+void store_blocks_to_pagefile(int pageNo, unsigned char *frame_start, unsigned long long blocks, int block_size) {
+    TEST_AND_EXIT((pageNo < 0) || (pageNo >= npages), (stderr, "store_blocks: pageNo out of range\n"));
+    TEST_AND_EXIT((backend != PAGEFILE_BACKEND_STDIO) || (layout != PAGEFILE_LAYOUT_FIXED) || (cluster > 1), 
+                  (stderr, "store_blocks: stdio backend with fixed layout required\n"));
+    int nblocks = VMEM_PAGESIZE / block_size;
+    struct region *r = &regions[pageNo % nregions];
+
+    int written = 0;
+    for (int i = 0; i < nblocks; ) {
+        if (!(blocks & (1ULL << i))) {
+            i++;
+            continue;
+        }
+        int run = 1;
+        while ((i + run < nblocks) && (blocks & (1ULL << (i + run)))) {
+            run++;
+        }
+        TEST_AND_EXIT_ERRNO(pwrite(r->fd, frame_start + i * block_size, run * block_size, 
+                                   page_offset(pageNo) + i * block_size) != run * block_size, 
+                            "Error writing blocks to disk");
+        count_io(&r->stats.write_ops, &r->stats.bytes_written, run * block_size);
+        written += run * block_size;
+        i += run;
+    }
+    if (written < VMEM_PAGESIZE) {
+        count_io(&r->stats.partial_writes, &r->stats.bytes_saved, VMEM_PAGESIZE - written);
+    }
+}
 
 void cleanup_pagefile(void) {
+    if (writeback.n > 0) {
+        flush_writeback();
+    }
+    if (backend != PAGEFILE_BACKEND_STDIO) {
+        // drain all pending writes
+        pthread_mutex_lock(&slot_mutex);
+        wait_for_writes(VOID_IDX, false, true);
+        workers_stop = true;
+        pthread_cond_broadcast(&slot_queued);
+        pthread_mutex_unlock(&slot_mutex);
+        if (backend == PAGEFILE_BACKEND_THREADS) {
+            for (int i = 0; i < PAGEFILE_NWORKERS; i++) {
+                pthread_join(workers[i], NULL);
+            }
+        }
+#ifdef __linux__
+        if (uring.fd >= 0) {
+            close(uring.fd);
+        }
+#endif
+    }
+    for (int i = 0; i < nregions; i++) {
+        close(regions[i].fd);
+    }
     TEST_AND_EXIT_ERRNO(fclose(pagefile) == -1, "fclose in cleanup_pagefile failed! ")
+    free(initial_image);
+    initial_image = NULL;
 }
 
 // EOF
@@ -3,11 +3,162 @@
  * @author Franz Korf, HAW Hamburg 
  * @date Dec 2015
  * @brief Header file of module for input / output of memory file.
+ *        fetch_page_from_pagefile, store_page_to_pagefile, evict_clean_page and 
+ *        clean_pagefile may be called concurrently by several threads, as long as 
+ *        no two threads work on the same page at the same time.
  */
 
 #ifndef PAGEFILE_H
 #define PAGEFILE_H
 
+#include <stdio.h>
+#include <stdbool.h>
+
+#define PAGEFILE_BACKEND_STDIO   0  //!< Blocking stdio calls (default)
+#define PAGEFILE_BACKEND_URING   1  //!< Asynchronous io_uring, falls back to PAGEFILE_BACKEND_THREADS
+#define PAGEFILE_BACKEND_THREADS 2  //!< Asynchronous writes via a pool of pwrite threads
+
+/**
+ *****************************************************************************************
+ *  @brief      This function selects the I/O backend of the pagefile. It must be
+ *              called before init_pagefile. 
+ *              With an asynchronous backend, store_page_to_pagefile only queues the 
+ *              page. The write will be submitted by the next fetch_page_from_pagefile 
+ *              together with the read and completes in the background.
+ *
+ *  @param      backend One of PAGEFILE_BACKEND_*
+ *
+ *  @return     void 
+ ****************************************************************************************/
+void select_pagefile_backend(int backend);
+
+#define PAGEFILE_MAXCLUSTER 16      //!< Max. number of pages per clustered read or write
+
+/**
+ * I/O counters of the pagefile module. A clustered read or write counts as one operation.
+ */
+struct pagefile_stats {
+    long read_ops;                  //!< Number of read operations on the pagefile
+    long write_ops;                 //!< Number of write operations on the pagefile
+    long bytes_read;                //!< Number of bytes read from the pagefile
+    long bytes_written;             //!< Number of bytes written to the pagefile
+    long staging_hits;              //!< Number of fetches served without I/O
+    long partial_writes;            //!< Number of pages written back without their clean blocks
+    long bytes_saved;               //!< Number of bytes of clean blocks not written
+};
+
+/**
+ *****************************************************************************************
+ *  @brief      This function sets the number of address spaces stored in the pagefile. 
+ *              It must be called before init_pagefile. The pagefile holds VMEM_NPAGES 
+ *              pages per address space, pages are addressed by their global page number.
+ *
+ *  @param      n Number of address spaces, 1 .. VMEM_MAXCLIENTS. Default: 1 
+ *
+ *  @return     void 
+ ****************************************************************************************/
+void set_pagefile_address_spaces(int n);
+
+#define PAGEFILE_MAXREGIONS 8       //!< Max. number of regions of the pagefile
+
+/**
+ *****************************************************************************************
+ *  @brief      This function splits the pagefile into regions, one per shard of mmanage.
+ *              Page p is stored in region p % n. It must be called before 
+ *              init_pagefile. Regions apply to the fixed layout without clustering.
+ *              The stdio backend transfers the pages of each region with its own 
+ *              file handle and I/O counters, so the shards share no state.
+ *
+ *  @param      n Number of regions, 1 .. PAGEFILE_MAXREGIONS. Default: 1 
+ *
+ *  @return     void 
+ ****************************************************************************************/
+void set_pagefile_regions(int n);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function sets the cluster size of the stdio backend. 
+ *              With a cluster size > 1, dirty victims are gathered and written with one 
+ *              vectored write per run of adjacent pages. A fetch reads the aligned 
+ *              cluster of neighbouring pages into a staging buffer that serves the 
+ *              following fetches of these pages.
+ *
+ *  @param      pages Cluster size in pages, 1 .. PAGEFILE_MAXCLUSTER. Default: 1 
+ *
+ *  @return     void 
+ ****************************************************************************************/
+void set_pagefile_cluster(int pages);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function reports the I/O counters of the pagefile module.
+ *
+ *  @param      stats Structure to be filled with the current counters.
+ *
+ *  @return     void 
+ ****************************************************************************************/
+void get_pagefile_stats(struct pagefile_stats *stats);
+
+#define PAGEFILE_LAYOUT_FIXED 0     //!< Page n is stored at offset n * VMEM_PAGESIZE (default)
+#define PAGEFILE_LAYOUT_LOG   1     //!< Evicted pages are appended to log segments, see swapslot.h
+
+/**
+ *****************************************************************************************
+ *  @brief      This function selects the placement of pages in the pagefile. It must 
+ *              be called before init_pagefile. The log layout requires the stdio 
+ *              backend without clustering.
+ *
+ *  @param      layout One of PAGEFILE_LAYOUT_*
+ *
+ *  @return     void 
+ ****************************************************************************************/
+void select_pagefile_layout(int layout);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function informs the pagefile module that a clean page has been 
+ *              removed from memory.
+ *
+ *  @param      pageNo Number of the page.
+ *
+ *  @return     true if the pagefile holds a valid copy of the page. Otherwise the 
+ *              page must be written with store_page_to_pagefile.
+ ****************************************************************************************/
+bool evict_clean_page(int pageNo);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function does background work of the pagefile module, i.e. the 
+ *              log cleaner. It should be called while the memory manager is idle.
+ *
+ *  @return     void 
+ ****************************************************************************************/
+void clean_pagefile(void);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function writes the current contents of all pages in the pagefile
+ *              (VMEM_NPAGES * VMEM_PAGESIZE bytes) to a snapshot file. 
+ *              Snapshots require a single address space.
+ *              Pending writes will be completed first. Requires the fixed layout.
+ *
+ *  @param      f Snapshot file.
+ *
+ *  @return     void 
+ ****************************************************************************************/
+void save_pagefile_image(FILE *f);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function replaces the contents of all pages in the pagefile.
+ *              Requires the fixed layout.
+ *
+ *  @param      image VMEM_NPAGES * VMEM_PAGESIZE bytes of page contents.
+ *
+ *  @return     void 
+ ****************************************************************************************/
+void restore_pagefile_image(const unsigned char *image);
+
 /**
  *****************************************************************************************
  *  @brief      This function creates and initializes a new pagefile.
@@ -16,6 +167,18 @@
  ****************************************************************************************/
 void init_pagefile(void);
 
+/**
+ *****************************************************************************************
+ *  @brief      This function resets the pagefile to the state after init_pagefile: 
+ *              pending writes are completed, the initial contents of all pages, which 
+ *              init_pagefile has kept in memory, are written back in one go and the 
+ *              I/O counters are set to zero. Regenerating the pagefile is not needed.
+ *              No other function of this module may run concurrently.
+ *
+ *  @return     void 
+ ****************************************************************************************/
+void reset_pagefile(void);
+
 /**
  *****************************************************************************************
  *  @brief      This function fetches a page out of the pagefile and writes it into 
@@ -41,6 +204,25 @@ void fetch_page_from_pagefile(int pageNo, unsigned char *frame_start);
  ****************************************************************************************/
 void store_page_to_pagefile(int pageNo, unsigned char *frame_start);
 
+/**
+ *****************************************************************************************
+ *  @brief      This function writes the dirty blocks of a page to pagefile. Each run of 
+ *              adjacent dirty blocks is written with one write. The clean blocks must 
+ *              equal the copy of the page in the pagefile. 
+ *              Requires the stdio backend with the fixed layout and without clustering.
+ *
+ *  @param      pageNo Number of the page that should be written to pagefile.
+ * 
+ *  @param      frame_start Starting address of the frame that contains the page.
+ *
+ *  @param      blocks Dirty bitmap, bit i: block i has been written.
+ *
+ *  @param      block_size Size of the blocks in bytes, divides VMEM_PAGESIZE.
+ *
+ *  @return     void 
+ ****************************************************************************************/
+void store_blocks_to_pagefile(int pageNo, unsigned char *frame_start, unsigned long long blocks, int block_size);
+
 /**
  *****************************************************************************************
  *  @brief      This function cleans and closes page file module.
@@ -0,0 +1,345 @@
+/**
+ * @file partition.c
+ * @date Oct 2026
+ * @brief This module implements page replacement within partitions of the frames.
+ *        Each partition has its own instance of the inner policy, its own env and
+ *        its own lock, so callbacks for different partitions run in parallel. Only
+ *        partition_move_frame locks two partitions, in the order of their numbers.
+ *        Local replacement partitions the frames by client. Sharding partitions the
+ *        frames and the pages by page hash and moves frames from cold to hot shards.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "policy.h"
+#include "vmem.h"
+#include "error.h"
+
+#define PARTITION_MINFRAMES 2          //!< A shard never gives away its last frames
+#define PARTITION_MINFAULTS 16         //!< Faults of a shard in the window before it may grow
+#define PARTITION_SKEW      2          //!< Required ratio of the fault rates per frame of the hot and the cold shard
+#define PARTITION_WINDOW    16         //!< Number of time intervals after which the fault counters are halved
+
+/**
+ * A partition. env.nframes is the number of frames of the partition, it is changed
+ * by partition_move_frame only, with the lock held.
+ */
+struct part {
+    struct policy_env env;             //!< Functions of the instance; first member, see part_of
+    struct policy inst;                //!< Instance of the inner policy
+    pthread_mutex_t lock;              //!< Protects inst and frames
+    int frames[VMEM_NFRAMES];          //!< Frames of the partition; index: local frame
+    long faults;                       //!< Faults, halved every PARTITION_WINDOW time intervals
+};
+
+static const struct policy_ops *inner = NULL;    //!< Policy used within the partitions
+static int nparts = 1;                           //!< Number of partitions
+static bool sharded = false;                     //!< Partition pages by hash instead of client
+static struct part parts[POLICY_MAXSHARDS];      //!< The partitions
+static int frame_part[VMEM_NFRAMES];             //!< Partition of each frame
+static int frame_local[VMEM_NFRAMES];            //!< Index of each frame within its partition
+static long ticks = 0;                           //!< Number of time intervals
+static long move_tick = -1;                      //!< Time interval of the last move
+static long frames_moved = 0;                    //!< Number of rebalancing moves
+static const struct policy_env *outer = NULL;    //!< Functions of mmanage
+
+int partition_of_page(int page) {
+    return sharded ? page % nparts : page / VMEM_NPAGES;
+}
+
+int partition_frames(int part, int *frames) {
+    struct part *p = &parts[part];
+    if (!frames) {
+        return __atomic_load_n(&p->env.nframes, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_lock(&p->lock);
+    int n = p->env.nframes;
+    memcpy(frames, p->frames, n * sizeof(frames[0]));
+    pthread_mutex_unlock(&p->lock);
+    return n;
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function returns the partition an env belongs to.
+ ****************************************************************************************/
+static struct part *part_of(const struct policy_env *env) {
+    return (struct part *) env;
+}
+
+static int part_page_of_frame(const struct policy_env *env, int frame) {
+    return outer->page_of_frame(outer, part_of(env)->frames[frame]);
+}
+
+static bool part_test_ref(const struct policy_env *env, int frame) {
+    return outer->test_ref(outer, part_of(env)->frames[frame]);
+}
+
+static void part_clear_ref(const struct policy_env *env, int frame) {
+    outer->clear_ref(outer, part_of(env)->frames[frame]);
+}
+
+static bool part_pinned(const struct policy_env *env, int frame) {
+    return outer->pinned(outer, part_of(env)->frames[frame]);
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function locks the partition of a frame. The frame may be moved
+ *              until the lock is held, so its partition is checked again.
+ *
+ *  @return     The locked partition.
+ ****************************************************************************************/
+static struct part *lock_frame(int frame) {
+    while (1) {
+        struct part *p = &parts[__atomic_load_n(&frame_part[frame], __ATOMIC_ACQUIRE)];
+        pthread_mutex_lock(&p->lock);
+        if (p == &parts[__atomic_load_n(&frame_part[frame], __ATOMIC_RELAXED)]) {
+            return p;
+        }
+        pthread_mutex_unlock(&p->lock);
+    }
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function starts a new instance of the inner policy for a partition
+ *              after its frames have changed, if the inner policy cannot renumber its
+ *              frames. The history of the old instance is lost. The caller holds the
+ *              lock of the partition.
+ ****************************************************************************************/
+static void restart(struct part *p) {
+    policy_stop(&p->inst);
+    policy_start(&p->inst, inner, &p->env);
+}
+
+static void local_init(void *state, const struct policy_env *e) {
+    outer = e;
+    ticks = 0;
+    move_tick = -1;
+    frames_moved = 0;
+    for (int i = 0; i < nparts; i++) {
+        struct part *p = &parts[i];
+        p->env.page_of_frame = part_page_of_frame;
+        p->env.test_ref = part_test_ref;
+        p->env.clear_ref = part_clear_ref;
+        p->env.pinned = part_pinned;
+        p->faults = 0;
+        pthread_mutex_init(&p->lock, NULL);
+        // contiguous partitions of equal size
+        int first = i * VMEM_NFRAMES / nparts;
+        p->env.nframes = (i + 1) * VMEM_NFRAMES / nparts - first;
+        for (int k = 0; k < p->env.nframes; k++) {
+            p->frames[k] = first + k;
+            frame_part[first + k] = i;
+            frame_local[first + k] = k;
+        }
+        policy_start(&p->inst, inner, &p->env);
+    }
+}
+
+static void local_on_access(void *state, const struct policy_env *env, int frame) {
+    struct part *p = lock_frame(frame);
+    inner->on_access(p->inst.state, &p->env, frame_local[frame]);
+    pthread_mutex_unlock(&p->lock);
+}
+
+static void local_on_fault(void *state, const struct policy_env *env, int page, int frame) {
+    struct part *p = lock_frame(frame);
+    __atomic_fetch_add(&p->faults, 1, __ATOMIC_RELAXED);
+    if (inner->on_fault) {
+        inner->on_fault(p->inst.state, &p->env, page, frame_local[frame]);
+    }
+    pthread_mutex_unlock(&p->lock);
+}
+
+static void local_on_release(void *state, const struct policy_env *env, int frame) {
+    struct part *p = lock_frame(frame);
+    inner->on_release(p->inst.state, &p->env, frame_local[frame]);
+    pthread_mutex_unlock(&p->lock);
+}
+
+static void local_on_tick(void *state, const struct policy_env *env) {
+    // with -workers two ticks may run at the same time, each one counts
+    long tick = __atomic_add_fetch(&ticks, 1, __ATOMIC_RELAXED);
+    for (int i = 0; i < nparts; i++) {
+        struct part *p = &parts[i];
+        pthread_mutex_lock(&p->lock);
+        if (tick % PARTITION_WINDOW == 0) {
+            __atomic_store_n(&p->faults, __atomic_load_n(&p->faults, __ATOMIC_RELAXED) / 2, __ATOMIC_RELAXED);
+        }
+        if (inner->on_tick) {
+            inner->on_tick(p->inst.state, &p->env);
+        }
+        pthread_mutex_unlock(&p->lock);
+    }
+}
+
+static int local_choose_victim(void *state, const struct policy_env *env, int page) {
+    struct part *p = &parts[partition_of_page(page)];
+    pthread_mutex_lock(&p->lock);
+    int frame = p->frames[inner->choose_victim(p->inst.state, &p->env, page)];
+    pthread_mutex_unlock(&p->lock);
+    return frame;
+}
+
+int partition_donor(int part) {
+    int donor = VOID_IDX;
+    long faults[POLICY_MAXSHARDS];
+    int nframes[POLICY_MAXSHARDS];
+    long tick = __atomic_load_n(&ticks, __ATOMIC_RELAXED);
+    long last = __atomic_load_n(&move_tick, __ATOMIC_RELAXED);
+    if (!sharded || (last == tick)) {
+        return VOID_IDX;
+    }
+    // the counters of the other shards are read without their locks
+    for (int p = 0; p < nparts; p++) {
+        faults[p] = __atomic_load_n(&parts[p].faults, __ATOMIC_RELAXED);
+        nframes[p] = __atomic_load_n(&parts[p].env.nframes, __ATOMIC_RELAXED);
+    }
+    if (faults[part] < PARTITION_MINFAULTS) {
+        return VOID_IDX;
+    }
+    // the shard with the lowest fault rate per frame
+    for (int p = 0; p < nparts; p++) {
+        if ((p != part) && (nframes[p] > PARTITION_MINFRAMES) && ((donor == VOID_IDX)
+            || (faults[p] * nframes[donor] < faults[donor] * nframes[p]))) {
+            donor = p;
+        }
+    }
+    if ((donor != VOID_IDX)
+        && (faults[part] * nframes[donor] <= PARTITION_SKEW * faults[donor] * nframes[part])) {
+        donor = VOID_IDX;
+    }
+    // at most one move per time interval, even if several shards ask at the same time
+    if ((donor != VOID_IDX)
+        && !__atomic_compare_exchange_n(&move_tick, &last, tick, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        donor = VOID_IDX;
+    }
+    return donor;
+}
+
+int partition_move_frame(int from, int to, bool (*claim)(int frame, void *arg), void *arg) {
+    struct part *src = &parts[from];
+    struct part *dst = &parts[to];
+    int i;
+    pthread_mutex_lock(&parts[(from < to) ? from : to].lock);
+    pthread_mutex_lock(&parts[(from < to) ? to : from].lock);
+    // prefer an unused frame, otherwise let the donor choose its victim;
+    // the frame is claimed before it moves, a frame being loaded or evicted stays
+    for (i = 0; i < src->env.nframes; i++) {
+        if ((outer->page_of_frame(outer, src->frames[i]) == VOID_IDX) && claim(src->frames[i], arg)) {
+            break;
+        }
+    }
+    if (i == src->env.nframes) {
+        i = inner->choose_victim(src->inst.state, &src->env, VOID_IDX);
+        if (!claim(src->frames[i], arg)) {
+            i = VOID_IDX;
+        }
+    }
+    int frame = VOID_IDX;
+    if (i != VOID_IDX) {
+        frame = src->frames[i];
+        int last = src->env.nframes - 1;
+        int n = dst->env.nframes;
+        if (inner->on_renumber) {
+            // the last frame of the donor takes over the number of the moved frame
+            if (inner->on_release) {
+                inner->on_release(src->inst.state, &src->env, i);
+            }
+            if (i != last) {
+                inner->on_renumber(src->inst.state, &src->env, last, i);
+            }
+        }
+        src->frames[i] = src->frames[last];
+        frame_local[src->frames[i]] = i;
+        frame_local[frame] = n;
+        dst->frames[n] = frame;
+        // partition_frames and partition_donor read the sizes without the locks
+        __atomic_store_n(&src->env.nframes, last, __ATOMIC_RELAXED);
+        __atomic_store_n(&dst->env.nframes, n + 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&frame_part[frame], to, __ATOMIC_RELEASE);
+        // otherwise the receiver links the frame in with on_fault when it is loaded
+        if (!inner->on_renumber) {
+            restart(src);
+            restart(dst);
+        }
+    }
+    pthread_mutex_unlock(&parts[(from < to) ? to : from].lock);
+    pthread_mutex_unlock(&parts[(from < to) ? from : to].lock);
+    if (frame != VOID_IDX) {
+        __atomic_store_n(&move_tick, __atomic_load_n(&ticks, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+        __atomic_fetch_add(&frames_moved, 1, __ATOMIC_RELAXED);
+    }
+    return frame;
+}
+
+static void local_stats(void *state, const struct policy_env *env, FILE *f) {
+    for (int i = 0; i < nparts; i++) {
+        struct part *p = &parts[i];
+        fprintf(f, "Partition %d: %d frames", i, p->env.nframes);
+        if (inner->stats) {
+            fprintf(f, ", ");
+            inner->stats(p->inst.state, &p->env, f);
+        } else {
+            fprintf(f, "\n");
+        }
+    }
+    if (sharded) {
+        fprintf(f, "Rebalancing: %ld frames moved\n", frames_moved);
+    }
+}
+
+static void local_teardown(void *state) {
+    for (int i = 0; i < nparts; i++) {
+        policy_stop(&parts[i].inst);
+        pthread_mutex_destroy(&parts[i].lock);
+    }
+}
+
+/**
+ * Callbacks of partitioned replacement. on_access is set only if the inner policy
+ * uses it, since mmanage harvests and resets reference bits for such policies.
+ * on_release is set only if the inner policy uses it, too.
+ * The partitions are kept in static variables, so there is one instance only.
+ */
+static struct policy_ops local_ops = {
+    .name = "LOCAL",
+    .init = local_init,
+    .on_fault = local_on_fault,
+    .on_tick = local_on_tick,
+    .choose_victim = local_choose_victim,
+    .stats = local_stats,
+    .teardown = local_teardown,
+    .concurrent = true,
+};
+
+/**
+ *****************************************************************************************
+ *  @brief      This function sets up the partitions for local_policy and shard_policy.
+ ****************************************************************************************/
+static const struct policy_ops *partitioned(const struct policy_ops *ops, int n, bool by_hash, const char *name) {
+    inner = ops;
+    nparts = n;
+    sharded = by_hash;
+    local_ops.name = name;
+    local_ops.on_access = ops->on_access ? local_on_access : NULL;
+    local_ops.on_release = ops->on_release ? local_on_release : NULL;
+    return &local_ops;
+}
+
+const struct policy_ops *local_policy(const struct policy_ops *ops, int nclients) {
+    TEST_AND_EXIT((nclients < 1) || (nclients > VMEM_NFRAMES) || (nclients > VMEM_MAXCLIENTS),
+                  (stderr, "local_policy: number of clients out of range\n"));
+    return partitioned(ops, nclients, false, "LOCAL");
+}
+
+const struct policy_ops *shard_policy(const struct policy_ops *ops, int nshards) {
+    TEST_AND_EXIT((nshards < 1) || (nshards * PARTITION_MINFRAMES > VMEM_NFRAMES) || (nshards > POLICY_MAXSHARDS),
+                  (stderr, "shard_policy: number of shards out of range\n"));
+    return partitioned(ops, nshards, true, "SHARDED");
+}
+
+// EOF
@@ -0,0 +1,38 @@
+/**
+ * @file pff.c
+ * @date Oct 2026
+ * @brief This module implements the page fault frequency estimator, see pff.h.
+ */
+
+#include <string.h>
+#include "pff.h"
+
+void pff_init(struct pff_window *w, int window, int nclients) {
+    memset(w, 0, sizeof(*w));
+    w->window = window;
+    w->nclients = nclients;
+    for (int c = 0; c < nclients; c++) {
+        w->pff[c] = VOID_IDX;
+    }
+}
+
+bool pff_update(struct pff_window *w, struct msg m) {
+    int c = m.client;
+    w->last_seen[c] = ++w->nmsgs;
+    if (m.cmd == CMD_PAGEFAULT) {
+        w->win_faults[c]++;
+    }
+    if (m.g_count - w->win_start[c] < w->window) {
+        return false;
+    }
+    w->pff[c] = w->win_faults[c] * 1000 / (m.g_count - w->win_start[c]);
+    w->win_start[c] = m.g_count;
+    w->win_faults[c] = 0;
+    return true;
+}
+
+bool pff_running(const struct pff_window *w, int client) {
+    return (w->last_seen[client] > 0) && (w->nmsgs - w->last_seen[client] < PFF_RECENT * w->window);
+}
+
+// EOF
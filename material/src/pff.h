@@ -0,0 +1,68 @@
+/**
+ * @file pff.h
+ * @date Oct 2026
+ * @brief Header file of the page fault frequency (PFF) estimator of mmanage.
+ *        The PFF of each client is measured over windows of memory accesses
+ *        (g_count): when a message completes a window of the client, its PFF
+ *        becomes the page faults per 1000 accesses of that window. A client is
+ *        running if it has sent a message within the last PFF_RECENT windows worth
+ *        of messages of all clients.
+ *
+ *        The load control (loadctl.h) and the frame quotas (quota.h) each keep an
+ *        estimator with their own window length.
+ */
+
+#ifndef PFF_H
+#define PFF_H
+
+#include <stdbool.h>
+#include "syncdataexchange.h"
+#include "vmem.h"
+
+#define PFF_RECENT 4            //!< A client is running if it sent a message within PFF_RECENT * window messages
+
+/**
+ * PFF estimator of all clients
+ */
+struct pff_window {
+    int window;                         //!< Memory accesses per measurement window
+    int nclients;                       //!< Number of clients
+    int win_start[VMEM_MAXCLIENTS];     //!< g_count at the start of the current window
+    int win_faults[VMEM_MAXCLIENTS];    //!< Page faults in the current window
+    int pff[VMEM_MAXCLIENTS];           //!< Page faults per 1000 accesses in the last window; VOID_IDX: unknown
+    long last_seen[VMEM_MAXCLIENTS];    //!< Number of the last message of the client
+    long nmsgs;                         //!< Number of messages
+};
+
+/**
+ *****************************************************************************************
+ *  @brief      This function initializes an estimator. The PFF of all clients is
+ *              unknown.
+ *
+ *  @param      w The estimator.
+ *  @param      window Memory accesses per measurement window.
+ *  @param      nclients Number of clients.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void pff_init(struct pff_window *w, int window, int nclients);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function accounts a message received from a client.
+ *
+ *  @param      w The estimator.
+ *  @param      m The message.
+ *
+ *  @return     true if the message has completed a window of m.client, i.e. its PFF
+ *              has been updated.
+ ****************************************************************************************/
+bool pff_update(struct pff_window *w, struct msg m);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function tells whether a client has sent a message recently.
+ ****************************************************************************************/
+bool pff_running(const struct pff_window *w, int client);
+
+#endif /* PFF_H */
@@ -0,0 +1,47 @@
+/**
+ * @file policy_random.c
+ * @date Oct 2026
+ * @brief Example of a page replacement policy loaded by mmanage -policy=./bin/policy_random.so
+ *        It replaces a pseudo-random frame. The sequence is reproducible, so its 
+ *        log files can be compared between runs.
+ */
+
+#include "policy.h"
+
+#define RANDOM_SEED 2806          //!< Start value of the random number generator
+
+/**
+ * State of an instance
+ */
+struct random_state {
+    unsigned int x_n;   //!< Last random number
+    long victims;       //!< Number of selected victims
+};
+
+static void random_init(void *state, const struct policy_env *env) {
+    struct random_state *s = state;
+    s->x_n = RANDOM_SEED;
+    s->victims = 0;
+}
+
+static int random_choose_victim(void *state, const struct policy_env *env, int page) {
+    struct random_state *s = state;
+    s->x_n = (1103515245u * s->x_n + 12345u) & 0x7FFFFFFF;
+    s->victims++;
+    return (s->x_n >> 16) % env->nframes;
+}
+
+static void random_stats(void *state, const struct policy_env *env, FILE *f) {
+    struct random_state *s = state;
+    fprintf(f, "Random: %ld victims\n", s->victims);
+}
+
+const struct policy_ops policy_ops = {
+    .name = "RANDOM",
+    .size = sizeof(struct random_state),
+    .init = random_init,
+    .choose_victim = random_choose_victim,
+    .stats = random_stats,
+};
+
+// EOF
@@ -0,0 +1,302 @@
+/**
+ * @file policy.c
+ * @date Oct 2026
+ * @brief This module implements the built-in page replacement policies fifo, 
+ *        clock and aging, the instances of policies and the loader for policies in 
+ *        shared objects.
+ */
+
+#include <dlfcn.h>
+#include <stdlib.h>
+#include "policy.h"
+#include "vmem.h"
+#include "error.h"
+
+void policy_start(struct policy *p, const struct policy_ops *ops, const struct policy_env *env) {
+    p->ops = ops;
+    p->env = env;
+    p->state = calloc(1, ops->size ? ops->size : 1);
+    TEST_AND_EXIT_ERRNO(!p->state, "policy_start: calloc failed");
+    ops->init(p->state, env);
+}
+
+void policy_stop(struct policy *p) {
+    if (p->ops->teardown) {
+        p->ops->teardown(p->state);
+    }
+    free(p->state);
+    p->state = NULL;
+}
+
+/*
+ * fifo: the frames are kept in the order their pages have been loaded. Frames are
+ * not always loaded in ascending order, since frames released by advice or load 
+ * control are loaded again later.
+ */
+struct fifo_state {
+    int head;                   //!< frame of the oldest page; VOID_IDX: none
+    int tail;                   //!< frame of the newest page; VOID_IDX: none
+    int next[VMEM_NFRAMES];     //!< frame loaded after the frame; VOID_IDX: none
+    int prev[VMEM_NFRAMES];     //!< frame loaded before the frame; VOID_IDX: none
+};
+
+/**
+ *****************************************************************************************
+ *  @brief      These functions remove a frame from the load order / append it as the
+ *              newest one.
+ ****************************************************************************************/
+static void fifo_unlink(struct fifo_state *s, int frame) {
+    if ((s->prev[frame] == VOID_IDX) && (s->head != frame)) {
+        return;     // not in the queue
+    }
+    if (s->prev[frame] != VOID_IDX) {
+        s->next[s->prev[frame]] = s->next[frame];
+    } else {
+        s->head = s->next[frame];
+    }
+    if (s->next[frame] != VOID_IDX) {
+        s->prev[s->next[frame]] = s->prev[frame];
+    } else {
+        s->tail = s->prev[frame];
+    }
+    s->prev[frame] = s->next[frame] = VOID_IDX;
+}
+
+static void fifo_append(struct fifo_state *s, int frame) {
+    s->prev[frame] = s->tail;
+    s->next[frame] = VOID_IDX;
+    if (s->tail != VOID_IDX) {
+        s->next[s->tail] = frame;
+    } else {
+        s->head = frame;
+    }
+    s->tail = frame;
+}
+
+static void fifo_init(void *state, const struct policy_env *env) {
+    struct fifo_state *s = state;
+    s->head = s->tail = VOID_IDX;
+    for (int i = 0; i < VMEM_NFRAMES; i++) {
+        s->prev[i] = s->next[i] = VOID_IDX;
+    }
+    // unused frames are loaded in ascending order, used ones have no known order
+    for (int i = 0; i < env->nframes; i++) {
+        fifo_append(s, i);
+    }
+}
+
+static void fifo_on_fault(void *state, const struct policy_env *env, int page, int frame) {
+    struct fifo_state *s = state;
+    fifo_unlink(s, frame);
+    fifo_append(s, frame);
+}
+
+static void fifo_on_release(void *state, const struct policy_env *env, int frame) {
+    fifo_unlink(state, frame);
+}
+
+static void fifo_on_renumber(void *state, const struct policy_env *env, int from, int to) {
+    struct fifo_state *s = state;
+    bool queued = (s->prev[from] != VOID_IDX) || (s->head == from);
+    // the frame keeps its position in the load order
+    s->prev[to] = s->prev[from];
+    s->next[to] = s->next[from];
+    s->prev[from] = s->next[from] = VOID_IDX;
+    if (!queued) {
+        return;
+    }
+    if (s->prev[to] != VOID_IDX) {
+        s->next[s->prev[to]] = to;
+    } else {
+        s->head = to;
+    }
+    if (s->next[to] != VOID_IDX) {
+        s->prev[s->next[to]] = to;
+    } else {
+        s->tail = to;
+    }
+}
+
+static int fifo_choose_victim(void *state, const struct policy_env *env, int page) {
+    struct fifo_state *s = state;
+    // pinned frames are passed over and stay at their position of the queue
+    for (int frame = s->head; frame != VOID_IDX; frame = s->next[frame]) {
+        if (!env->pinned(env, frame)) {
+            return frame;
+        }
+    }
+    return (s->head != VOID_IDX) ? s->head : 0;    // all frames pinned
+}
+
+const struct policy_ops policy_fifo = {
+    .name = "FIFO",
+    .size = sizeof(struct fifo_state),
+    .init = fifo_init,
+    .on_fault = fifo_on_fault,
+    .on_release = fifo_on_release,
+    .on_renumber = fifo_on_renumber,
+    .choose_victim = fifo_choose_victim,
+};
+
+/*
+ * clock: give every referenced page a second chance. The hand is advanced atomically,
+ * so several threads choose victims at the same time, each from its own hand position.
+ */
+struct clock_state {
+    unsigned long hand; //!< current position of the clock hand (modulo nframes)
+    long steps;        //!< number of hand movements
+    long victims;      //!< number of selected victims
+};
+
+static void clock_init(void *state, const struct policy_env *env) {
+    struct clock_state *s = state;
+    s->hand = 0;
+    s->steps = 0;
+    s->victims = 0;
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function moves the clock hand by one frame.
+ *
+ *  @return     The frame the hand pointed to.
+ ****************************************************************************************/
+static int clock_advance(struct clock_state *s, const struct policy_env *env) {
+    return __atomic_fetch_add(&s->hand, 1, __ATOMIC_RELAXED) % env->nframes;
+}
+
+static int clock_choose_victim(void *state, const struct policy_env *env, int page) {
+    struct clock_state *s = state;
+    int pinned = 0;
+    long steps = 1;
+    int frame = clock_advance(s, env);
+    while (env->test_ref(env, frame) 
+           || (env->pinned(env, frame) && (++pinned < env->nframes))) {
+        env->clear_ref(env, frame);
+        frame = clock_advance(s, env);
+        steps++;
+    }
+    __atomic_fetch_add(&s->steps, steps, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&s->victims, 1, __ATOMIC_RELAXED);
+    return frame;
+}
+
+static void clock_on_renumber(void *state, const struct policy_env *env, int from, int to) {
+    // the hand is the only state, it is taken modulo the new number of frames
+}
+
+static void clock_stats(void *state, const struct policy_env *env, FILE *f) {
+    struct clock_state *s = state;
+    fprintf(f, "Clock: %ld victims, %.2f hand steps per victim\n", s->victims, 
+            s->victims ? (double) s->steps / s->victims : 0.0);
+}
+
+const struct policy_ops policy_clock = {
+    .name = "CLOCK",
+    .size = sizeof(struct clock_state),
+    .init = clock_init,
+    .on_renumber = clock_on_renumber,
+    .choose_victim = clock_choose_victim,
+    .stats = clock_stats,
+    .concurrent = true,
+};
+
+/*
+ * aging: 8 bit age counter per frame
+ */
+struct aging_state {
+    unsigned char age[VMEM_NFRAMES];   //!< 8 bit counter for aging page replacement algorithm
+    bool referenced[VMEM_NFRAMES];     //!< reference bit harvested during the current time interval
+};
+
+static void aging_init(void *state, const struct policy_env *env) {
+    struct aging_state *s = state;
+    for (int i = 0; i < VMEM_NFRAMES; i++) {
+        s->age[i] = 0;
+        s->referenced[i] = false;
+    }
+}
+
+static void aging_on_access(void *state, const struct policy_env *env, int frame) {
+    struct aging_state *s = state;
+    s->referenced[frame] = true;
+}
+
+static void aging_on_fault(void *state, const struct policy_env *env, int page, int frame) {
+    struct aging_state *s = state;
+    // a freshly loaded page must not be the next victim
+    s->age[frame] = 0x80;
+    s->referenced[frame] = false;
+}
+
+static void aging_on_renumber(void *state, const struct policy_env *env, int from, int to) {
+    struct aging_state *s = state;
+    s->age[to] = s->age[from];
+    s->referenced[to] = s->referenced[from];
+    s->age[from] = 0;
+    s->referenced[from] = false;
+}
+
+static void aging_on_tick(void *state, const struct policy_env *env) {
+    struct aging_state *s = state;
+    for (int i = 0; i < env->nframes; i++) {
+        s->age[i] >>= 1;
+        if (s->referenced[i]) {
+            s->age[i] |= 0x80;
+            s->referenced[i] = false;
+        }
+    }
+}
+
+static int aging_choose_victim(void *state, const struct policy_env *env, int page) {
+    struct aging_state *s = state;
+    bool passed[VMEM_NFRAMES] = { false };
+    int victim;
+    // on equal age the page with the highest frame number will be replaced,
+    // pinned frames are passed over
+    do {
+        victim = VOID_IDX;
+        for (int i = 0; i < env->nframes; i++) {
+            if (!passed[i] && ((victim == VOID_IDX) || (s->age[i] <= s->age[victim]))) {
+                victim = i;
+            }
+        }
+        if (victim == VOID_IDX) {
+            return 0;   // all frames pinned
+        }
+        passed[victim] = true;
+    } while (env->pinned(env, victim));
+    return victim;
+}
+
+static void aging_stats(void *state, const struct policy_env *env, FILE *f) {
+    struct aging_state *s = state;
+    fprintf(f, "Aging:");
+    for (int i = 0; i < env->nframes; i++) {
+        fprintf(f, " %02X", s->age[i]);
+    }
+    fprintf(f, "\n");
+}
+
+const struct policy_ops policy_aging = {
+    .name = "AGING",
+    .size = sizeof(struct aging_state),
+    .init = aging_init,
+    .on_access = aging_on_access,
+    .on_fault = aging_on_fault,
+    .on_renumber = aging_on_renumber,
+    .on_tick = aging_on_tick,
+    .choose_victim = aging_choose_victim,
+    .stats = aging_stats,
+};
+
+const struct policy_ops *load_policy(const char *path) {
+    void *handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    TEST_AND_EXIT(!handle, (stderr, "load_policy: %s\n", dlerror()));
+    const struct policy_ops *ops = dlsym(handle, POLICY_OPS_SYMBOL);
+    TEST_AND_EXIT(!ops, (stderr, "load_policy: %s does not export %s\n", path, POLICY_OPS_SYMBOL));
+    TEST_AND_EXIT(!ops->init || !ops->choose_victim, (stderr, "load_policy: %s lacks init or choose_victim\n", path));
+    return ops;
+}
+
+// EOF
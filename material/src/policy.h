@@ -0,0 +1,230 @@
+/**
+ * @file policy.h
+ * @date Oct 2026
+ * @brief Interface of the page replacement policies. 
+ *        A policy is a table of callbacks. The built-in policies fifo, clock and 
+ *        aging are part of mmanage, further policies can be loaded from shared 
+ *        objects that export a struct policy_ops named POLICY_OPS_SYMBOL.
+ *
+ *        A policy keeps all its state in an instance (struct policy): a block of 
+ *        ops->size bytes that mmanage allocates and passes to every callback together 
+ *        with the env of the instance. So a policy may run in several instances at 
+ *        the same time, e.g. one per partition of the frames.
+ *
+ *        mmanage calls the callbacks as follows:
+ *        - init at startup and when a client resets the memory (CMD_RESET), after
+ *          teardown of the previous instance,
+ *        - on_fault after a page has been loaded into a frame,
+ *        - on_release when a frame becomes unused without a page fault (advice 
+ *          DONTNEED, drop-behind, suspension by load control). The frame may be 
+ *          loaded again later, in any order,
+ *        - on_renumber when a partition gives a frame away: the frame that had the 
+ *          highest number of the instance takes over the number of the frame given
+ *          away (after on_release of that one). The frame given away is loaded again
+ *          in the other partition, so on_fault follows there. If on_renumber is NULL,
+ *          both instances are restarted and lose their history,
+ *        - choose_victim when a page fault occurs and all frames are in use,
+ *        - on_access for each used frame whose reference bit is set, when a time 
+ *          interval has passed. The reference bits will be reset afterwards. 
+ *          If on_access is NULL, reference bits are neither harvested nor reset.
+ *        - on_tick when a time interval has passed (after on_access),
+ *        - stats when statistics are printed and teardown when mmanage terminates.
+ *        All callbacks except init and choose_victim are optional (NULL).
+ *
+ *        With mmanage -workers the callbacks are called by several threads. mmanage 
+ *        serializes them unless the policy is concurrent: then on_access, on_fault, 
+ *        on_tick and choose_victim may run at the same time, also on the same frame. 
+ *        A frame returned by choose_victim may already be claimed by another thread, 
+ *        mmanage asks again in that case. init, stats and teardown are never called 
+ *        concurrently.
+ *
+ *        choose_victim must not return a frame for which env->pinned is true, unless 
+ *        all frames are pinned. mmanage asks a policy that ignores pinning again and 
+ *        finally takes an unpinned frame itself.
+ *
+ *        Page numbers passed to a policy are global page numbers, see vmem.h.
+ *        choose_victim receives VOID_IDX if a frame is taken away from a partition.
+ *
+ *        The state is saved in snapshots as it is, so it should not contain pointers.
+ */
+
+#ifndef POLICY_H
+#define POLICY_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define POLICY_OPS_SYMBOL "policy_ops"  //!< Name of the struct policy_ops exported by a policy shared object
+
+/**
+ * Functions of mmanage a policy may use to inspect the frames. Each function gets 
+ * the env it has been called through, so a wrapper policy (partitions, shadow 
+ * simulations) may embed the env in a larger struct as its first member.
+ */
+struct policy_env {
+    int nframes;                                                //!< Number of frames
+    int  (*page_of_frame)(const struct policy_env *env, int frame); //!< Page stored in frame; VOID_IDX: frame unused
+    bool (*test_ref)(const struct policy_env *env, int frame);  //!< Reference bit of the page stored in frame
+    void (*clear_ref)(const struct policy_env *env, int frame); //!< Reset reference bit of the page stored in frame
+    bool (*pinned)(const struct policy_env *env, int frame);    //!< Page stored in frame must not be evicted (vmem_pin)
+};
+
+/**
+ * Callbacks of a page replacement policy. state is the state of the instance, env 
+ * the functions of the instance.
+ */
+struct policy_ops {
+    const char *name;                                           //!< Name of the policy
+    size_t size;                                                //!< Size of the state of an instance
+    void (*init)(void *state, const struct policy_env *env);    //!< Initialize the state
+    void (*on_access)(void *state, const struct policy_env *env, int frame); //!< Page in frame has been referenced during the last time interval
+    void (*on_fault)(void *state, const struct policy_env *env, int page, int frame); //!< Page has been loaded into frame
+    void (*on_release)(void *state, const struct policy_env *env, int frame); //!< Frame has become unused
+    void (*on_renumber)(void *state, const struct policy_env *env, int from, int to); //!< Frame from is now frame to, to is unused
+    void (*on_tick)(void *state, const struct policy_env *env); //!< A time interval has passed
+    int  (*choose_victim)(void *state, const struct policy_env *env, int page); //!< Return the frame to be freed for page
+    void (*stats)(void *state, const struct policy_env *env, FILE *f); //!< Print policy specific statistics
+    void (*teardown)(void *state);                              //!< Release resources of the instance
+    bool concurrent;                                            //!< Callbacks are safe to be called by several threads
+};
+
+/**
+ * Instance of a policy
+ */
+struct policy {
+    const struct policy_ops *ops;       //!< Callbacks
+    const struct policy_env *env;       //!< Functions of the instance
+    void *state;                        //!< State, ops->size bytes
+};
+
+extern const struct policy_ops policy_fifo;   //!< First in first out
+extern const struct policy_ops policy_clock;  //!< Second chance with clock hand
+extern const struct policy_ops policy_aging;  //!< Aging with 8 bit counters
+extern const struct policy_ops policy_adaptive; //!< Switches between fifo, clock and aging based on shadow simulations
+
+#define POLICY_MAXSHARDS 8              //!< Max. number of partitions of shard_policy
+
+/**
+ *****************************************************************************************
+ *  @brief      This function allocates the state of an instance and initializes it.
+ *
+ *  @param      p Instance to be set up.
+ *  @param      ops Policy of the instance.
+ *  @param      env Functions of the instance. They must stay valid until policy_stop.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void policy_start(struct policy *p, const struct policy_ops *ops, const struct policy_env *env);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function tears an instance down and frees its state.
+ *
+ *  @param      p Instance started with policy_start.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void policy_stop(struct policy *p);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function creates a policy for local replacement. It gives each 
+ *              client a fixed partition of the frames and runs a separate instance of 
+ *              the inner policy on each partition. A victim is always taken from the 
+ *              partition of the faulting client. Each partition has its own lock, so 
+ *              the policy is concurrent; only partition_move_frame locks two partitions.
+ *
+ *  @param      inner Policy used within the partitions.
+ *  @param      nclients Number of partitions, 1 .. VMEM_NFRAMES.
+ *
+ *  @return     The local replacement policy. 
+ ****************************************************************************************/
+const struct policy_ops *local_policy(const struct policy_ops *inner, int nclients);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function creates a policy for sharded replacement. Pages are 
+ *              assigned to shards by hash (page % nshards), each shard owns a partition 
+ *              of the frames with a separate instance of the inner policy and its own 
+ *              lock. Frames are moved from cold to hot shards with partition_donor / 
+ *              partition_move_frame.
+ *
+ *  @param      inner Policy used within the shards.
+ *  @param      nshards Number of shards, 1 .. POLICY_MAXSHARDS.
+ *
+ *  @return     The sharded replacement policy. 
+ ****************************************************************************************/
+const struct policy_ops *shard_policy(const struct policy_ops *inner, int nshards);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function returns the partition a page belongs to
+ *              (local_policy: its client, shard_policy: its shard).
+ *
+ *  @param      page Global page number.
+ *
+ *  @return     Partition number.
+ ****************************************************************************************/
+int partition_of_page(int page);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function copies the frames of a partition. The list may be out of 
+ *              date when it is used, since frames move between partitions.
+ *
+ *  @param      part Partition number.
+ *  @param      frames Array of VMEM_NFRAMES elements set to the frames of the 
+ *              partition; NULL: only count them.
+ *
+ *  @return     Number of frames of the partition.
+ ****************************************************************************************/
+int partition_frames(int part, int *frames);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function decides whether a shard without unused frames should grow. 
+ *              This is the case if its fault rate per frame exceeds the one of the 
+ *              coldest shard by PARTITION_SKEW. At most one frame is moved per time 
+ *              interval, so a donor returned must be passed to partition_move_frame.
+ *
+ *  @param      part The faulting shard.
+ *
+ *  @return     The shard that should give a frame to part; VOID_IDX: none.
+ ****************************************************************************************/
+int partition_donor(int part);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function moves a frame between partitions. An unused frame is 
+ *              preferred, otherwise the inner policy of the donor chooses it 
+ *              (choose_victim is called with page VOID_IDX). The donor instance 
+ *              releases the frame and renumbers its last frame (on_renumber), the 
+ *              receiving instance gets it with the next on_fault; inner policies 
+ *              without on_renumber are restarted. Both partitions are locked in the 
+ *              order of their numbers. The frame is claimed with the locks held before 
+ *              it moves, so a frame being loaded or evicted by another thread stays in 
+ *              the donor. The caller must evict the page stored in the frame.
+ *
+ *  @param      from Donor partition.
+ *  @param      to Receiving partition.
+ *  @param      claim Function that claims a frame for the caller; false: the frame 
+ *              is in use by another thread. Called with both partitions locked.
+ *  @param      arg Argument passed to claim.
+ *
+ *  @return     The moved frame; VOID_IDX: no frame could be claimed, nothing moved.
+ ****************************************************************************************/
+int partition_move_frame(int from, int to, bool (*claim)(int frame, void *arg), void *arg);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function loads a policy from a shared object. 
+ *              The program exits if the policy cannot be loaded.
+ *
+ *  @param      path Path of the shared object.
+ *
+ *  @return     The policy exported by the shared object.
+ ****************************************************************************************/
+const struct policy_ops *load_policy(const char *path);
+
+#endif /* POLICY_H */
@@ -0,0 +1,106 @@
+/**
+ * @file ptbench.c
+ * @date Oct 2026
+ * @brief Benchmark comparing the lookup latency of the flat page table and the 
+ *        hashed inverted page table. 
+ *        Both tables are filled with the same set of resident pages. Then the same 
+ *        sequence of random page numbers is translated by both tables.
+ *        The results are written to stdout as JSON, see bench.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "vmem.h"
+#include "ipt.h"
+#include "latency.h"
+#include "bench.h"
+#include "my_rand.h"
+
+#define NLOOKUPS   (1 << 20)  //!< Number of lookups per measurement
+#define SEED_BENCH 2806       //!< Seed for selecting resident pages and lookup sequence
+
+static struct vmem_struct *vmem;     //!< Local (not shared) virtual memory with one flat page table
+static int lookups[NLOOKUPS];        //!< Page numbers to be translated
+static volatile int sink;            //!< Keeps the compiler from dropping the lookups
+
+/**
+ *****************************************************************************************
+ *  @brief      This function translates all pages of the lookup sequence, see bench_fn.
+ *
+ *  @param      arg Page table to be used (int *).
+ *
+ *  @return     Time per lookup in nanoseconds.
+ ****************************************************************************************/
+static double measure(void *arg) {
+    int pt_mode = *(int *) arg;
+    int hits = 0;
+    long long start = latency_now();
+    for (int i = 0; i < NLOOKUPS; i++) {
+        int frame = (pt_mode == VMEM_PT_INVERTED) ? ipt_lookup(vmem, VMEM_ASID_DEFAULT, lookups[i]) 
+                                                  : vmem->pt[lookups[i]].frame;
+        hits += (frame != VOID_IDX);
+    }
+    double t = (double) (latency_now() - start) / NLOOKUPS;
+    sink = hits;
+    return t;
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function measures a page table and prints the result.
+ *
+ *  @param      pt_mode Page table to be used.
+ *  @param      name Name of the page table.
+ *  @param      bytes Size of the page table.
+ *
+ *  @return     void
+ ****************************************************************************************/
+static void bench_table(int pt_mode, const char *name, size_t bytes) {
+    struct bench_result r = { "pt_lookup" };
+    snprintf(r.params, sizeof(r.params), "\"table\": \"%s\", \"bytes\": %zu", name, bytes);
+    snprintf(r.unit, sizeof(r.unit), "ns/lookup");
+    bench_measure(&r, measure, &pt_mode);
+    bench_json_result(stdout, &r);
+}
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (!bench_param(argv[i])) {
+            fprintf(stderr, "Usage : ptbench [-warmup=<n>] [-reps=<n>]\n");
+            return EXIT_FAILURE;
+        }
+    }
+    vmem = calloc(1, SHMSIZE(1));
+    if (!vmem) {
+        perror("ptbench: calloc failed");
+        return EXIT_FAILURE;
+    }
+    ipt_init(vmem);
+    for (int i = 0; i < VMEM_NPAGES; i++) {
+        vmem->pt[i].flags = 0;
+        vmem->pt[i].frame = VOID_IDX;
+    }
+
+    // make a random set of VMEM_NFRAMES pages resident in both tables
+    my_srand(SEED_BENCH);
+    for (int frame = 0; frame < VMEM_NFRAMES; frame++) {
+        int page;
+        do {
+            page = my_rand() % VMEM_NPAGES;
+        } while (vmem->pt[page].frame != VOID_IDX);
+        vmem->pt[page].frame = frame;
+        vmem->pt[page].flags = PTF_PRESENT;
+        ipt_insert(vmem, VMEM_ASID_DEFAULT, page, frame);
+    }
+    for (int i = 0; i < NLOOKUPS; i++) {
+        lookups[i] = my_rand() % VMEM_NPAGES;
+    }
+
+    bench_json_begin(stdout, "ptbench");
+    bench_table(VMEM_PT_FLAT, "flat", VMEM_NPAGES * sizeof(struct pt_entry));
+    bench_table(VMEM_PT_INVERTED, "inverted", sizeof(vmem->ipt) + sizeof(vmem->ipt_hash));
+    bench_json_end(stdout);
+    return 0;
+}
+
+// EOF
@@ -0,0 +1,68 @@
+/**
+ * @file quota.c
+ * @date Oct 2026
+ * @brief This module implements the dynamic frame quotas of mmanage, see quota.h.
+ */
+
+#include <stdbool.h>
+#include "quota.h"
+#include "policy.h"
+#include "pff.h"
+#include "vmem.h"
+
+static int nclients = 1;                        //!< Number of clients
+static struct pff_window pff;                   //!< Page fault frequency of the clients
+static bool grown[VMEM_MAXCLIENTS];             //!< Quota has grown during the current window
+static long grows[VMEM_MAXCLIENTS];             //!< Number of frames added to the quota
+static long shrinks[VMEM_MAXCLIENTS];           //!< Number of frames taken from the quota
+
+/**
+ *****************************************************************************************
+ *  @brief      This function returns the PFF a client is judged by.
+ ****************************************************************************************/
+static int rate(int c) {
+    if (!pff_running(&pff, c)) {
+        return 0;   // not running
+    }
+    return pff.pff[c];
+}
+
+void quota_init(int n) {
+    nclients = n;
+    pff_init(&pff, QUOTA_WINDOW, n);
+}
+
+void quota_update(struct msg m) {
+    if (pff_update(&pff, m)) {
+        grown[m.client] = false;
+    }
+}
+
+int quota_donor(int client) {
+    int donor = VOID_IDX;
+    if (grown[client] || (pff.pff[client] <= QUOTA_HIGH)) {
+        return VOID_IDX;
+    }
+    for (int c = 0; c < nclients; c++) {
+        if ((c != client) && (rate(c) != VOID_IDX) && (rate(c) < QUOTA_LOW)
+            && (partition_frames(c, NULL) > QUOTA_MINFRAMES)
+            && ((donor == VOID_IDX) || (rate(c) < rate(donor)))) {
+            donor = c;
+        }
+    }
+    if (donor != VOID_IDX) {
+        grown[client] = true;
+        grows[client]++;
+        shrinks[donor]++;
+    }
+    return donor;
+}
+
+void quota_report(FILE *f, const int *resident) {
+    for (int c = 0; c < nclients; c++) {
+        fprintf(f, "Client %d: quota %d frames, resident %d pages, %d faults per 1000 accesses, +%ld/-%ld frames\n",
+                c, partition_frames(c, NULL), resident[c], pff.pff[c], grows[c], shrinks[c]);
+    }
+}
+
+// EOF
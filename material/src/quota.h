@@ -0,0 +1,68 @@
+/**
+ * @file quota.h
+ * @date Oct 2026
+ * @brief Header file of the dynamic frame quotas of mmanage.
+ *        With local replacement each client owns a partition of the frames, its
+ *        quota. The page fault frequency (PFF) of each client is measured over
+ *        windows of QUOTA_WINDOW memory accesses (g_count, see pff.h). A client whose PFF
+ *        exceeds QUOTA_HIGH gets a frame of the client with the lowest PFF below
+ *        QUOTA_LOW; the quota of that client shrinks. Clients that have stopped
+ *        sending messages count as PFF 0.
+ *
+ *        This module only decides. mmanage moves the frames with partition_move_frame.
+ */
+
+#ifndef QUOTA_H
+#define QUOTA_H
+
+#include <stdio.h>
+#include "syncdataexchange.h"
+
+#define QUOTA_WINDOW     100    //!< Memory accesses per measurement window of a client
+#define QUOTA_HIGH       60     //!< Page faults per 1000 accesses above which the quota grows
+#define QUOTA_LOW        30     //!< Page faults per 1000 accesses below which the quota may shrink
+#define QUOTA_MINFRAMES  1      //!< Min. quota of a client
+
+/**
+ *****************************************************************************************
+ *  @brief      This function initializes the quotas.
+ *
+ *  @param      n Number of clients.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void quota_init(int n);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function accounts a message received from a client.
+ *
+ *  @param      m The message.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void quota_update(struct msg m);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function decides whether the quota of a client without unused
+ *              frames should grow. At most one frame is added per window of the client.
+ *
+ *  @param      client The faulting client.
+ *
+ *  @return     The client that should give a frame; VOID_IDX: none.
+ ****************************************************************************************/
+int quota_donor(int client);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function prints quota, resident set and PFF of each client.
+ *
+ *  @param      f Output file.
+ *  @param      resident Number of resident pages of each client.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void quota_report(FILE *f, const int *resident);
+
+#endif /* QUOTA_H */
@@ -0,0 +1,131 @@
+/**
+ * @file shmseg.c
+ * @date Oct 2026
+ * @brief This module implements the shared memory segments, see shmseg.h.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/vfs.h>
+#include <linux/magic.h>
+#endif
+#include "shmseg.h"
+#include "error.h"
+
+/**
+ *****************************************************************************************
+ *  @brief      This function builds the path of a segment in hugetlbfs.
+ ****************************************************************************************/
+static void hugetlb_path(const char *name, char *path, size_t size) {
+    snprintf(path, size, "%s%s", SHMSEG_HUGETLBFS, name);
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function maps a segment of hugetlbfs.
+ *
+ *  @return     false if hugetlbfs is not mounted or has not enough huge pages.
+ ****************************************************************************************/
+static bool create_hugetlb(struct shmseg *seg, const char *name, size_t size) {
+#ifdef __linux__
+    char path[64];
+    struct statfs fs;
+    if ((statfs(SHMSEG_HUGETLBFS, &fs) == -1) || (fs.f_type != HUGETLBFS_MAGIC)) {
+        return false;
+    }
+    hugetlb_path(name, path, sizeof(path));
+    int fd = open(path, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd == -1) {
+        return false;
+    }
+    // the huge pages are reserved by mmap
+    size = (size + fs.f_bsize - 1) / fs.f_bsize * fs.f_bsize;
+    void *addr = (ftruncate(fd, size) == -1) ? MAP_FAILED
+               : mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        unlink(path);
+        return false;
+    }
+    seg->addr = addr;
+    seg->size = size;
+    seg->backing = "hugetlb";
+    return true;
+#else
+    return false;
+#endif
+}
+
+void shmseg_create(struct shmseg *seg, const char *name, size_t size, bool hugepages) {
+    char path[64];
+    // segments of a previous run; clients still mapping them are not affected
+    shm_unlink(name);
+    hugetlb_path(name, path, sizeof(path));
+    unlink(path);
+
+    if (hugepages && create_hugetlb(seg, name, size)) {
+        return;
+    }
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    TEST_AND_EXIT_ERRNO(fd == -1, "shmseg_create: shm_open failed");
+    TEST_AND_EXIT_ERRNO(ftruncate(fd, size) == -1, "shmseg_create: ftruncate failed");
+    seg->addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    TEST_AND_EXIT_ERRNO(seg->addr == MAP_FAILED, "shmseg_create: mmap failed");
+    close(fd);
+    seg->size = size;
+    seg->backing = "shm";
+#ifdef MADV_HUGEPAGE
+    // the pages are allocated by this process, so the advice holds for the clients as well
+    if (hugepages && (madvise(seg->addr, size, MADV_HUGEPAGE) == 0)) {
+        seg->backing = "thp";
+    }
+#endif
+    if (hugepages && (0 != strcmp(seg->backing, "thp"))) {
+        fprintf(stderr, "shmseg_create: no huge pages for %s, using normal pages\n", name);
+    }
+}
+
+bool shmseg_attach(struct shmseg *seg, const char *name) {
+    char path[64];
+    struct stat st;
+    const char *backing = "shm";
+    int fd = shm_open(name, O_RDWR, 0);
+    if ((fd == -1) && (errno == ENOENT)) {
+        hugetlb_path(name, path, sizeof(path));
+        fd = open(path, O_RDWR);
+        backing = "hugetlb";
+    }
+    if (fd == -1) {
+        return false;
+    }
+    TEST_AND_EXIT_ERRNO(fstat(fd, &st) == -1, "shmseg_attach: fstat failed");
+    seg->addr = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    TEST_AND_EXIT_ERRNO(seg->addr == MAP_FAILED, "shmseg_attach: mmap failed");
+    close(fd);
+    seg->size = st.st_size;
+    seg->backing = backing;
+    return true;
+}
+
+void shmseg_destroy(struct shmseg *seg, const char *name) {
+    char path[64];
+    if (seg->addr == NULL) {
+        return;
+    }
+    if (0 == strcmp(seg->backing, "hugetlb")) {
+        hugetlb_path(name, path, sizeof(path));
+        TEST_AND_EXIT_ERRNO(unlink(path) == -1, "shmseg_destroy: unlink failed");
+    } else {
+        TEST_AND_EXIT_ERRNO(shm_unlink(name) == -1, "shmseg_destroy: shm_unlink failed");
+    }
+    TEST_AND_EXIT_ERRNO(munmap(seg->addr, seg->size) == -1, "shmseg_destroy: munmap failed");
+    seg->addr = NULL;
+}
+
+// EOF
@@ -0,0 +1,73 @@
+/**
+ * @file shmseg.h
+ * @date Oct 2026
+ * @brief Header file of the shared memory segments of mmanage and its clients.
+ *        A segment is a POSIX shared memory object, found by its name: mmanage
+ *        creates it, the clients map it from any working directory. mmanage removes
+ *        the segment of a previous run when it creates a new one and unlinks it at
+ *        exit, so no segment survives a run (see make clean after a crash).
+ *
+ *        With huge pages the segment is created in the hugetlbfs mounted at
+ *        SHMSEG_HUGETLBFS, which needs reserved huge pages
+ *        (/proc/sys/vm/nr_hugepages) and write access to the mount point. Otherwise
+ *        the segment stays in /dev/shm and the mapping is advised to use transparent
+ *        huge pages, which takes effect if
+ *        /sys/kernel/mm/transparent_hugepage/shmem_enabled allows it. Both only pay
+ *        off for segments of megabytes, i.e. many frames or clients.
+ */
+
+#ifndef SHMSEG_H
+#define SHMSEG_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#define SHMSEG_HUGETLBFS "/dev/hugepages" //!< Mount point of hugetlbfs searched for segments
+
+/**
+ * A mapped segment
+ */
+struct shmseg {
+    void *addr;             //!< Start of the mapping; NULL if not mapped
+    size_t size;            //!< Size of the mapping; on hugetlbfs a multiple of the huge page size
+    const char *backing;    //!< "shm", "thp" (transparent huge pages) or "hugetlb"
+};
+
+/**
+ *****************************************************************************************
+ *  @brief      This function creates and maps a segment. A segment of the same name
+ *              left by a previous run is removed first. The segment is zero-filled.
+ *
+ *  @param      seg Segment to be set up.
+ *  @param      name Name of the segment, starting with '/'.
+ *  @param      size Size of the segment in bytes.
+ *  @param      hugepages Back the segment by huge pages if possible.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void shmseg_create(struct shmseg *seg, const char *name, size_t size, bool hugepages);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function maps a segment created by shmseg_create in another process.
+ *
+ *  @param      seg Segment to be set up.
+ *  @param      name Name of the segment, starting with '/'.
+ *
+ *  @return     false if there is no such segment, errno is set.
+ ****************************************************************************************/
+bool shmseg_attach(struct shmseg *seg, const char *name);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function unmaps a segment created by shmseg_create and removes it.
+ *              Processes that still map the segment keep their mapping.
+ *
+ *  @param      seg Segment created by shmseg_create.
+ *  @param      name Name of the segment.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void shmseg_destroy(struct shmseg *seg, const char *name);
+
+#endif /* SHMSEG_H */
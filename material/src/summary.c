@@ -0,0 +1,105 @@
+/**
+ * @file summary.c
+ * @date Oct 2026
+ * @brief This module implements the run summary records, see summary.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "summary.h"
+#include "error.h"
+
+/**
+ * A value of the record, already formatted
+ */
+struct field {
+    const char *name;       //!< Name of the value
+    char *value;            //!< Formatted value; text without quotes
+    bool text;              //!< Value must be quoted
+};
+
+static struct field fields[SUMMARY_MAXFIELDS]; //!< Values of the current record
+static int nfields = 0;                        //!< Number of values of the current record
+
+/**
+ *****************************************************************************************
+ *  @brief      This function adds a formatted value to the record.
+ ****************************************************************************************/
+static void add_field(const char *name, const char *value, bool text) {
+    TEST_AND_EXIT(nfields == SUMMARY_MAXFIELDS, (stderr, "summary: too many values\n"));
+    fields[nfields].name = name;
+    fields[nfields].value = strdup(value);
+    TEST_AND_EXIT_ERRNO(!fields[nfields].value, "summary: strdup failed");
+    fields[nfields].text = text;
+    nfields++;
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function writes a text value quoted for CSV or JSON.
+ ****************************************************************************************/
+static void put_text(FILE *f, const char *s, bool csv) {
+    fputc('"', f);
+    for (; *s; s++) {
+        if (csv && (*s == '"')) {
+            fputs("\"\"", f);
+        } else if (!csv && ((*s == '"') || (*s == '\\'))) {
+            fprintf(f, "\\%c", *s);
+        } else if (!csv && ((unsigned char) *s < 0x20)) {
+            fprintf(f, "\\u%04x", *s);
+        } else {
+            fputc(*s, f);
+        }
+    }
+    fputc('"', f);
+}
+
+void summary_int(const char *name, long value) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%ld", value);
+    add_field(name, buf, false);
+}
+
+void summary_real(const char *name, double value) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.6g", value);
+    add_field(name, buf, false);
+}
+
+void summary_text(const char *name, const char *value) {
+    add_field(name, value, true);
+}
+
+void summary_write(const char *path) {
+    size_t len = strlen(path);
+    bool csv = (len >= 4) && (0 == strcasecmp(path + len - 4, ".csv"));
+    FILE *f = fopen(path, "a");
+    TEST_AND_EXIT_ERRNO(!f, "summary: cannot open summary file");
+    TEST_AND_EXIT_ERRNO(fseek(f, 0, SEEK_END) == -1, "summary: cannot position in summary file");
+    if (csv && (ftell(f) == 0)) {
+        for (int i = 0; i < nfields; i++) {
+            fprintf(f, "%s%s", i ? "," : "", fields[i].name);
+        }
+        fputc('\n', f);
+    }
+    fputs(csv ? "" : "{", f);
+    for (int i = 0; i < nfields; i++) {
+        fputs(i ? (csv ? "," : ", ") : "", f);
+        if (!csv) {
+            fprintf(f, "\"%s\": ", fields[i].name);
+        }
+        if (fields[i].text) {
+            put_text(f, fields[i].value, csv);
+        } else {
+            fputs(fields[i].value, f);
+        }
+        free(fields[i].value);
+    }
+    fputs(csv ? "\n" : "}\n", f);
+    nfields = 0;
+    TEST_AND_EXIT_ERRNO(fclose(f) == EOF, "summary: error writing summary file");
+}
+
+// EOF
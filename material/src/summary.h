@@ -0,0 +1,42 @@
+/**
+ * @file summary.h
+ * @date Oct 2026
+ * @brief Header file of the run summary records.
+ *        A record is a list of named values, collected with summary_int, summary_real
+ *        and summary_text and appended to a file with summary_write: as a CSV line if
+ *        the file name ends with ".csv", otherwise as a JSON object on one line (JSON
+ *        Lines). A new CSV file starts with a header line of the names, so all
+ *        records of a CSV file must have the same fields.
+ *        Many runs can append to the same file; the records are merged by the
+ *        aggregate script.
+ */
+
+#ifndef SUMMARY_H
+#define SUMMARY_H
+
+#define SUMMARY_MAXFIELDS 48    //!< Max. number of values of a record
+
+/**
+ *****************************************************************************************
+ *  @brief      These functions add a value to the record.
+ *
+ *  @param      name Name of the value; a string constant.
+ *  @param      value The value. Text is copied and may contain any character.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void summary_int(const char *name, long value);
+void summary_real(const char *name, double value);
+void summary_text(const char *name, const char *value);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function appends the record to a file and starts a new record.
+ *
+ *  @param      path Name of the file; ".csv": CSV, otherwise JSON Lines.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void summary_write(const char *path);
+
+#endif /* SUMMARY_H */
@@ -0,0 +1,185 @@
+/**
+ * @file swapslot.c
+ * @date Oct 2026
+ * @brief This module implements the log-structured swap slot allocator.
+ *        Write-back appends at the log head, so the pagefile is written 
+ *        sequentially. The cleaner selects the full segment with the fewest 
+ *        live slots, drops slots of pages that are resident and copies the 
+ *        remaining live slots to the log head.
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include "swapslot.h"
+#include "error.h"
+
+#define SEG_FREE 0                     //!< Segment contains no live slot and is not the log head
+#define SEG_OPEN 1                     //!< Segment is the log head
+#define SEG_FULL 2                     //!< All slots of the segment have been written
+
+#define LOG_SLOT(seg, i) (npages + (seg) * SWAP_SEGPAGES + (i)) //!< Slot number of slot i of a segment
+
+static int fd = -1;                    //!< Pagefile
+static int npages = VMEM_NPAGES;       //!< Number of pages (home slots)
+static int nsegments = (2 * VMEM_NPAGES) / SWAP_SEGPAGES; //!< Number of log segments
+static int slot_of[VMEM_MAXPAGES];     //!< Current slot of each page; VOID_IDX: no valid copy
+static bool resident[VMEM_MAXPAGES];   //!< Page is in memory
+static int owner[SWAP_MAXSEGMENTS * SWAP_SEGPAGES]; //!< Page stored in a log slot; VOID_IDX: stale or unused
+static int seg_state[SWAP_MAXSEGMENTS]; //!< SEG_*
+static int seg_live[SWAP_MAXSEGMENTS]; //!< Number of live slots per segment
+static int nfree = 0;                  //!< Number of free segments
+static int head_seg = VOID_IDX;        //!< Segment of the log head
+static int head_next = 0;              //!< Next unused slot in head segment
+static struct swapslot_stats stats;
+
+static off_t slot_offset(int slot) {
+    return (off_t) slot * VMEM_PAGESIZE;
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function marks the current slot of a page stale.
+ ****************************************************************************************/
+static void release_slot(int pageNo) {
+    int slot = slot_of[pageNo];
+    if (slot >= npages) {
+        int log_idx = slot - npages;
+        owner[log_idx] = VOID_IDX;
+        seg_live[log_idx / SWAP_SEGPAGES]--;
+        if ((seg_live[log_idx / SWAP_SEGPAGES] == 0) && (seg_state[log_idx / SWAP_SEGPAGES] == SEG_FULL)) {
+            seg_state[log_idx / SWAP_SEGPAGES] = SEG_FREE;
+            nfree++;
+        }
+    }
+    slot_of[pageNo] = VOID_IDX;
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function compacts the full segment with the fewest live slots.
+ *
+ *  @return     false if there is no segment to be compacted.
+ ****************************************************************************************/
+static bool clean_one_segment(void);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function closes the segment of the log head.
+ ****************************************************************************************/
+static void close_head(void) {
+    if (head_seg != VOID_IDX) {
+        seg_state[head_seg] = (seg_live[head_seg] == 0) ? SEG_FREE : SEG_FULL;
+        nfree += (seg_state[head_seg] == SEG_FREE);
+        head_seg = VOID_IDX;
+    }
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function appends a page at the log head.
+ *
+ *  @param      for_cleaner The cleaner may use the reserved segments.
+ ****************************************************************************************/
+static void append(int pageNo, const unsigned char *buf, bool for_cleaner) {
+    if ((head_seg == VOID_IDX) || (head_next == SWAP_SEGPAGES)) {
+        close_head();
+        while (!for_cleaner && (nfree <= SWAP_RESERVE) && clean_one_segment());
+    }
+    // the cleaner may have opened a new log head
+    if ((head_seg == VOID_IDX) || (head_next == SWAP_SEGPAGES)) {
+        close_head();
+        TEST_AND_EXIT(nfree == 0, (stderr, "swapslot: no free segment\n"));
+        // take the lowest free segment
+        for (head_seg = 0; seg_state[head_seg] != SEG_FREE; head_seg++);
+        seg_state[head_seg] = SEG_OPEN;
+        nfree--;
+        head_next = 0;
+    }
+    int slot = LOG_SLOT(head_seg, head_next);
+    TEST_AND_EXIT_ERRNO(pwrite(fd, buf, VMEM_PAGESIZE, slot_offset(slot)) != VMEM_PAGESIZE, "Error writing page to swap slot");
+    head_next++;
+    release_slot(pageNo);
+    owner[slot - npages] = pageNo;
+    seg_live[head_seg]++;
+    slot_of[pageNo] = slot;
+}
+
+bool clean_one_segment(void) {
+    int victim = VOID_IDX;
+    for (int s = 0; s < nsegments; s++) {
+        if ((seg_state[s] == SEG_FULL) && ((victim == VOID_IDX) || (seg_live[s] < seg_live[victim]))) {
+            victim = s;
+        }
+    }
+    if (victim == VOID_IDX) return false;
+
+    for (int i = 0; (i < SWAP_SEGPAGES) && (seg_state[victim] == SEG_FULL); i++) {
+        int page = owner[LOG_SLOT(victim, i) - npages];
+        if (page == VOID_IDX) continue;
+        if (resident[page]) {
+            // a clean resident page will be written again when it is evicted
+            release_slot(page);
+            stats.slots_reclaimed++;
+        } else {
+            unsigned char buf[VMEM_PAGESIZE];
+            TEST_AND_EXIT_ERRNO(pread(fd, buf, VMEM_PAGESIZE, slot_offset(LOG_SLOT(victim, i))) != VMEM_PAGESIZE, 
+                                "Error reading swap slot");
+            append(page, buf, true);
+            stats.slots_copied++;
+        }
+    }
+    stats.segments_cleaned++;
+    return true;
+}
+
+void swapslot_init(int pagefile_fd, int pages) {
+    TEST_AND_EXIT((pages <= 0) || (pages > VMEM_MAXPAGES), (stderr, "swapslot_init: number of pages out of range\n"));
+    fd = pagefile_fd;
+    npages = pages;
+    nsegments = (2 * npages) / SWAP_SEGPAGES;
+    for (int i = 0; i < npages; i++) {
+        slot_of[i] = i;
+        resident[i] = false;
+    }
+    for (int i = 0; i < nsegments * SWAP_SEGPAGES; i++) {
+        owner[i] = VOID_IDX;
+    }
+    for (int s = 0; s < nsegments; s++) {
+        seg_state[s] = SEG_FREE;
+        seg_live[s] = 0;
+    }
+    nfree = nsegments;
+    head_seg = VOID_IDX;
+    memset(&stats, 0, sizeof(stats));
+}
+
+void swapslot_read(int pageNo, unsigned char *buf) {
+    TEST_AND_EXIT(slot_of[pageNo] == VOID_IDX, (stderr, "swapslot_read: no valid copy of page %d\n", pageNo));
+    TEST_AND_EXIT_ERRNO(pread(fd, buf, VMEM_PAGESIZE, slot_offset(slot_of[pageNo])) != VMEM_PAGESIZE, 
+                        "Error reading page from swap slot");
+    resident[pageNo] = true;
+}
+
+void swapslot_write(int pageNo, const unsigned char *buf) {
+    append(pageNo, buf, false);
+    resident[pageNo] = false;
+    stats.appends++;
+}
+
+bool swapslot_evict_clean(int pageNo) {
+    resident[pageNo] = false;
+    return slot_of[pageNo] != VOID_IDX;
+}
+
+void swapslot_clean(void) {
+    // background cleaning if less than a quarter of the segments is free
+    if (nfree < nsegments / 4) {
+        clean_one_segment();
+    }
+}
+
+void get_swapslot_stats(struct swapslot_stats *s) {
+    *s = stats;
+}
+
+// EOF
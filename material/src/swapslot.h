@@ -0,0 +1,99 @@
+/**
+ * @file swapslot.h
+ * @date Oct 2026
+ * @brief Header file of the log-structured swap slot allocator.
+ *        Evicted pages are appended sequentially to segments at the end of the 
+ *        pagefile. A page -> slot map locates the current copy of each page. 
+ *        Stale slots are reclaimed by a cleaner that compacts segments.
+ *
+ *        Pagefile layout: slots 0 .. npages - 1 hold the initial contents of 
+ *        the pages (home slots). They are followed by 2 * npages / SWAP_SEGPAGES 
+ *        log segments of SWAP_SEGPAGES slots each. npages is the number of pages 
+ *        in the pagefile, VMEM_NPAGES per client.
+ */
+
+#ifndef SWAPSLOT_H
+#define SWAPSLOT_H
+
+#include <stdbool.h>
+#include "vmem.h"
+
+#define SWAP_SEGPAGES   8                                  //!< Slots per segment
+#define SWAP_MAXSEGMENTS ((2 * VMEM_MAXPAGES) / SWAP_SEGPAGES) //!< Max. number of log segments
+#define SWAP_RESERVE    1                                  //!< Free segments kept for the cleaner
+
+/**
+ * Counters of the swap slot allocator
+ */
+struct swapslot_stats {
+    long appends;              //!< Number of pages appended by write-back
+    long segments_cleaned;     //!< Number of segments compacted by the cleaner
+    long slots_copied;         //!< Number of live slots copied by the cleaner
+    long slots_reclaimed;      //!< Number of slots of clean resident pages dropped by the cleaner
+};
+
+/**
+ *****************************************************************************************
+ *  @brief      This function initializes the allocator. All pages are in their home slots.
+ *
+ *  @param      fd File descriptor of the pagefile.
+ *  @param      npages Number of pages in the pagefile, at most VMEM_MAXPAGES.
+ *
+ *  @return     void 
+ ****************************************************************************************/
+void swapslot_init(int fd, int npages);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function reads the current copy of a page. The page is resident 
+ *              afterwards.
+ *
+ *  @param      pageNo Number of the page to be read.
+ *  @param      buf Buffer of VMEM_PAGESIZE bytes.
+ *
+ *  @return     void 
+ ****************************************************************************************/
+void swapslot_read(int pageNo, unsigned char *buf);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function appends a page to the log. Its previous slot becomes stale.
+ *
+ *  @param      pageNo Number of the page to be written.
+ *  @param      buf Buffer of VMEM_PAGESIZE bytes.
+ *
+ *  @return     void 
+ ****************************************************************************************/
+void swapslot_write(int pageNo, const unsigned char *buf);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function notes that a clean page has been removed from memory.
+ *
+ *  @param      pageNo Number of the page.
+ *
+ *  @return     true if a slot holds a valid copy of the page. false if the cleaner 
+ *              has reclaimed the slot; then the page must be written again.
+ ****************************************************************************************/
+bool swapslot_evict_clean(int pageNo);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function compacts one segment if free segments run low.
+ *              It is meant to be called while the manager is idle.
+ *
+ *  @return     void 
+ ****************************************************************************************/
+void swapslot_clean(void);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function reports the counters of the allocator.
+ *
+ *  @param      stats Structure to be filled with the current counters.
+ *
+ *  @return     void 
+ ****************************************************************************************/
+void get_swapslot_stats(struct swapslot_stats *stats);
+
+#endif /* SWAPSLOT_H */
@@ -14,30 +14,54 @@
 
 #include "syncdataexchange.h"
 #include <sys/types.h>
-#include <sys/ipc.h>
 #include <fcntl.h> 
-#include <sys/shm.h>
 #include <semaphore.h>
+#include <errno.h>
+#include <time.h>
+#include "vmem.h"
+#include "latency.h"
+#include "shmseg.h"
 #include "debug.h"
 #include "error.h"
 
-#define SHMKEY_SYNC_COM            "./src/syncdataexchange.h"          //!< First paremater for shared memory generation via ftok function
-#define SHMPROCID_SYNC_COM         3112                                //!< Second paremater for shared memory generation via ftok function
+#define SHMNAME_SYNC_COM           "/sync_vm_simulation"               //!< Name des shared memory, siehe shmseg.h
 
 #define NAMED_SEM_WAKEUP_MMANAGER  "BS_A3_mmanager" //!< Semaphore to inform memory manager about new task
-#define NAMED_SEM_WAKEUP_VMAPP     "BS_A3_vmapp"    //!< Semaphore to inform vmapp that task has been
+#define NAMED_SEM_WAKEUP_VMAPP     "BS_A3_vmapp"    //!< Semaphore to inform vmapp that task has been finished; client n > 0 appends n
 
+/*
+ * Kanal eines Clients im gemeinsamen Speicher
+ */
+struct channel {
+	int pending;       //!< 1: Auftrag liegt vor und wurde vom Server noch nicht gelesen
+	struct msg msg;    //!< Auftrag bzw. Antwort
+};
 
 /*
  * Globale Variablen, daher nur eine Instanz des Moduls pro Programm
  */
 
-static int shm_id = -1;                      //!< Id zum Zugriff auf das shared memory
-static struct msg *sharedData = NULL;
+static struct shmseg shmSeg;                 //!< Shared memory mit den Kanaelen
+static struct channel *sharedData = NULL;    //!< Ein Kanal je Client
 static sem_t *wakeupMManager = SEM_FAILED;   //!< Named semaphores that informs memory manager about a new task
-static sem_t *wakeupVmApp = SEM_FAILED;      //!< Named semaphores that informs vmapp that task has been finished
+static sem_t *wakeupVmApp[VMEM_MAXCLIENTS];  //!< Named semaphores that inform the clients that their task has been finished
 static bool nextOpWaitForMsg = true;         //!< For checking correct order of waitForMsg and reply (sendAck)
 static int refNoForAck = -1;	             //!< waitForMsg stores refCounter of msg for sendAck
+static int ownClient = 0;                    //!< Client: Nummer des eigenen Kanals
+static int clientForAck = -1;                //!< Server: waitForMsg stores channel of msg for sendAck
+static int nextClient = 0;                   //!< Server: Kanal, bei dem die Suche nach dem naechsten Auftrag beginnt
+
+/**
+ * @brief  Diese Funktion bildet den Namen des Semaphors, mit dem ein Client geweckt wird.
+ *         Kanal 0 verwendet den bisherigen Namen.
+ */
+static void vmAppSemName(int client, char *name, size_t size) {
+	if (client == 0) {
+		snprintf(name, size, "%s", NAMED_SEM_WAKEUP_VMAPP);
+	} else {
+		snprintf(name, size, "%s%d", NAMED_SEM_WAKEUP_VMAPP, client);
+	}
+}
 
 /**
  * @brief  Diese Funktion erzeugt die Ressourcen, die zum synchronnen Austausch
@@ -46,41 +70,49 @@ static int refNoForAck = -1;	             //!< waitForMsg stores refCounter of m
  *                  aufgesetzt. Ansonsten für den Client.
  */
 static void setupSyncDataExchangeInternal(bool isServer) {
+	char name[32];
 	// create shared memory for data to be exchanged
 	PRINT_DEBUG((stderr,"setupSyncDataExchangeInternal: Attach to shared memory\n"));
-	key_t shm_key = ftok(SHMKEY_SYNC_COM, SHMPROCID_SYNC_COM);
-	TEST_AND_EXIT_ERRNO(shm_key == -1, "setupSyncDataExchangeInternal:ftok failed!");
-	// Use IPC:CREAT flag for server only
-	shm_id = shmget(shm_key, sizeof(struct msg), 0664 | ((isServer)?IPC_CREAT:0));
-	
-	if (shm_id == -1){
-		fprintf(stderr, "Shared memory from old run might still exists\n");
-		fprintf(stderr, "   Use ipcs -ma for checking shared memory ressources\n");
-		fprintf(stderr, "   Use ipcrm for deleting shared memory ressources\n");
+	// Nur der Server erzeugt das shared memory; ein altes aus einem abgebrochenen Lauf wird dabei entfernt
+	size_t size = VMEM_MAXCLIENTS * sizeof(struct channel);
+	if (isServer) {
+		shmseg_create(&shmSeg, SHMNAME_SYNC_COM, size, false);
+	} else {
+		TEST_AND_EXIT_ERRNO(!shmseg_attach(&shmSeg, SHMNAME_SYNC_COM), "setupSyncDataExchangeInternal: Error attaching shared memory (mmanage not started?)");
 	}
-	
-	TEST_AND_EXIT_ERRNO(shm_id == -1, "setupSyncDataExchangeInternal:shmget failed!");
-	PRINT_DEBUG((stderr, "setupSyncDataExchangeInternal: shmget successfuly allocated %lu bytes\n", sizeof(struct msg)));
-	sharedData = (struct msg *) shmat(shm_id, NULL, 0);
-	TEST_AND_EXIT_ERRNO(sharedData == (struct msg *) -1, "setupSyncDataExchangeInternal: Error attaching shared memory");
+	PRINT_DEBUG((stderr, "setupSyncDataExchangeInternal: shared memory of %lu bytes\n", size));
+	sharedData = (struct channel *) shmSeg.addr;
 	PRINT_DEBUG((stderr, "setupSyncDataExchangeInternal: Shared memory successfuly attached\n"));
 
-	// Server: Delete old instances of the semaphores
+	for (int c = 0; c < VMEM_MAXCLIENTS; c++) {
+		wakeupVmApp[c] = SEM_FAILED;
+	}
+	// Server: Delete old instances of the semaphores and reset the channels
 	if (isServer) {
 		if (sem_unlink(NAMED_SEM_WAKEUP_MMANAGER)) {
 		 TEST_AND_EXIT_ERRNO(errno != ENOENT, "setupSyncDataExchangeInternal: Cannot unlink old instance of semaphore");
 		}
-		if (sem_unlink(NAMED_SEM_WAKEUP_VMAPP)) {
-		 TEST_AND_EXIT_ERRNO(errno != ENOENT, "setupSyncDataExchangeInternal: Cannot unlink old instance of semaphore");
+		for (int c = 0; c < VMEM_MAXCLIENTS; c++) {
+			vmAppSemName(c, name, sizeof(name));
+			if (sem_unlink(name)) {
+			 TEST_AND_EXIT_ERRNO(errno != ENOENT, "setupSyncDataExchangeInternal: Cannot unlink old instance of semaphore");
+			}
+			sharedData[c].pending = 0;
 		}
 	}
 	// create semaphore for sync access
 	wakeupMManager = (isServer) ? sem_open(NAMED_SEM_WAKEUP_MMANAGER, O_CREAT | O_EXCL, 0644, 0)
 							   : sem_open(NAMED_SEM_WAKEUP_MMANAGER, 0);
 	TEST_AND_EXIT_ERRNO(wakeupMManager  == SEM_FAILED, "setupSyncDataExchangeInternal: Error in creating named semaphore");
-	wakeupVmApp = (isServer) ? sem_open(NAMED_SEM_WAKEUP_VMAPP, O_CREAT | O_EXCL, 0644, 0)
-							: sem_open(NAMED_SEM_WAKEUP_VMAPP, 0);
-	TEST_AND_EXIT_ERRNO(wakeupVmApp  == SEM_FAILED, "setupSyncDataExchangeInternal: Error creating named semaphore");
+	// Server: Semaphore aller Kanaele, Client: nur der eigene
+	for (int c = 0; c < VMEM_MAXCLIENTS; c++) {
+		if (isServer || (c == ownClient)) {
+			vmAppSemName(c, name, sizeof(name));
+			wakeupVmApp[c] = (isServer) ? sem_open(name, O_CREAT | O_EXCL, 0644, 0)
+									   : sem_open(name, 0);
+			TEST_AND_EXIT_ERRNO(wakeupVmApp[c]  == SEM_FAILED, "setupSyncDataExchangeInternal: Error creating named semaphore");
+		}
+	}
 	PRINT_DEBUG((stderr, "setupSyncDataExchangeInternal: semaphores successfully created\n"));
 }
 
@@ -89,52 +121,159 @@ void setupSyncDataExchange(void) {
 }
 
 void destroySyncDataExchange(void) {
+	char name[32];
 	// distory shared memory 
-	TEST_AND_EXIT_ERRNO(-1 ==  shmctl(shm_id, IPC_RMID, NULL), "distroySyncDataExchange: shmctl failed"); // Mark vmem for deletion 
-	TEST_AND_EXIT_ERRNO(-1 == shmdt(sharedData), "distroySyncDataExchange: shmdt failed"); // detach shared memory
+	shmseg_destroy(&shmSeg, SHMNAME_SYNC_COM); // unlink and detach shared memory
+	sharedData = NULL;
 	PRINT_DEBUG((stderr, "distroySyncDataExchange: Shared memory successfully detached\n"));
 
 	// distory semaphores
 	TEST_AND_EXIT_ERRNO(sem_close(wakeupMManager) == -1, "distroySyncDataExchange: sem_close failed");
 	TEST_AND_EXIT_ERRNO(sem_unlink(NAMED_SEM_WAKEUP_MMANAGER) == -1, "distroySyncDataExchange: sem_unlink failed");
-	TEST_AND_EXIT_ERRNO(sem_close(wakeupVmApp) == -1, "distroySyncDataExchange: sem_close failed");
-	TEST_AND_EXIT_ERRNO(sem_unlink(NAMED_SEM_WAKEUP_VMAPP) == -1, "distroySyncDataExchange: sem_unlink failed");
+	for (int c = 0; c < VMEM_MAXCLIENTS; c++) {
+		vmAppSemName(c, name, sizeof(name));
+		TEST_AND_EXIT_ERRNO(sem_close(wakeupVmApp[c]) == -1, "distroySyncDataExchange: sem_close failed");
+		TEST_AND_EXIT_ERRNO(sem_unlink(name) == -1, "distroySyncDataExchange: sem_unlink failed");
+	}
 	PRINT_DEBUG((stderr, "distroySyncDataExchange: Semaphore successfully destroyed\n"));
 }
 
-void sendMsgToMmanager(struct msg msg){
-	static int refNo = 0; //!< Number of current reference send to memory manager
-	msg.ref = refNo; // Wird zur Ueberpruefung der Kommunikation hoch gezaehlt.
+void setSyncDataExchangeClient(int client) {
+	TEST_AND_EXIT((client < 0) || (client >= VMEM_MAXCLIENTS), (stderr, "setSyncDataExchangeClient: client out of range\n"));
+	TEST_AND_EXIT(sharedData != NULL, (stderr, "setSyncDataExchangeClient: communication already set up\n"));
+	ownClient = client;
+}
+
+static int clientRefNo = 0; //!< Number of current reference send to memory manager
+static int postedCmd = 0;   //!< Client: Befehl der letzten Message
+static long long postedStamp = 0; //!< Client: Sendezeitpunkt der letzten Message
+static struct latency_hist latFault = { "fault round trip" }; //!< Client: Dauer bis zum ACK eines Page Faults
+static struct latency_hist latOther = { "other round trip" }; //!< Client: Dauer bis zum ACK sonstiger Messages
+
+void postMsgToMmanager(struct msg msg){
+	msg.ref = clientRefNo; // Wird zur Ueberpruefung der Kommunikation hoch gezaehlt.
+	msg.client = ownClient;
+	msg.stamp = latency_on ? latency_now() : 0;
+	postedCmd = msg.cmd;
+	postedStamp = msg.stamp;
 	// Beim ersten Aufruf erzeugt der Client die Datenstrukturen
-	if ((shm_id == -1) && (sharedData == NULL) && (wakeupMManager == SEM_FAILED) && (wakeupVmApp == SEM_FAILED)) {
+	if ((sharedData == NULL) && (wakeupMManager == SEM_FAILED)) {
 		// Erster Aufruf durch den Client
-		TEST_AND_EXIT(((shm_id != -1) || (sharedData != NULL) || (wakeupMManager != SEM_FAILED) || (wakeupVmApp != SEM_FAILED)), 
-					 (stderr, "sendMsgToMmanager:Internal error detected\n"));
 		setupSyncDataExchangeInternal(false);
 	} // end if erzeuge Kommunikationstrukturen
+	struct channel *ch = &sharedData[ownClient];
 	// Uebertrage Daten an den Server
-	*sharedData = msg;
-	TEST_AND_EXIT_ERRNO(sem_post(wakeupMManager) == -1, "sendMsgToMmanager:sem_post failed!");
-	// Warte auf Antwort vom Server
-	TEST_AND_EXIT_ERRNO(sem_wait(wakeupVmApp) == -1, "sendMsgToMmanager:sem_post:sem_wait failed!");
-	TEST_AND_EXIT((sharedData->ref != refNo), (stderr, "Application and memory manager asynchronous"));
-	TEST_AND_EXIT(sharedData->cmd != CMD_ACK, (stderr, "Unexpected answer from memory manager"));
-	refNo++;
-	PRINT_DEBUG((stderr, "Receive Msg form mem manager (cmd = %d, val = %d, ref = %d)\n", sharedData->cmd, sharedData->value, sharedData->ref));
+	ch->msg = msg;
+	ch->pending = 1;
+	TEST_AND_EXIT_ERRNO(sem_post(wakeupMManager) == -1, "postMsgToMmanager:sem_post failed!");
 }
 
-struct msg waitForMsg(void){
-	// Ueberpruefe Reihenfolge waitForMsg und SendAck
-	TEST_AND_EXIT((!nextOpWaitForMsg), (stderr, "waitForMsg:Internal error, waitForMsg call not expected\n"));
-	nextOpWaitForMsg = false;
+bool pollAckFromMmanager(bool wait){
+	struct channel *ch = &sharedData[ownClient];
+	if (wait) {
+		// Warte auf Antwort vom Server
+		TEST_AND_EXIT_ERRNO(sem_wait(wakeupVmApp[ownClient]) == -1, "pollAckFromMmanager:sem_wait failed!");
+	} else if (sem_trywait(wakeupVmApp[ownClient]) == -1) {
+		TEST_AND_EXIT_ERRNO(errno != EAGAIN, "pollAckFromMmanager:sem_trywait failed!");
+		return false;
+	}
+	TEST_AND_EXIT((ch->msg.ref != clientRefNo), (stderr, "Application and memory manager asynchronous"));
+	TEST_AND_EXIT(ch->msg.cmd != CMD_ACK, (stderr, "Unexpected answer from memory manager"));
+	clientRefNo++;
+	if (latency_on) {
+		latency_record((postedCmd == CMD_PAGEFAULT) ? &latFault : &latOther, latency_now() - postedStamp);
+	}
+	PRINT_DEBUG((stderr, "Receive Msg form mem manager (cmd = %d, val = %d, ref = %d)\n", ch->msg.cmd, ch->msg.value, ch->msg.ref));
+	return true;
+}
+
+void sendMsgToMmanager(struct msg msg){
+	postMsgToMmanager(msg);
+	pollAckFromMmanager(true);
+}
+
+void printRoundTripLatency(FILE *f) {
+	latency_report_header(f);
+	latency_report(f, &latFault);
+	latency_report(f, &latOther);
+}
+
+/**
+ * @brief  Diese Funktion wartet auf den naechsten Auftrag eines Clients und nimmt ihn 
+ *         aus dessen Kanal. Sie wird nur vom Thread aufgerufen, der Auftraege empfaengt.
+ */
+static struct msg takeMsg(void);
+
+static struct msg receiveMsg(void) {
 	// Teste Kommunikationsparameter
-	TEST_AND_EXIT(((shm_id == -1) || (sharedData == NULL) || (wakeupMManager == SEM_FAILED) || (wakeupVmApp == SEM_FAILED)), 
+	TEST_AND_EXIT(((sharedData == NULL) || (wakeupMManager == SEM_FAILED)), 
 				 (stderr, "waitForMsg:Internal error detected\n"));
 	// Warte auf Auftrag
 	TEST_AND_EXIT_ERRNO(sem_wait(wakeupMManager) == -1, "waitForMsg:sem_post:sem_wait failed!");
-	TEST_AND_EXIT(sharedData->cmd == CMD_ACK, (stderr, "waitForMsg: Unexpected command from vmapp"));
-	refNoForAck = sharedData->ref;
-	return *sharedData;
+	return takeMsg();
+}
+
+/*
+ * Entnimmt die Message eines Kanals, nachdem sem_wait auf wakeupMManager erfolgreich war.
+ */
+static struct msg takeMsg(void) {
+	// Jeder sem_post gehoert zu genau einem Kanal mit pending == 1
+	int c = nextClient;
+	while (!sharedData[c].pending) {
+		c = (c + 1) % VMEM_MAXCLIENTS;
+		TEST_AND_EXIT(c == nextClient, (stderr, "waitForMsg: No pending message found\n"));
+	}
+	sharedData[c].pending = 0;
+	nextClient = (c + 1) % VMEM_MAXCLIENTS;
+	TEST_AND_EXIT(sharedData[c].msg.cmd == CMD_ACK, (stderr, "waitForMsg: Unexpected command from vmapp"));
+	struct msg msg = sharedData[c].msg;
+	msg.client = c;
+	return msg;
+}
+
+struct msg waitForMsg(void){
+	// Ueberpruefe Reihenfolge waitForMsg und SendAck
+	TEST_AND_EXIT((!nextOpWaitForMsg), (stderr, "waitForMsg:Internal error, waitForMsg call not expected\n"));
+	nextOpWaitForMsg = false;
+	struct msg msg = receiveMsg();
+	refNoForAck = msg.ref;
+	clientForAck = msg.client;
+	return msg;
+}
+
+struct msg waitForNextMsg(void){
+	return receiveMsg();
+}
+
+bool waitForNextMsgTimeout(int timeout_ms, struct msg *msg){
+	struct timespec deadline;
+	TEST_AND_EXIT(((sharedData == NULL) || (wakeupMManager == SEM_FAILED)), 
+				 (stderr, "waitForNextMsgTimeout:Internal error detected\n"));
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += timeout_ms / 1000;
+	deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+	if (deadline.tv_nsec >= 1000000000L) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000L;
+	}
+	while (sem_timedwait(wakeupMManager, &deadline) == -1) {
+		TEST_AND_EXIT_ERRNO((errno != ETIMEDOUT) && (errno != EINTR), "waitForNextMsgTimeout:sem_timedwait failed!");
+		if (errno == ETIMEDOUT) {
+			return false;
+		}
+	}
+	*msg = takeMsg();
+	return true;
+}
+
+void sendAckToClient(struct msg msg){
+	TEST_AND_EXIT(((sharedData == NULL) || (msg.client < 0) || (msg.client >= VMEM_MAXCLIENTS)), 
+				 (stderr, "sendAckToClient:Internal error detected\n"));
+	struct msg *reply = &sharedData[msg.client].msg;
+	reply->cmd = CMD_ACK;
+	reply->value = 0;
+	reply->ref = msg.ref;
+	TEST_AND_EXIT_ERRNO(sem_post(wakeupVmApp[msg.client]) == -1, "sendAckToClient:sem_post failed!");
 }
 
 void sendAck(void){
@@ -142,13 +281,10 @@ void sendAck(void){
 	TEST_AND_EXIT((nextOpWaitForMsg), (stderr, "sendAck:Internal error, sendAck call not expected\n"));
 	nextOpWaitForMsg = true;
 	// Teste Kommunikationsparameter
-	TEST_AND_EXIT(((shm_id == -1) || (sharedData == NULL) || (wakeupMManager == SEM_FAILED) || (wakeupVmApp == SEM_FAILED)), 
+	TEST_AND_EXIT(((sharedData == NULL) || (wakeupMManager == SEM_FAILED) || (clientForAck == -1)), 
 				 (stderr, "sendAck:Internal error detected\n"));
-	sharedData->cmd = CMD_ACK;
-	sharedData->value = 0;
-	sharedData->ref = refNoForAck;
-	TEST_AND_EXIT_ERRNO(sem_post(wakeupVmApp) == -1, "sendAck:sem_post failed!");
+	struct msg msg = { .ref = refNoForAck, .client = clientForAck };
+	sendAckToClient(msg);
 }
 
 //EOF
-
@@ -18,12 +18,17 @@
  *
  *          Der Server ist für die Initialiserung und Freigabe der Komponenten 
  *          verantwortlich.
+ *
+ *          Okt 2026: Der Server bedient bis zu VMEM_MAXCLIENTS Clients. Jeder Client
+ *          hat einen eigenen Kanal (Auftrag und Semaphor für die Antwort). Alle Clients
+ *          wecken den Server über einen gemeinsamen Semaphor. 
  * 
  ******************************************************************
  */
 
 #ifndef _SYNCDATAEXCHANGE_H
 #define _SYNCDATAEXCHANGE_H
+#include <stdio.h>
 #include <stdbool.h>
 
 /*
@@ -39,11 +44,25 @@ struct msg {
 	int g_count;
 	/// @brief Fortlaufender Ref-Counter zur Zuordnung zwischen Befehl und Antwort.
 	int ref;
+	/// @brief Kanal des Clients, der den Auftrag erteilt hat. Wird von waitForMsg gesetzt.
+	int client;
+	/// @brief Zweiter Parameter des Befehls
+	int length;
+	/// @brief Dritter Parameter des Befehls
+	int hint;
+	/// @brief Sendezeitpunkt in ns (latency_now), 0: Client misst keine Latenzen.
+	long long stamp;
 };
 
 #define CMD_PAGEFAULT		1	// value gibt die einzulagernde Page mit
 #define CMD_TIME_INTER_VAL   	2	// Ein Time Interval ist abgelaufen
 #define CMD_ACK 		3	// value hat keine Bedeutung
+#define CMD_CHECKPOINT		4	// Zustand des virtuellen Speichers sichern, value hat keine Bedeutung
+#define CMD_ADVISE		5	// Zugriffshinweis hint (VMEM_ADV_*) fuer length Pages ab Page value
+#define CMD_PIN			6	// length Pages ab Page value einlagern und festhalten
+#define CMD_UNPIN		7	// length Pages ab Page value wieder freigeben
+#define CMD_RESET		8	// Speicher fuer den naechsten Lauf in den Anfangszustand versetzen, value: Seed,
+					// hint: Ersetzungsalgorithmus (VMEM_POLICY_*)
 
 /**
  * @brief  Diese Funktion erzeugt die Ressourcen, die zum synchronnen Austausch
@@ -60,6 +79,14 @@ extern void setupSyncDataExchange(void);
  */
 extern void destroySyncDataExchange(void);
 
+/**
+ * @brief   Diese Funktion legt den Kanal fest, über den der Client mit dem Server
+ *          kommuniziert. Sie muss vor dem ersten Aufruf von sendMsgToMmanager 
+ *          aufgerufen werden. Ohne Aufruf wird Kanal 0 verwendet.
+ * @param   client Nummer des Kanals, 0 <= client < VMEM_MAXCLIENTS
+ */
+extern void setSyncDataExchangeClient(int client);
+
 /**
  *****************************************************************************************
  *  @brief      This function sends a message to memory manager and waits for the ACK.
@@ -71,7 +98,39 @@ extern void sendMsgToMmanager(struct msg msg);
 
 /**
  *****************************************************************************************
- *  @brief      This function blocks until a message from vmapp has arrived.
+ *  @brief      Diese Funktion gibt die Histogramme der Dauer vom Senden einer Message 
+ *              bis zum ACK aus (Page Faults und sonstige Messages getrennt). Gemessen 
+ *              wird nur nach latency_enable.
+ *  @param      f Ausgabe
+ * 
+ *  @return     void
+ ****************************************************************************************/
+extern void printRoundTripLatency(FILE *f);
+
+/**
+ *****************************************************************************************
+ *  @brief      Diese Funktion uebergibt eine Message an den memory manager, ohne auf 
+ *              das ACK zu warten. Bis zum ACK darf keine weitere Message gesendet werden.
+ *  @param      msg Message to be send.
+ * 
+ *  @return     void
+ ****************************************************************************************/
+extern void postMsgToMmanager(struct msg msg);
+
+/**
+ *****************************************************************************************
+ *  @brief      Diese Funktion prueft, ob das ACK zur letzten mit postMsgToMmanager 
+ *              gesendeten Message eingetroffen ist.
+ *  @param      wait true: Blockiert bis zum Eintreffen des ACKs.
+ * 
+ *  @return     true, wenn das ACK eingetroffen ist.
+ ****************************************************************************************/
+extern bool pollAckFromMmanager(bool wait);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function blocks until a message from one of the clients has arrived.
+ *              Pending messages of several clients are taken in round robin order.
  *              
  *  @return     Message that has been received 
  ****************************************************************************************/
@@ -79,7 +138,38 @@ extern struct msg waitForMsg(void);
 
 /**
  *****************************************************************************************
- *  @brief      This function sends an ACK to vmapp 
+ *  @brief      This function blocks until a message from one of the clients has arrived.
+ *              Unlike waitForMsg it may be called again before the message has been 
+ *              acknowledged, so messages of different clients can be processed 
+ *              concurrently. Each message must be acknowledged with sendAckToClient.
+ *              
+ *  @return     Message that has been received 
+ ****************************************************************************************/
+extern struct msg waitForNextMsg(void);
+
+/**
+ *****************************************************************************************
+ *  @brief      Wie waitForNextMsg, wartet aber hoechstens timeout_ms Millisekunden.
+ *
+ *  @param      timeout_ms Maximale Wartezeit in Millisekunden.
+ *  @param      msg Wird mit der empfangenen Message gefuellt.
+ *              
+ *  @return     false, wenn innerhalb der Wartezeit keine Message eingetroffen ist.
+ ****************************************************************************************/
+extern bool waitForNextMsgTimeout(int timeout_ms, struct msg *msg);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function sends an ACK for a message received by waitForNextMsg.
+ *              It may be called by any thread of the server.
+ *
+ *  @param      msg The message to be acknowledged.
+ ****************************************************************************************/
+extern void sendAckToClient(struct msg msg);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function sends an ACK to the client of the last message received.
  *
  *  @return     Message that has been received 
  ****************************************************************************************/
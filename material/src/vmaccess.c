@@ -6,11 +6,14 @@
  */
 
 #include "vmaccess.h"
-#include <sys/ipc.h>
-#include <sys/shm.h>
+#include <errno.h>
+#include <string.h>
 
 #include "syncdataexchange.h"
+#include "vmtask.h"
 #include "vmem.h"
+#include "ipt.h"
+#include "shmseg.h"
 #include "debug.h"
 #include "error.h"
 
@@ -19,6 +22,7 @@
  */
 
 static struct vmem_struct *vmem = NULL; //!< Reference to virtual memory
+static int asid = VMEM_ASID_DEFAULT;    //!< Address space (client number) of this application
 
 /**
  * The progression of time is simulated by the counter g_count, which is incremented by 
@@ -40,77 +44,262 @@ static int g_count = 0;    //!< global acces counter as quasi-timestamp - will b
  ****************************************************************************************/
 static void vmem_init(void) {
 
-    /* Create System V shared memory */
-    key_t key = ftok(SHMKEY,SHMPROCID);
-    TEST_AND_EXIT_ERRNO(key == VOID_IDX, "ERROR BY CREATING SYSTEM V SHARED MEMORY");
+    /* Map the shared memory created by mmanage.
+       Its size depends on the page table organisation selected by mmanage. */
+    struct shmseg seg;
+    TEST_AND_EXIT_ERRNO(!shmseg_attach(&seg, VMEM_SHMNAME), "ERROR ATTACH SHARED MEMORY TO VMEM (is mmanage running?)");
+    vmem = seg.addr;
+    TEST_AND_EXIT(asid >= vmem->adm.nclients, (stderr, "Client %d not served by mmanage (%d clients)\n", asid, vmem->adm.nclients));
 
-    /* We are only using the shm, don't set the IPC_CREAT flag */
-    int shmid = shmget(key,SHMSIZE,0664);
-    TEST_AND_EXIT_ERRNO(shmid == VOID_IDX, "ERROR BY CREATING THE SHM");
+    /* Continue time of a restored snapshot */
+    g_count = vmem->adm.start_g_count;
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      These functions lock and unlock the page table entry of a page. mmanage 
+ *              changes it while other clients, or other tasks of this client, access 
+ *              the memory. Accesses to pages with different locks run in parallel.
+ ****************************************************************************************/
+static void vmem_lock(int page) {
+    pthread_mutex_t *lock = &vmem->adm.lock[ipt_lock_idx(vmem, asid, page)];
+    int rc = pthread_mutex_lock(lock);
+    if (rc == EOWNERDEAD) {
+        // a client died during an access; the page tables are consistent anyway
+        rc = pthread_mutex_consistent(lock);
+    }
+    TEST_AND_EXIT(rc != 0, (stderr, "vmem_lock: pthread_mutex_lock failed\n"));
+}
 
-    /* attach shared memory to vmem */
-    vmem = shmat(shmid,NULL,0);
-    TEST_AND_EXIT_ERRNO(vmem == (struct vmen_struct*) VOID_IDX,"ERROR ATTACH SHARED MEMORY TO VMEM");
+static void vmem_unlock(int page) {
+    pthread_mutex_unlock(&vmem->adm.lock[ipt_lock_idx(vmem, asid, page)]);
 }
 
 /**
  *****************************************************************************************
- *  @brief      This function puts a page into memory (if required). Ref Bit of page table
- *              entry will be updated.
- *              If the time window handle by g_count has reached, the window window message
- *              will be send to the memory manager. 
- *              To keep conform with this log files, g_count must be increased before 
- *              the time window will be checked.
- *              vmem_read and vmem_write call this function.
+ *  @brief      This function translates a page number to its frame using the page
+ *              table organisation selected by mmanage.
+ *
+ *  @param      page Number of the page to be translated.
+ *
+ *  @param      frame Frame that stores the page. VOID_IDX if the page is not present.
+ * 
+ *  @return     Reference to the page table flags of the page. NULL if the inverted
+ *              page table is used and the page is not present.
+ ****************************************************************************************/
+static int *vmem_translate(int page, int *frame) {
+    if(vmem->adm.pt_mode == VMEM_PT_INVERTED) {
+        *frame = ipt_lookup(vmem, asid, page);
+        return (*frame == VOID_IDX) ? NULL : &vmem->ipt[*frame].flags;
+    }
+    struct pt_entry *pte = &vmem->pt[asid * VMEM_NPAGES + page];
+    *frame = pte->frame;
+    return &pte->flags;
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function puts a page into memory (if required). 
+ *              vmem_read and vmem_write call this function. It returns with the page 
+ *              table entry locked, the caller unlocks it after the access. If another 
+ *              client's page fault evicts the page before it could be locked, the page 
+ *              fault is repeated. Called by a task of vmtask_run, the page fault 
+ *              suspends only this task.
  *
  *  @param      address The page that stores the contents of this address will be 
  *              put in (if required).
+ *
+ *  @param      frame Frame that stores the page after this call.
  * 
- *  @return     void
+ *  @return     Reference to the page table flags of the page.
  ****************************************************************************************/
-static void vmem_put_page_into_mem(int address) {
+static int *vmem_put_page_into_mem(int address, int *frame) {
     if(vmem == NULL){
         vmem_init();
     }
     int page = address / VMEM_PAGESIZE;
-    if(!(vmem->pt[page].flags & PTF_PRESENT)) {
-        struct msg message_FlagOne = {CMD_PAGEFAULT, page, g_count, 0};
-        sendMsgToMmanager(message_FlagOne);
+    vmem_lock(page);
+    int *flags = vmem_translate(page, frame);
+    while((flags == NULL) || !(*flags & PTF_PRESENT)) {
+        vmem_unlock(page);
+        // another task's page fault may load the page while this task waits for the channel
+        if (!vmtask_wait_channel()) {
+            struct msg message_FlagOne = {CMD_PAGEFAULT, page, g_count, 0};
+            vmtask_send(message_FlagOne);
+        }
+        vmem_lock(page);
+        flags = vmem_translate(page, frame);
     }
+    return flags;
 }
 
-unsigned char vmem_read(int address) {
-    if(vmem == NULL){
-        vmem_init();
+/**
+ *****************************************************************************************
+ *  @brief      This function counts a memory access. 
+ *              If the time window handle by g_count has reached, the window window message
+ *              will be send to the memory manager. 
+ *              To keep conform with this log files, g_count must be increased before 
+ *              the time window will be checked.
+ *
+ *  @return     void
+ ****************************************************************************************/
+static void vmem_count_access(void) {
+    g_count++;
+    if(g_count % TIME_WINDOW == 0) {
+        struct msg message_TimeInterval = {CMD_TIME_INTER_VAL, 0, g_count, 0};
+        vmtask_send(message_TimeInterval);
     }
-    vmem_put_page_into_mem(address);
-    int virtual_pageNr = address / VMEM_PAGESIZE;
-    int startAddress = virtual_pageNr * VMEM_NPAGES;
-    int offset = address - startAddress;
+}
 
-    int pageFrame = vmem->pt[virtual_pageNr].frame;
+unsigned char vmem_read(int address) {
+    int pageFrame;
+    int *flags = vmem_put_page_into_mem(address, &pageFrame);
+    int offset = address % VMEM_PAGESIZE;
     int phyAddress = pageFrame * VMEM_PAGESIZE + offset;
 
-    vmem->pt[virtual_pageNr].flags |= PTF_PRESENT;
+    *flags |= PTF_REF;
     unsigned char data = vmem->mainMemory[phyAddress];
-    g_count++;
+    vmem_unlock(address / VMEM_PAGESIZE);
+    vmem_count_access();
     return data;
 }
 
 void vmem_write(int address, unsigned char data) {
+    int pageFrame;
+    int *flags = vmem_put_page_into_mem(address, &pageFrame);
+    int offset = address % VMEM_PAGESIZE;
+    int phyAddress = pageFrame * VMEM_PAGESIZE + offset;
+
+    *flags |= PTF_REF | PTF_DIRTY;
+    if (vmem->adm.block_size > 0) {
+        vmem->dirty_blocks[pageFrame] |= 1ULL << (offset / vmem->adm.block_size);
+    }
+    vmem->mainMemory[phyAddress] = data;
+    vmem_unlock(address / VMEM_PAGESIZE);
+    vmem_count_access();
+}
+
+void vmem_read_range(int address, unsigned char *buf, int length) {
+    TEST_AND_EXIT((address < 0) || (length < 0) || (address + length > VMEM_VIRTMEMSIZE), 
+                  (stderr, "vmem_read_range: range out of virtual memory\n"));
+    while (length > 0) {
+        int offset = address % VMEM_PAGESIZE;
+        int n = (length < VMEM_PAGESIZE - offset) ? length : VMEM_PAGESIZE - offset;
+        int pageFrame;
+        int *flags = vmem_put_page_into_mem(address, &pageFrame);
+        *flags |= PTF_REF;
+        memcpy(buf, &vmem->mainMemory[pageFrame * VMEM_PAGESIZE + offset], n);
+        vmem_unlock(address / VMEM_PAGESIZE);
+        for (int i = 0; i < n; i++) {
+            vmem_count_access();
+        }
+        address += n;
+        buf += n;
+        length -= n;
+    }
+}
+
+void vmem_write_range(int address, const unsigned char *buf, int length) {
+    TEST_AND_EXIT((address < 0) || (length < 0) || (address + length > VMEM_VIRTMEMSIZE), 
+                  (stderr, "vmem_write_range: range out of virtual memory\n"));
+    while (length > 0) {
+        int offset = address % VMEM_PAGESIZE;
+        int n = (length < VMEM_PAGESIZE - offset) ? length : VMEM_PAGESIZE - offset;
+        int pageFrame;
+        int *flags = vmem_put_page_into_mem(address, &pageFrame);
+        *flags |= PTF_REF | PTF_DIRTY;
+        if (vmem->adm.block_size > 0) {
+            for (int b = offset / vmem->adm.block_size; b <= (offset + n - 1) / vmem->adm.block_size; b++) {
+                vmem->dirty_blocks[pageFrame] |= 1ULL << b;
+            }
+        }
+        memcpy(&vmem->mainMemory[pageFrame * VMEM_PAGESIZE + offset], buf, n);
+        vmem_unlock(address / VMEM_PAGESIZE);
+        for (int i = 0; i < n; i++) {
+            vmem_count_access();
+        }
+        address += n;
+        buf += n;
+        length -= n;
+    }
+}
+
+void vmem_advise(int start, int length, int hint) {
+    TEST_AND_EXIT((start < 0) || (length < 0) || (start + length > VMEM_VIRTMEMSIZE), 
+                  (stderr, "vmem_advise: range out of virtual memory\n"));
+    TEST_AND_EXIT((hint < VMEM_ADV_NORMAL) || (hint > VMEM_ADV_DONTNEED), (stderr, "vmem_advise: unknown hint\n"));
+    if (length == 0) {
+        return;
+    }
     if(vmem == NULL){
         vmem_init();
     }
-    vmem_put_page_into_mem(address);
-    int virtual_pageNr = address / VMEM_PAGESIZE;
-    int startAddress = virtual_pageNr * VMEM_NPAGES;
-    int offset = address - startAddress;
-    int pageFrame = vmem->pt[virtual_pageNr].frame;
+    int first = start / VMEM_PAGESIZE;
+    int last = (start + length - 1) / VMEM_PAGESIZE;
+    struct msg message_Advise = {CMD_ADVISE, first, g_count, 0, 0, last - first + 1, hint};
+    vmtask_send(message_Advise);
+}
 
-    int phyAddress = pageFrame * VMEM_PAGESIZE + offset;
+/**
+ *****************************************************************************************
+ *  @brief      This function sends CMD_PIN or CMD_UNPIN for the pages of a range.
+ *
+ *  @return     true if all pages of the range are pinned afterwards.
+ ****************************************************************************************/
+static bool vmem_pin_range(int cmd, int start, int length) {
+    TEST_AND_EXIT((start < 0) || (length < 1) || (start + length > VMEM_VIRTMEMSIZE), 
+                  (stderr, "vmem_pin: range out of virtual memory\n"));
+    if(vmem == NULL){
+        vmem_init();
+    }
+    int first = start / VMEM_PAGESIZE;
+    int last = (start + length - 1) / VMEM_PAGESIZE;
+    struct msg message_Pin = {cmd, first, g_count, 0, 0, last - first + 1, 0};
+    vmtask_send(message_Pin);
+    // mmanage marks the pages it has pinned
+    bool pinned = true;
+    for (int page = first; page <= last; page++) {
+        int frame;
+        vmem_lock(page);
+        int *flags = vmem_translate(page, &frame);
+        pinned = pinned && (flags != NULL) && (*flags & PTF_PINNED);
+        vmem_unlock(page);
+    }
+    return pinned;
+}
 
-    vmem->pt[virtual_pageNr].flags |= PTF_PRESENT+PTF_DIRTY;
-    vmem->mainMemory[phyAddress] = data;
-    g_count++;
+bool vmem_pin(int start, int length) {
+    return vmem_pin_range(CMD_PIN, start, length);
+}
+
+void vmem_unpin(int start, int length) {
+    vmem_pin_range(CMD_UNPIN, start, length);
+}
+
+void vmem_set_client(int client) {
+    TEST_AND_EXIT(vmem != NULL, (stderr, "vmem_set_client: virtual memory already in use\n"));
+    TEST_AND_EXIT((client < 0) || (client >= VMEM_MAXCLIENTS), (stderr, "vmem_set_client: client out of range\n"));
+    asid = client;
+    setSyncDataExchangeClient(client);
+}
+
+void vmem_checkpoint(void) {
+    if(vmem == NULL){
+        vmem_init();
+    }
+    struct msg message_Checkpoint = {CMD_CHECKPOINT, 0, g_count, 0};
+    vmtask_send(message_Checkpoint);
+}
+
+void vmem_reset(int seed, int policy, const char *label) {
+    TEST_AND_EXIT((policy < VMEM_POLICY_KEEP) || (policy > VMEM_POLICY_ADAPTIVE), (stderr, "vmem_reset: unknown policy\n"));
+    if(vmem == NULL){
+        vmem_init();
+    }
+    // mmanage reads the label while this client waits for the ACK
+    snprintf(vmem->adm.label, sizeof(vmem->adm.label), "%s", label);
+    struct msg message_Reset = {CMD_RESET, seed, g_count, 0, 0, 0, policy};
+    vmtask_send(message_Reset);
+    g_count = vmem->adm.start_g_count;
 }
 // EOF
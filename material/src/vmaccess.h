@@ -4,11 +4,15 @@
  * @date 2010
  * @brief This module defines function to read from and write to
  * virtual memory.
+ * Called by tasks of vmtask.h, a page fault suspends only the faulting task
+ * while the other tasks continue (asynchronous access).
  */
 
 #ifndef VMACCESS_H
 #define VMACCESS_H
 
+#include <stdbool.h>
+
 /**
  *****************************************************************************************
  *  @brief      This function reads an one byte from virtual memory.
@@ -35,4 +39,115 @@ unsigned char vmem_read(int address);
  ****************************************************************************************/
 void vmem_write(int address, unsigned char data);
 
+/**
+ *****************************************************************************************
+ *  @brief      This function asks the memory manager to save the complete state of the 
+ *              virtual memory. If mmanage has been started with -snapshot=<file>,
+ *              later runs can start at this point with -restore=<file>.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void vmem_checkpoint(void);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function asks the memory manager to start a new run: the virtual 
+ *              memory is reset to the state mmanage had at startup (all pages in the 
+ *              pagefile with their initial contents), the counters start from zero and 
+ *              g_count from the start of the run. mmanage finishes the previous run 
+ *              first, i.e. it writes its summary record and renames its logfile. 
+ *              So one mmanage serves many runs. mmanage must serve a single client
+ *              without worker threads and load control.
+ *
+ *  @param      seed Seed of the run, recorded by mmanage.
+ *  @param      policy Page replacement policy of the run, one of VMEM_POLICY_*.
+ *  @param      label Label of the run, e.g. the sort algorithm, recorded by mmanage. 
+ *              It is truncated to VMEM_LABELSIZE - 1 characters.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void vmem_reset(int seed, int policy, const char *label);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function reads a range of the virtual memory page by page: each 
+ *              page is put into memory and locked once, its bytes are copied in one go.
+ *              Every byte counts as an access, so the time windows of mmanage are the 
+ *              same as with vmem_read.
+ *  @param      address First address of the range.
+ *  @param      buf Receives the bytes of the range.
+ *  @param      length Length of the range in bytes.
+ *  @return     void
+ ****************************************************************************************/
+void vmem_read_range(int address, unsigned char *buf, int length);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function writes a range of the virtual memory page by page, see 
+ *              vmem_read_range.
+ *  @param      address First address of the range.
+ *  @param      buf Bytes to be written.
+ *  @param      length Length of the range in bytes.
+ *  @return     void
+ ****************************************************************************************/
+void vmem_write_range(int address, const unsigned char *buf, int length);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function tells the memory manager how a range of the virtual memory 
+ *              will be accessed, like madvise. The hint applies to all pages that store 
+ *              a byte of the range:
+ *              - VMEM_ADV_SEQUENTIAL: a page fault also loads the following pages, pages 
+ *                left behind are freed (read-around and drop-behind),
+ *              - VMEM_ADV_RANDOM and VMEM_ADV_NORMAL: no read-around,
+ *              - VMEM_ADV_WILLNEED: the pages are loaded after the call has returned,
+ *              - VMEM_ADV_DONTNEED: the frames of the pages are freed. The contents 
+ *                remain valid, only modified pages are written back.
+ *
+ *  @param      start First address of the range.
+ *  @param      length Length of the range in bytes.
+ *  @param      hint One of VMEM_ADV_* (see vmem.h).
+ *
+ *  @return     void
+ ****************************************************************************************/
+void vmem_advise(int start, int length, int hint);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function pins the pages that store a range of the virtual memory, 
+ *              like mlock. They are loaded if necessary and will not be evicted until 
+ *              vmem_unpin is called. mmanage limits the number of pinned pages 
+ *              (mmanage -pin=<n>); pages beyond this cap are not pinned.
+ *
+ *  @param      start First address of the range.
+ *  @param      length Length of the range in bytes.
+ *
+ *  @return     true if all pages of the range are pinned.
+ ****************************************************************************************/
+bool vmem_pin(int start, int length);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function unpins the pages that store a range of the virtual memory.
+ *              Pinning is not counted, a single call unpins a page pinned several times.
+ *
+ *  @param      start First address of the range.
+ *  @param      length Length of the range in bytes.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void vmem_unpin(int start, int length);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function selects the address space of this application, if mmanage
+ *              serves several clients. It must be called before the first access.
+ *              Default: client 0.
+ *
+ *  @param      client Client number, 0 <= client < number of clients of mmanage.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void vmem_set_client(int client);
+
 #endif
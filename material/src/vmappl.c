@@ -3,13 +3,26 @@
  * @author Wolfgang Fohl, HAW Hamburg 
  * @brief  Demo application for virtual memory management model
  * @date 2010
+ *
+ * With -native the array is stored in a real mapped region whose page faults are
+ * handled via userfaultfd (see vmuffd.h) instead of the simulated virtual memory.
+ * Instead of sorting, one of the workloads of workload.h can be run.
+ * With -reset mmanage resets the virtual memory before the run, so one mmanage 
+ * serves many runs (see vmem_reset).
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <time.h>
 #include "vmaccess.h"
+#include "vmtask.h"
+#include "vmuffd.h"
+#include "workload.h"
+#include "latency.h"
+#include "syncdataexchange.h"
+#include "vmem.h"
 #include "my_rand.h"
 #include "vmappl.h"
 
@@ -55,9 +68,82 @@ static void quicksort(int l, int r);
  ****************************************************************************************/
 static void bubblesort(int l, int r);
 
+/**
+ *****************************************************************************************
+ *  @brief      Bubble sort that keeps [i] in a local variable, so the page of [i] is 
+ *              accessed once per step of the outer loop instead of in each step of the 
+ *              inner loop. It makes the same exchanges as bubblesort.
+ *
+ *  @param      l address of the left-most array element to be sorted
+ * 
+ *  @param      r address of the right-most array element to be sorted
+ *
+ *  @return     void 
+ ****************************************************************************************/
+static void regbubblesort(int l, int r);
+
+/**
+ *****************************************************************************************
+ *  @brief      Merge sort on whole pages. The range is split at a page boundary, so 
+ *              the runs start at page boundaries. Runs of at most base bytes are sorted 
+ *              directly: a run of one page in a local copy (PAGE_MERGE_SORT), a tile 
+ *              of half the physical memory with quicksort (TILE_SORT). Two runs are 
+ *              merged with merge_pages.
+ *
+ *  @param      l address of the left-most array element to be sorted
+ * 
+ *  @param      r address of the right-most array element to be sorted
+ *
+ *  @param      buffer address of the merge buffer of the range, (r - l + 1) / 2 bytes
+ *
+ *  @param      base max. length of a run sorted directly
+ *
+ *  @return     void 
+ ****************************************************************************************/
+static void pagemergesort(int l, int r, int buffer, int base);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function merges the sorted runs [l, m) and [m, r]. The left run is 
+ *              copied to the buffer first, then both runs are merged into [l, r]. All 
+ *              ranges are read and written a page at a time via page_stream.
+ *
+ *  @param      l address of the first element of the left run
+ * 
+ *  @param      m address of the first element of the right run
+ *
+ *  @param      r address of the last element of the right run
+ *
+ *  @param      buffer address of the merge buffer, m - l bytes
+ *
+ *  @return     void 
+ ****************************************************************************************/
+static void merge_pages(int l, int m, int r, int buffer);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function announces a part of the array that quicksort will sort 
+ *              next (VMEM_ADV_WILLNEED), if advice is enabled. It does so only when the 
+ *              part fits into half of the physical memory and the enclosing range does 
+ *              not, i.e. once per part as the recursion shrinks.
+ *
+ *  @param      l address of the left-most element of the enclosing range
+ *
+ *  @param      r address of the right-most element of the enclosing range
+ *
+ *  @param      sl address of the left-most element of the part
+ *
+ *  @param      sr address of the right-most element of the part
+ *
+ *  @return     void 
+ ****************************************************************************************/
+static void advise_subrange(int l, int r, int sl, int sr);
+
 /**
  *****************************************************************************************
  *  @brief      This function sorts the array stored in the virtual memory.
+ *              With -tasks=<n> the array is split into n independent arrays, which 
+ *              are sorted concurrently by n tasks.
  *
  *  @param      length length of the array to be sorted 
  *
@@ -65,6 +151,28 @@ static void bubblesort(int l, int r);
  ****************************************************************************************/
 static void sort(int length);
 
+/**
+ *****************************************************************************************
+ *  @brief      This function sorts a part of the array with the selected algorithm.
+ *
+ *  @param      l address of the left-most array element to be sorted
+ * 
+ *  @param      r address of the right-most array element to be sorted
+ *
+ *  @return     void 
+ ****************************************************************************************/
+static void sort_range(int l, int r);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function is the main function of a sort task.
+ *
+ *  @param      arg struct range to be sorted
+ *
+ *  @return     void 
+ ****************************************************************************************/
+static void sort_task(void *arg);
+
 /**
  *****************************************************************************************
  *  @brief      This function swaps two int values of virtual memory 
@@ -80,10 +188,46 @@ static void sort(int length);
  ****************************************************************************************/
 static void swap(int addr1, int addr2);
 
+/**
+ *****************************************************************************************
+ *  @brief      These functions read and write an element of the array, either in the 
+ *              simulated virtual memory or, with -native, in the mapped region.
+ *
+ *  @param      addr address of the element
+ *
+ *  @param      val value to be written
+ ****************************************************************************************/
+static inline unsigned char get(int addr);
+static inline void put(int addr, unsigned char val);
+
+/**
+ *****************************************************************************************
+ *  @brief      These functions read and write a range of the array page by page, see 
+ *              vmem_read_range.
+ *
+ *  @param      addr address of the first element
+ *
+ *  @param      buf elements of the range
+ *
+ *  @param      len length of the range
+ ****************************************************************************************/
+static void get_range(int addr, unsigned char *buf, int len);
+static void put_range(int addr, const unsigned char *buf, int len);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function returns the size of the memory used by the selected 
+ *              algorithm: the array and the merge buffer of the page merge sorts.
+ ****************************************************************************************/
+static int memory_size(void);
+
 /**
  *****************************************************************************************
  *  @brief      This function scans all parameters of the porgram.
- *              The corresponding global variables seed and sort_algo will be set.
+ *              The corresponding global variables seed, sort_algo, checkpoint, 
+ *              restored, client, ntasks, advise, pin, native_policy, length, 
+ *              frames, workload, wl_params, reset and label will be set. -latency 
+ *              enables the latency histograms.
  * 
  *  @param      argc number of parameter 
  *
@@ -123,6 +267,40 @@ static void print_usage_info_and_exit(char *err_str);
 static char *program_name = NULL;
 static int sort_algo      = QUICK_SORT; // select default sort algorithm
 static int seed           = SEED; // select default init value for random number generator 
+static bool checkpoint    = false; // request a snapshot of the virtual memory after init_data
+static bool restored      = false; // mmanage restored a snapshot taken after init_data
+static int client         = 0; // address space used if mmanage serves several clients
+static int ntasks         = 1; // number of independent arrays sorted concurrently
+static bool advise        = false; // tell mmanage the access pattern with vmem_advise
+static bool pin           = false; // pin the pages of elements accessed in each step
+static const struct policy_ops *native_policy = NULL; // policy of the native mode; NULL: simulated virtual memory
+static int length         = LENGTH; // length of the array to be sorted
+static int frames         = 16; // max. number of resident pages in native mode
+static unsigned char *native = NULL; // array in the mapped region of the native mode
+static const struct workload *workload = NULL; // workload run instead of sorting; NULL: sort
+static struct workload_params wl_params = { 0, 4, 0, 1.0 }; // size, block, ops and skew of the workload
+static const struct workload_mem wl_mem = { get, put }; // memory accessed by the workload
+static int reset          = VOID_IDX; // policy of the run (VMEM_POLICY_*) if mmanage is asked to reset the memory first
+static const char *label  = "quicksort"; // label of the run sent with the reset: the sort algorithm or workload
+
+/*
+ * a range of the array read or written page by page through a local copy of a page
+ */
+struct page_stream {
+    int addr;                           // next address to be read or written in memory
+    int end;                            // end of the range (exclusive)
+    int pos;                            // next element of buf to be read
+    int len;                            // number of elements in buf
+    unsigned char buf[VMEM_PAGESIZE];
+};
+
+/*
+ * part of the array sorted by a task
+ */
+struct range {
+    int l;
+    int r;
+};
 
 /* 
  * functions of the module 
@@ -133,8 +311,16 @@ void scan_params(int argc, char **argv) {
     int i = 0;
     bool sort_algo_param_found = false;
     bool seed_param_found      = false;
+    bool length_param_found    = false;
     bool param_ok              = false;
     const char *seed_str = "-seed=";
+    const char *client_str = "-client=";
+    const char *tasks_str = "-tasks=";
+    const char *length_str = "-length=";
+    const char *frames_str = "-frames=";
+    const char *block_str = "-block=";
+    const char *ops_str = "-ops=";
+    const char *skew_str = "-skew=";
 
     // scan all parameters (argv[0] points to program name)
     for (i = 1; i < argc; i++) {
@@ -144,6 +330,7 @@ void scan_params(int argc, char **argv) {
             if (sort_algo_param_found) print_usage_info_and_exit("Two sort algorthm selected.\n");
             sort_algo = BUBBLE_SORT;
             sort_algo_param_found = true;
+            label = argv[i] + 1;
             param_ok = true;
         }
         if (0 == strcasecmp("-quicksort", argv[i])) {
@@ -151,6 +338,71 @@ void scan_params(int argc, char **argv) {
             if (sort_algo_param_found) print_usage_info_and_exit("Two sort algorthm selected.\n");
             sort_algo = QUICK_SORT;
             sort_algo_param_found = true;
+            label = argv[i] + 1;
+            param_ok = true;
+        }
+        if (0 == strcasecmp("-regbubblesort", argv[i])) {
+            // bubblesort with [i] in a local variable selected
+            if (sort_algo_param_found) print_usage_info_and_exit("Two sort algorthm selected.\n");
+            sort_algo = REG_BUBBLE_SORT;
+            sort_algo_param_found = true;
+            label = argv[i] + 1;
+            param_ok = true;
+        }
+        if (0 == strcasecmp("-pagemergesort", argv[i])) {
+            // merge sort on whole pages selected
+            if (sort_algo_param_found) print_usage_info_and_exit("Two sort algorthm selected.\n");
+            sort_algo = PAGE_MERGE_SORT;
+            sort_algo_param_found = true;
+            label = argv[i] + 1;
+            param_ok = true;
+        }
+        if (0 == strcasecmp("-tilesort", argv[i])) {
+            // quicksort of tiles merged on whole pages selected
+            if (sort_algo_param_found) print_usage_info_and_exit("Two sort algorthm selected.\n");
+            sort_algo = TILE_SORT;
+            sort_algo_param_found = true;
+            label = argv[i] + 1;
+            param_ok = true;
+        }
+        if (0 == strcasecmp("-checkpoint", argv[i])) {
+            checkpoint = true;
+            param_ok = true;
+        }
+        if (0 == strcasecmp("-pin", argv[i])) {
+            pin = true;
+            param_ok = true;
+        }
+        if (0 == strcasecmp("-latency", argv[i])) {
+            latency_enable();
+            param_ok = true;
+        }
+        if (0 == strcasecmp("-advise", argv[i])) {
+            advise = true;
+            param_ok = true;
+        }
+        if (0 == strcasecmp("-restored", argv[i])) {
+            restored = true;
+            param_ok = true;
+        }
+        if (0 == strcasecmp("-reset", argv[i])) {
+            reset = VMEM_POLICY_KEEP;
+            param_ok = true;
+        }
+        if (0 == strcasecmp("-reset=fifo", argv[i])) {
+            reset = VMEM_POLICY_FIFO;
+            param_ok = true;
+        }
+        if (0 == strcasecmp("-reset=clock", argv[i])) {
+            reset = VMEM_POLICY_CLOCK;
+            param_ok = true;
+        }
+        if (0 == strcasecmp("-reset=aging", argv[i])) {
+            reset = VMEM_POLICY_AGING;
+            param_ok = true;
+        }
+        if (0 == strcasecmp("-reset=adaptive", argv[i])) {
+            reset = VMEM_POLICY_ADAPTIVE;
             param_ok = true;
         }
         if ( 0 == strncasecmp(seed_str, argv[i], strlen(seed_str)) ) {
@@ -161,8 +413,92 @@ void scan_params(int argc, char **argv) {
                 param_ok = true;
             }
         }
+        if ( 0 == strncasecmp(client_str, argv[i], strlen(client_str)) ) {
+            // client number of this application 
+            if ( 1 == sscanf(argv[i]+strlen(client_str), "%d", &client) ) {
+                param_ok = true;
+            }
+        }
+        if ( 0 == strncasecmp(tasks_str, argv[i], strlen(tasks_str)) ) {
+            // number of sort tasks 
+            if ( (1 == sscanf(argv[i]+strlen(tasks_str), "%d", &ntasks)) && (ntasks >= 1) 
+                 && (ntasks <= VMTASK_MAX) ) {
+                param_ok = true;
+            }
+        }
+        if ((0 == strcasecmp("-native", argv[i])) || (0 == strcasecmp("-native=clock", argv[i]))) {
+            native_policy = &policy_clock;
+            param_ok = true;
+        }
+        if (0 == strcasecmp("-native=fifo", argv[i])) {
+            native_policy = &policy_fifo;
+            param_ok = true;
+        }
+        if (0 == strcasecmp("-native=aging", argv[i])) {
+            native_policy = &policy_aging;
+            param_ok = true;
+        }
+        if ( 0 == strncasecmp(length_str, argv[i], strlen(length_str)) ) {
+            // length of the array 
+            if ( (1 == sscanf(argv[i]+strlen(length_str), "%d", &length)) && (length >= 1) ) {
+                length_param_found = true;
+                param_ok = true;
+            }
+        }
+        if ( 0 == strncasecmp(frames_str, argv[i], strlen(frames_str)) ) {
+            // resident pages in native mode 
+            if ( (1 == sscanf(argv[i]+strlen(frames_str), "%d", &frames)) && (frames >= 1) ) {
+                param_ok = true;
+            }
+        }
+        if ((argv[i][0] == '-') && find_workload(argv[i] + 1)) {
+            // workload selected
+            if (sort_algo_param_found) print_usage_info_and_exit("Two sort algorthm selected.\n");
+            workload = find_workload(argv[i] + 1);
+            sort_algo_param_found = true;
+            label = workload->name;
+            param_ok = true;
+        }
+        if ( 0 == strncasecmp(block_str, argv[i], strlen(block_str)) ) {
+            // tile size of matmul 
+            if (1 == sscanf(argv[i]+strlen(block_str), "%d", &wl_params.block)) {
+                param_ok = true;
+            }
+        }
+        if ( 0 == strncasecmp(ops_str, argv[i], strlen(ops_str)) ) {
+            // number of operations of the workload 
+            if ( (1 == sscanf(argv[i]+strlen(ops_str), "%d", &wl_params.ops)) && (wl_params.ops >= 1) ) {
+                param_ok = true;
+            }
+        }
+        if ( 0 == strncasecmp(skew_str, argv[i], strlen(skew_str)) ) {
+            // exponent of the Zipf distribution 
+            if (1 == sscanf(argv[i]+strlen(skew_str), "%lf", &wl_params.skew)) {
+                param_ok = true;
+            }
+        }
         if (!param_ok) print_usage_info_and_exit("Undefined parameter.\n"); // undefined parameter found
     } // for loop
+    if (workload) {
+        // length is the size of the workload, the memory used follows from it
+        wl_params.size = length_param_found ? length : workload->default_size;
+        length = workload->footprint(&wl_params);
+        if (length <= 0) {
+            print_usage_info_and_exit("Invalid size, -block= or -skew= of the workload.\n");
+        }
+        if (checkpoint || restored || advise || pin || (ntasks > 1)) {
+            print_usage_info_and_exit("Workloads do not support -checkpoint, -restored, -advise, -pin and -tasks.\n");
+        }
+    }
+    if (!native_policy && (memory_size() > VMEM_VIRTMEMSIZE)) {
+        print_usage_info_and_exit("The array does not fit into the virtual memory, use -native.\n");
+    }
+    if (native_policy && (checkpoint || restored || advise || pin || (ntasks > 1) || (client != 0) || (reset != VOID_IDX))) {
+        print_usage_info_and_exit("-native does not support -checkpoint, -restored, -advise, -pin, -tasks, -client and -reset.\n");
+    }
+    if (ntasks > length) {
+        print_usage_info_and_exit("More tasks than elements.\n");
+    }
 }
 
 int main(int argc, char **argv) {
@@ -170,29 +506,82 @@ int main(int argc, char **argv) {
 
     program_name = argv[0];
     scan_params(argc, argv);
-    printf("seed = %d sort algorithm = %s\n", seed, 
-           (sort_algo == QUICK_SORT) ? "Quick Sort" : (sort_algo == BUBBLE_SORT) ? "Bubble Sort" : "undefined");
+    if (workload) {
+        printf("seed = %d workload = %s size = %d\n", seed, workload->name, wl_params.size);
+    } else {
+        printf("seed = %d sort algorithm = %s\n", seed, 
+               (sort_algo == QUICK_SORT) ? "Quick Sort" : (sort_algo == BUBBLE_SORT) ? "Bubble Sort" : 
+               (sort_algo == REG_BUBBLE_SORT) ? "Register Bubble Sort" : (sort_algo == PAGE_MERGE_SORT) ? "Page Merge Sort" :
+               (sort_algo == TILE_SORT) ? "Tile Sort" : "undefined");
+    }
     fflush(stdout); 
+    if (native_policy) {
+        native = vmuffd_map(memory_size(), frames, native_policy);
+    } else {
+        vmem_set_client(client);
+    }
+    if (reset != VOID_IDX) {
+        vmem_reset(seed, reset, label);
+    }
 
     /* Fill memory with pseudo-random data */
-    if (LENGTH <= 0) {
+    if (length <= 0) {
         fprintf(stderr, "LENGTH (array size) out of range");
         exit(EXIT_FAILURE); 
     }
-    init_data(LENGTH);
+    if (workload) {
+        my_srand(seed);
+        workload->init(&wl_mem, &wl_params);
+    } else if (!restored) {
+        init_data(length);
+    }
+    if (checkpoint) {
+        vmem_checkpoint();
+    }
+    // the sorted part of the memory
+    int display_length = !workload ? length : workload->sorts ? wl_params.size : 0;
 
     /* Display unsorted */
-    printf("\nUnsorted:\n");
-    display_data(LENGTH);
+    if (display_length > 0) {
+        printf("\nUnsorted:\n");
+        display_data(display_length);
+    }
 
     /* Sort */
-    printf("\nSorting:\n");
-    sort(LENGTH);
+    printf(workload ? "\nRunning:\n" : "\nSorting:\n");
+    struct timespec t0, t1;
+    unsigned long checksum = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (workload) {
+        checksum = workload->run(&wl_mem, &wl_params);
+    } else {
+        sort(length);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
 
     /* Display sorted */
-    printf("\nSorted:\n");
-    display_data(LENGTH);
+    if (display_length > 0) {
+        printf("\nSorted:\n");
+        display_data(display_length);
+    } else {
+        printf("checksum = %lu\n", checksum);
+    }
     printf("\n");
+    if (advise) {
+        // the frames can be given to other clients
+        vmem_advise(0, length, VMEM_ADV_DONTNEED);
+    }
+    if (latency_on && !native) {
+        printRoundTripLatency(stderr);
+    }
+    if (native) {
+        struct vmuffd_stats st;
+        vmuffd_get_stats(&st);
+        vmuffd_unmap();
+        fprintf(stderr, "Native: %ld page faults, %ld write faults, %ld evictions, %ld pages read, %ld pages written, "
+                "sorted in %.3f s\n", st.faults, st.wp_faults, st.evictions, st.reads, st.writes,
+                (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9);
+    }
 
     return 0;
 }
@@ -204,28 +593,70 @@ void init_data(int length) {
     /* Init random generator */
     my_srand(seed);
 
+    if (advise) {
+        vmem_advise(0, length, VMEM_ADV_SEQUENTIAL);
+    }
     for(i = 0; i < length; i++) {
         val = my_rand() % RNDMOD;
-        vmem_write(i, val);
+        put(i, val);
     }   /* end for */
+    if (advise) {
+        vmem_advise(0, length, VMEM_ADV_NORMAL);
+    }
 }
 
 void display_data(int length) {
     int i;
+    if (advise) {
+        vmem_advise(0, length, VMEM_ADV_SEQUENTIAL);
+    }
     for(i = 0; i < length; i++) {
-        printf("%10d", vmem_read(i));
+        printf("%10d", get(i));
         printf("%c", ((i + 1) % NDISPLAYCOLS) ? ' ' : '\n');
     }   /* end for */
+    if (advise) {
+        vmem_advise(0, length, VMEM_ADV_NORMAL);
+    }
 }
 
 void sort(int length) {
+    static struct range ranges[VMTASK_MAX];
+    if (ntasks == 1) {
+        sort_range(0, length - 1);
+        return;
+    }
+    for (int t = 0; t < ntasks; t++) {
+        ranges[t].l = t * length / ntasks;
+        ranges[t].r = (t + 1) * length / ntasks - 1;
+        vmtask_spawn(sort_task, &ranges[t]);
+    }
+    vmtask_run();
+    vmtask_stats();
+}
+
+void sort_task(void *arg) {
+    struct range *range = arg;
+    sort_range(range->l, range->r);
+}
+
+void sort_range(int l, int r) {
     /* Quicksort */
     switch (sort_algo) {
        case QUICK_SORT :
-           quicksort(0, length - 1);
+           quicksort(l, r);
            break;
        case BUBBLE_SORT :
-           bubblesort(0, length - 1);
+           bubblesort(l, r);
+           break;
+       case REG_BUBBLE_SORT :
+           regbubblesort(l, r);
+           break;
+       case PAGE_MERGE_SORT :
+           // each task has its own part of the buffer behind the array
+           pagemergesort(l, r, length + l / 2, VMEM_PAGESIZE);
+           break;
+       case TILE_SORT :
+           pagemergesort(l, r, length + l / 2, VMEM_PHYSMEMSIZE / 2);
            break;
        default:
            fprintf(stderr, "Undefined sort algorithm in function sort");
@@ -235,24 +666,150 @@ void sort(int length) {
 
 static void bubblesort(int l, int r) {
     int i, j;
+    // [i] is read in each step of the inner loop, its page is pinned if the range 
+    // does not fit into memory
+    bool pinned = false;
+    bool pin_range = pin && (r - l + 1 > VMEM_PHYSMEMSIZE / 2);
     for (i = l; i < r; i ++) {
+        if (pin_range && ((i == l) || (i % VMEM_PAGESIZE == 0))) {
+            if (pinned) {
+                vmem_unpin(i - 1, 1);
+            }
+            pinned = vmem_pin(i, 1);
+        }
         for (j = i + 1; j <= r; j ++) {
-            if (vmem_read(j) < vmem_read(i)) {
+            if (get(j) < get(i)) {
                swap(i,j);
             }
         }
     }
+    if (pinned) {
+        vmem_unpin(r - 1, 1);
+    }
+}
+
+void regbubblesort(int l, int r) {
+    for (int i = l; i < r; i++) {
+        unsigned char ai = get(i);
+        bool changed = false;
+        for (int j = i + 1; j <= r; j++) {
+            unsigned char aj = get(j);
+            if (aj < ai) {
+                put(j, ai);
+                ai = aj;
+                changed = true;
+            }
+        }
+        if (changed) {
+            put(i, ai);
+        }
+    }
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      These functions open a page_stream on [addr, end), read the next element 
+ *              and write the next element. A page is written when it is complete.
+ ****************************************************************************************/
+static void stream_open(struct page_stream *s, int addr, int end) {
+    s->addr = addr;
+    s->end = end;
+    s->pos = s->len = 0;
+}
+
+static unsigned char stream_get(struct page_stream *s) {
+    if (s->pos == s->len) {
+        int n = VMEM_PAGESIZE - s->addr % VMEM_PAGESIZE;
+        s->len = (n < s->end - s->addr) ? n : s->end - s->addr;
+        get_range(s->addr, s->buf, s->len);
+        s->addr += s->len;
+        s->pos = 0;
+    }
+    return s->buf[s->pos++];
+}
+
+static void stream_put(struct page_stream *s, unsigned char val) {
+    s->buf[s->len++] = val;
+    if ((s->len == VMEM_PAGESIZE - s->addr % VMEM_PAGESIZE) || (s->addr + s->len == s->end)) {
+        put_range(s->addr, s->buf, s->len);
+        s->addr += s->len;
+        s->len = 0;
+    }
+}
+
+void pagemergesort(int l, int r, int buffer, int base) {
+    int n = r - l + 1;
+    if (n <= 1) {
+        return;
+    }
+    if ((n <= base) && (sort_algo == TILE_SORT)) {
+        // the tile fits into memory, faults occur only on the first access of a page
+        quicksort(l, r);
+        return;
+    }
+    if (n <= base) {
+        // insertion sort of a local copy of the page
+        unsigned char page[VMEM_PAGESIZE];
+        get_range(l, page, n);
+        for (int i = 1; i < n; i++) {
+            unsigned char v = page[i];
+            int j = i;
+            for (; (j > 0) && (page[j - 1] > v); j--) {
+                page[j] = page[j - 1];
+            }
+            page[j] = v;
+        }
+        put_range(l, page, n);
+        return;
+    }
+    // split at the page boundary next to the middle, the left run is at most n / 2 long
+    int m = (l + n / 2) / VMEM_PAGESIZE * VMEM_PAGESIZE;
+    if (m <= l) {
+        m = l + n / 2;
+    }
+    pagemergesort(l, m - 1, buffer, base);
+    pagemergesort(m, r, buffer, base);
+    merge_pages(l, m, r, buffer);
+}
+
+void merge_pages(int l, int m, int r, int buffer) {
+    struct page_stream in, out, left, right;
+    stream_open(&in, l, m);
+    stream_open(&out, buffer, buffer + m - l);
+    for (int i = l; i < m; i++) {
+        stream_put(&out, stream_get(&in));
+    }
+    // out never passes the elements of the right run not yet read: 
+    // it has written (m - l) + (consumed of right) elements starting at l
+    stream_open(&left, buffer, buffer + m - l);
+    stream_open(&right, m, r + 1);
+    stream_open(&out, l, r + 1);
+    int nl = m - l, nr = r - m + 1;
+    unsigned char a = stream_get(&left);
+    unsigned char b = stream_get(&right);
+    while ((nl > 0) || (nr > 0)) {
+        if ((nr == 0) || ((nl > 0) && (a <= b))) {
+            stream_put(&out, a);
+            if (--nl > 0) a = stream_get(&left);
+        } else {
+            stream_put(&out, b);
+            if (--nr > 0) b = stream_get(&right);
+        }
+    }
 }
 
 void quicksort(int l, int r) {
     if(l < r) {
         int i = l;
         int j = r - 1;
+        // the pivot [r] is read in each step, its page is pinned if the range does 
+        // not fit into memory
+        bool pinned = pin && (r - l + 1 > VMEM_PHYSMEMSIZE / 2) && vmem_pin(r, 1);
         while(1) {      /* Put all elements < [r] to the left */
-            while(vmem_read(i) < vmem_read(r)) {
+            while(get(i) < get(r)) {
                 i++;
             }
-            while((vmem_read(j) >= vmem_read(r)) && (j > l)) {
+            while((get(j) >= get(r)) && (j > l)) {
                 j--;
             }
             if(i >= j) {
@@ -261,16 +818,60 @@ void quicksort(int l, int r) {
             swap(i, j);
         }       /* end while */
         swap(i, r);     /* Put reference elemet to the boundary */
+        if (pinned) {
+            vmem_unpin(r, 1);
+        }
         /* Recursively sort the left and right half */
+        advise_subrange(l, r, l, i - 1);
         quicksort(l, i - 1);
+        advise_subrange(l, r, i + 1, r);
         quicksort(i + 1, r);
     }   /* end if */
 }
 
+void advise_subrange(int l, int r, int sl, int sr) {
+    if (advise && (sl < sr) && (sr - sl + 1 <= VMEM_PHYSMEMSIZE / 2) && (r - l + 1 > VMEM_PHYSMEMSIZE / 2)) {
+        vmem_advise(sl, sr - sl + 1, VMEM_ADV_WILLNEED);
+    }
+}
+
 void swap(int addr1, int addr2) {
-    unsigned char tmp = vmem_read(addr1);
-    vmem_write(addr1, vmem_read(addr2));
-    vmem_write(addr2, tmp);
+    unsigned char tmp = get(addr1);
+    put(addr1, get(addr2));
+    put(addr2, tmp);
+}
+
+unsigned char get(int addr) {
+    return native ? native[addr] : vmem_read(addr);
+}
+
+void put(int addr, unsigned char val) {
+    if (native) {
+        native[addr] = val;
+    } else {
+        vmem_write(addr, val);
+    }
+}
+
+void get_range(int addr, unsigned char *buf, int len) {
+    if (native) {
+        memcpy(buf, native + addr, len);
+    } else {
+        vmem_read_range(addr, buf, len);
+    }
+}
+
+void put_range(int addr, const unsigned char *buf, int len) {
+    if (native) {
+        memcpy(native + addr, buf, len);
+    } else {
+        vmem_write_range(addr, buf, len);
+    }
+}
+
+int memory_size(void) {
+    bool merge = (sort_algo == PAGE_MERGE_SORT) || (sort_algo == TILE_SORT);
+    return merge ? length + length / 2 : length;
 }
 
 void print_usage_info_and_exit(char *err_str) {
@@ -278,8 +879,28 @@ void print_usage_info_and_exit(char *err_str) {
     fprintf(stderr, "Usage : %s [OPTIONS]\n", program_name);
     fprintf(stderr, " -quicksort : Use quicksort algorithm\n");
     fprintf(stderr, " -bubblesort : Use bubblesort algorithm\n");
+    fprintf(stderr, " -regbubblesort : Use bubblesort keeping [i] in a local variable\n");
+    fprintf(stderr, " -pagemergesort : Use merge sort reading and writing whole pages\n");
+    fprintf(stderr, " -tilesort : Use quicksort of tiles of half the physical memory, merged page by page\n");
+    fprintf(stderr, " -%s : Run a workload instead, see workload.h\n", workload_names());
     fprintf(stderr, " -seed=<int value> : Init randon number generator for generating the numbers\n");
     fprintf(stderr, "                     of the array to be sorted with <int value>\n");
+    fprintf(stderr, " -checkpoint : Ask mmanage to save a snapshot after initialisation\n");
+    fprintf(stderr, " -restored : mmanage has restored such a snapshot, skip initialisation\n");
+    fprintf(stderr, " -reset[=fifo|clock|aging|adaptive] : Ask mmanage to reset the memory and to change the policy\n");
+    fprintf(stderr, "                     first, so mmanage need not be restarted for each run\n");
+    fprintf(stderr, " -pin : Pin the page of the pivot (quicksort) or of [i] (bubblesort), see mmanage -pin=\n");
+    fprintf(stderr, " -native[=fifo|clock|aging] : Sort in a real mapped region, page faults via userfaultfd\n");
+    fprintf(stderr, " -length=<n> : Length of the array, default %d (more than %d requires -native)\n", LENGTH, VMEM_VIRTMEMSIZE);
+    fprintf(stderr, "               With a workload: its size (elements, matrix rows, slots, nodes or bytes)\n");
+    fprintf(stderr, " -block=<n> : Tile size of matmul, default 4\n");
+    fprintf(stderr, " -ops=<n> : Operations of hash, list and zipf, default 4 * size\n");
+    fprintf(stderr, " -skew=<s> : Exponent of the Zipf distribution of zipf, default 1.0\n");
+    fprintf(stderr, " -frames=<n> : Max. number of resident pages in native mode, default 16\n");
+    fprintf(stderr, " -latency : Print the latency histogram of the round trips to mmanage at exit\n");
+    fprintf(stderr, " -advise : Tell mmanage the access pattern (sequential scans, quicksort parts)\n");
+    fprintf(stderr, " -client=<n> : Use address space n of mmanage (see mmanage -clients=)\n");
+    fprintf(stderr, " -tasks=<n> : Split the array into n arrays, sorted concurrently by n tasks (1..%d)\n", VMTASK_MAX);
     fflush(stderr);
     exit(EXIT_FAILURE);
 }
@@ -24,5 +24,8 @@
 
 #define QUICK_SORT     10  // use quick sort 
 #define BUBBLE_SORT    11  // use bubble  sort 
+#define REG_BUBBLE_SORT 12 // use bubble sort keeping [i] in a local variable
+#define PAGE_MERGE_SORT 13 // use merge sort streaming whole pages
+#define TILE_SORT      14  // use quick sort of tiles fitting into memory, merged page by page
 
 #endif
@@ -0,0 +1,487 @@
+/**
+ * @file vmbench.c
+ * @date Oct 2026
+ * @brief Microbenchmarks and end-to-end benchmarks of the virtual memory simulation.
+ *        The results are written to stdout as JSON, see bench.h.
+ *        - hit: vmem_read and vmem_write of resident pages. mmanage is started, the
+ *          pages are loaded during the warmup. Every TIME_WINDOW-th access sends
+ *          CMD_TIME_INTER_VAL to mmanage, this round trip is part of the result as it
+ *          is part of every access seen by an application.
+ *        - ipc: round trip of a message to mmanage and its acknowledgement.
+ *        - pagefile: page-in (fetch) and page-out followed by page-in (store, fetch, as
+ *          an eviction does) for each pagefile backend. The pagefile is created in a
+ *          temporary directory by a child process, since the backend can be selected
+ *          only once per process.
+ *        - victim: choose_victim and on_fault of the built-in policies for 2, 4, ...
+ *          VMEM_NFRAMES frames. The frames are simulated, a random frame is referenced
+ *          before each fault, on_access and on_tick follow every VMBENCH_TICK faults.
+ *        - e2e: wall clock time of vmappl for each sort and policy, including the
+ *          start of mmanage.
+ *        mmanage and vmappl are taken from the directory of vmbench. Like them, vmbench
+ *        must be started in the directory containing src/vmem.h, and mmanage must not
+ *        be running.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <limits.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "vmem.h"
+#include "vmaccess.h"
+#include "pagefile.h"
+#include "policy.h"
+#include "syncdataexchange.h"
+#include "vmstats.h"
+#include "latency.h"
+#include "bench.h"
+#include "my_rand.h"
+#include "error.h"
+
+#define VMBENCH_ACCESSES  (1 << 14)     //!< Number of accesses per measurement of the hit path
+#define VMBENCH_MSGS      2000          //!< Number of round trips per measurement of the IPC
+#define VMBENCH_PAGEOPS   2000          //!< Number of pagefile operations per measurement
+#define VMBENCH_FAULTS    (1 << 16)     //!< Number of simulated faults per measurement of a policy
+#define VMBENCH_TICK      20            //!< Simulated faults per time interval
+#define VMBENCH_SEED      2806          //!< Seed of the simulated references
+
+/**
+ * Pagefile configurations
+ */
+static const struct {
+    const char *name;
+    int backend;
+    int cluster;
+    int layout;
+} pf_configs[] = {
+    { "stdio",    PAGEFILE_BACKEND_STDIO,   1, PAGEFILE_LAYOUT_FIXED },
+    { "cluster4", PAGEFILE_BACKEND_STDIO,   4, PAGEFILE_LAYOUT_FIXED },
+    { "uring",    PAGEFILE_BACKEND_URING,   1, PAGEFILE_LAYOUT_FIXED },
+    { "threads",  PAGEFILE_BACKEND_THREADS, 1, PAGEFILE_LAYOUT_FIXED },
+    { "logswap",  PAGEFILE_BACKEND_STDIO,   1, PAGEFILE_LAYOUT_LOG },
+};
+
+static const struct policy_ops *const policies[] = { &policy_fifo, &policy_clock, &policy_aging };
+static const char *const mmanage_policies[] = { "-fifo", "-clock", "-aging" };
+static const char *const sorts[] = { "-quicksort", "-bubblesort", "-regbubblesort", "-pagemergesort", "-tilesort" };
+
+static char bindir[PATH_MAX];           //!< Directory of mmanage and vmappl
+static bool run_hit, run_ipc, run_pagefile, run_victim, run_e2e; //!< Selected benchmarks
+static unsigned char page_buf[VMEM_PAGESIZE]; //!< Frame used by the pagefile benchmarks
+static bool sim_ref[VMEM_NFRAMES];      //!< Simulated reference bits
+static int sim_nframes;                 //!< Number of simulated frames
+static struct policy sim_policy;        //!< Instance of the simulated policy
+static int refs[VMBENCH_FAULTS];        //!< Frame referenced before each simulated fault
+static volatile int sink;               //!< Keeps the compiler from dropping the reads
+
+/**
+ * Argument of a measurement
+ */
+struct bench_arg {
+    int config;                         //!< Index of the pagefile configuration or policy
+    const char *argv[4];                //!< Parameters of mmanage and vmappl of an end-to-end run
+};
+
+/**
+ *****************************************************************************************
+ *  @brief      This function scans all parameters of the program and sets the
+ *              selected benchmarks.
+ *
+ *  @param      argc number of parameter
+ *
+ *  @param      argv parameter list
+ *
+ *  @return     void
+ ****************************************************************************************/
+static void scan_params(int argc, char **argv);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function prints an error message and the usage information of
+ *              this program.
+ *
+ *  @param      err_str pointer to the error string that should be printed.
+ *
+ *  @return     void
+ ****************************************************************************************/
+static void print_usage_info_and_exit(char *err_str);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function starts mmanage and waits until it serves clients.
+ *
+ *  @param      policy Parameter of mmanage selecting the policy.
+ *
+ *  @return     Process id of mmanage.
+ ****************************************************************************************/
+static pid_t start_mmanage(const char *policy);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function terminates mmanage with SIGINT, as a user does.
+ *
+ *  @param      pid Process id of mmanage.
+ *
+ *  @return     void
+ ****************************************************************************************/
+static void stop_mmanage(pid_t pid);
+
+/**
+ *****************************************************************************************
+ *  @brief      These functions run the benchmarks of a group and print their results.
+ *
+ *  @return     void
+ ****************************************************************************************/
+static void bench_hit_and_ipc(void);
+static void bench_pagefile(void);
+static void bench_victim(void);
+static void bench_e2e(void);
+
+/**
+ *****************************************************************************************
+ *  @brief      Measurement functions, see bench_fn. They return the time per operation
+ *              in nanoseconds, bench_e2e_run the wall clock time in milliseconds.
+ ****************************************************************************************/
+static double bench_read(void *arg);
+static double bench_write(void *arg);
+static double bench_roundtrip(void *arg);
+static double bench_page_in(void *arg);
+static double bench_page_inout(void *arg);
+static double bench_choose_victim(void *arg);
+static double bench_e2e_run(void *arg);
+
+int main(int argc, char **argv) {
+    scan_params(argc, argv);
+    char self[PATH_MAX];
+    snprintf(self, sizeof(self), "%s", argv[0]);
+    snprintf(bindir, sizeof(bindir), "%s", dirname(self));
+    signal(SIGPIPE, SIG_IGN);
+
+    bench_json_begin(stdout, "vmbench");
+    if (run_hit || run_ipc) {
+        bench_hit_and_ipc();
+    }
+    if (run_pagefile) {
+        bench_pagefile();
+    }
+    if (run_victim) {
+        bench_victim();
+    }
+    if (run_e2e) {
+        bench_e2e();
+    }
+    bench_json_end(stdout);
+    return 0;
+}
+
+pid_t start_mmanage(const char *policy) {
+    char path[PATH_MAX + 16];
+    snprintf(path, sizeof(path), "%s/mmanage", bindir);
+    pid_t pid = fork();
+    TEST_AND_EXIT_ERRNO(pid == -1, "vmbench: fork failed");
+    if (pid == 0) {
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDOUT_FILENO);
+        dup2(null, STDERR_FILENO);
+        execl(path, "mmanage", policy, (char *) NULL);
+        _exit(127);
+    }
+    // mmanage creates its statistics segment after the shared memory and the semaphores
+    for (;;) {
+        const struct vmstats *s = vmstats_attach();
+        bool ready = s && (s->pid == pid);
+        if (s) {
+            munmap((void *) s, sizeof(*s));
+        }
+        if (ready) {
+            return pid;
+        }
+        int status;
+        TEST_AND_EXIT(waitpid(pid, &status, WNOHANG) == pid, (stderr, "vmbench: %s failed; is mmanage already running?\n", path));
+        struct timespec delay = { 0, 5000000L };
+        nanosleep(&delay, NULL);
+    }
+}
+
+void stop_mmanage(pid_t pid) {
+    kill(pid, SIGINT);
+    while ((waitpid(pid, NULL, 0) == -1) && (errno == EINTR));
+}
+
+double bench_read(void *arg) {
+    int sum = 0;
+    long long start = latency_now();
+    for (int i = 0; i < VMBENCH_ACCESSES; i++) {
+        sum += vmem_read(i % (VMEM_NFRAMES * VMEM_PAGESIZE));
+    }
+    double t = (double) (latency_now() - start) / VMBENCH_ACCESSES;
+    sink = sum;
+    return t;
+}
+
+double bench_write(void *arg) {
+    long long start = latency_now();
+    for (int i = 0; i < VMBENCH_ACCESSES; i++) {
+        vmem_write(i % (VMEM_NFRAMES * VMEM_PAGESIZE), i);
+    }
+    return (double) (latency_now() - start) / VMBENCH_ACCESSES;
+}
+
+double bench_roundtrip(void *arg) {
+    struct msg m = {CMD_TIME_INTER_VAL, 0, 0, 0};
+    long long start = latency_now();
+    for (int i = 0; i < VMBENCH_MSGS; i++) {
+        sendMsgToMmanager(m);
+    }
+    return (double) (latency_now() - start) / VMBENCH_MSGS;
+}
+
+void bench_hit_and_ipc(void) {
+    pid_t pid = start_mmanage("-clock");
+    struct bench_result r;
+    if (run_hit) {
+        // the first accesses load the pages, all fit into the frames
+        memset(&r, 0, sizeof(r));
+        snprintf(r.name, sizeof(r.name), "hit_read");
+        snprintf(r.params, sizeof(r.params), "\"pages\": %d, \"time_window\": 20", VMEM_NFRAMES);
+        snprintf(r.unit, sizeof(r.unit), "ns/op");
+        bench_measure(&r, bench_read, NULL);
+        bench_json_result(stdout, &r);
+        snprintf(r.name, sizeof(r.name), "hit_write");
+        bench_measure(&r, bench_write, NULL);
+        bench_json_result(stdout, &r);
+    }
+    if (run_ipc) {
+        memset(&r, 0, sizeof(r));
+        snprintf(r.name, sizeof(r.name), "ipc_roundtrip");
+        snprintf(r.params, sizeof(r.params), "\"cmd\": \"CMD_TIME_INTER_VAL\"");
+        snprintf(r.unit, sizeof(r.unit), "ns/op");
+        bench_measure(&r, bench_roundtrip, NULL);
+        bench_json_result(stdout, &r);
+    }
+    stop_mmanage(pid);
+}
+
+double bench_page_in(void *arg) {
+    long long start = latency_now();
+    for (int i = 0; i < VMBENCH_PAGEOPS; i++) {
+        fetch_page_from_pagefile(my_rand() % VMEM_NPAGES, page_buf);
+    }
+    return (double) (latency_now() - start) / VMBENCH_PAGEOPS;
+}
+
+double bench_page_inout(void *arg) {
+    long long start = latency_now();
+    for (int i = 0; i < VMBENCH_PAGEOPS; i++) {
+        int page = my_rand() % VMEM_NPAGES;
+        page_buf[0] = i;
+        store_page_to_pagefile(page, page_buf);
+        fetch_page_from_pagefile((page + VMEM_NPAGES / 2) % VMEM_NPAGES, page_buf);
+        // the log cleaner runs while mmanage is idle, i.e. between faults
+        clean_pagefile();
+    }
+    return (double) (latency_now() - start) / VMBENCH_PAGEOPS;
+}
+
+void bench_pagefile(void) {
+    for (int c = 0; c < sizeof(pf_configs) / sizeof(pf_configs[0]); c++) {
+        struct bench_result r[2];
+        int fd[2];
+        TEST_AND_EXIT_ERRNO(pipe(fd) == -1, "vmbench: pipe failed");
+        fflush(stdout);
+        pid_t pid = fork();
+        TEST_AND_EXIT_ERRNO(pid == -1, "vmbench: fork failed");
+        if (pid == 0) {
+            char dir[] = "/tmp/vmbench.XXXXXX";
+            TEST_AND_EXIT_ERRNO(!mkdtemp(dir), "vmbench: mkdtemp failed");
+            TEST_AND_EXIT_ERRNO(chdir(dir) == -1, "vmbench: chdir failed");
+            select_pagefile_backend(pf_configs[c].backend);
+            set_pagefile_cluster(pf_configs[c].cluster);
+            select_pagefile_layout(pf_configs[c].layout);
+            init_pagefile();
+            my_srand(VMBENCH_SEED);
+            memset(r, 0, sizeof(r));
+            for (int k = 0; k < 2; k++) {
+                snprintf(r[k].name, sizeof(r[k].name), k ? "pagefile_out_in" : "pagefile_in");
+                snprintf(r[k].params, sizeof(r[k].params), "\"backend\": \"%s\"", pf_configs[c].name);
+                snprintf(r[k].unit, sizeof(r[k].unit), "ns/op");
+                bench_measure(&r[k], k ? bench_page_inout : bench_page_in, NULL);
+            }
+            cleanup_pagefile();
+            unlink("pagefile.bin");
+            TEST_AND_EXIT_ERRNO(chdir("/") == -1 || rmdir(dir) == -1, "vmbench: removing the pagefile directory failed");
+            TEST_AND_EXIT_ERRNO(write(fd[1], r, sizeof(r)) != sizeof(r), "vmbench: write to pipe failed");
+            _exit(EXIT_SUCCESS);
+        }
+        close(fd[1]);
+        ssize_t n = read(fd[0], r, sizeof(r));
+        close(fd[0]);
+        waitpid(pid, NULL, 0);
+        TEST_AND_EXIT(n != sizeof(r), (stderr, "vmbench: pagefile benchmark %s failed\n", pf_configs[c].name));
+        bench_json_result(stdout, &r[0]);
+        bench_json_result(stdout, &r[1]);
+    }
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      Simulated frames of the policy benchmark. All frames are used, frame i
+ *              stores page i.
+ ****************************************************************************************/
+static int sim_page_of_frame(const struct policy_env *env, int frame) {
+    return frame;
+}
+
+static bool sim_test_ref(const struct policy_env *env, int frame) {
+    return sim_ref[frame];
+}
+
+static void sim_clear_ref(const struct policy_env *env, int frame) {
+    sim_ref[frame] = false;
+}
+
+static bool sim_pinned(const struct policy_env *env, int frame) {
+    return false;
+}
+
+static struct policy_env sim_env = {
+    .page_of_frame = sim_page_of_frame,
+    .test_ref = sim_test_ref,
+    .clear_ref = sim_clear_ref,
+    .pinned = sim_pinned,
+};
+
+double bench_choose_victim(void *arg) {
+    const struct policy_ops *ops = policies[((struct bench_arg *) arg)->config];
+    void *state = sim_policy.state;
+    long long start = latency_now();
+    for (int i = 0; i < VMBENCH_FAULTS; i++) {
+        sim_ref[refs[i] % sim_nframes] = true;
+        int frame = ops->choose_victim(state, &sim_env, i % VMEM_NPAGES);
+        sim_ref[frame] = true;
+        if (ops->on_fault) {
+            ops->on_fault(state, &sim_env, i % VMEM_NPAGES, frame);
+        }
+        if ((i + 1) % VMBENCH_TICK == 0) {
+            for (int f = 0; ops->on_access && (f < sim_nframes); f++) {
+                if (sim_ref[f]) {
+                    ops->on_access(state, &sim_env, f);
+                    sim_ref[f] = false;
+                }
+            }
+            if (ops->on_tick) {
+                ops->on_tick(state, &sim_env);
+            }
+        }
+    }
+    return (double) (latency_now() - start) / VMBENCH_FAULTS;
+}
+
+void bench_victim(void) {
+    my_srand(VMBENCH_SEED);
+    for (int i = 0; i < VMBENCH_FAULTS; i++) {
+        refs[i] = my_rand() % VMEM_NFRAMES;
+    }
+    for (int p = 0; p < sizeof(policies) / sizeof(policies[0]); p++) {
+        for (sim_nframes = 2; sim_nframes <= VMEM_NFRAMES; sim_nframes *= 2) {
+            sim_env.nframes = sim_nframes;
+            memset(sim_ref, 0, sizeof(sim_ref));
+            policy_start(&sim_policy, policies[p], &sim_env);
+            for (int f = 0; f < sim_nframes; f++) {
+                if (policies[p]->on_fault) {
+                    policies[p]->on_fault(sim_policy.state, &sim_env, f, f);
+                }
+            }
+            struct bench_arg arg = { p };
+            struct bench_result r;
+            memset(&r, 0, sizeof(r));
+            snprintf(r.name, sizeof(r.name), "choose_victim");
+            snprintf(r.params, sizeof(r.params), "\"policy\": \"%s\", \"nframes\": %d", policies[p]->name, sim_nframes);
+            snprintf(r.unit, sizeof(r.unit), "ns/fault");
+            bench_measure(&r, bench_choose_victim, &arg);
+            bench_json_result(stdout, &r);
+            policy_stop(&sim_policy);
+        }
+    }
+}
+
+double bench_e2e_run(void *arg) {
+    struct bench_arg *a = arg;
+    char path[PATH_MAX + 16];
+    snprintf(path, sizeof(path), "%s/vmappl", bindir);
+    pid_t mm = start_mmanage(a->argv[0]);
+    long long start = latency_now();
+    pid_t pid = fork();
+    TEST_AND_EXIT_ERRNO(pid == -1, "vmbench: fork failed");
+    if (pid == 0) {
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDOUT_FILENO);
+        dup2(null, STDERR_FILENO);
+        execl(path, "vmappl", a->argv[1], (char *) NULL);
+        _exit(127);
+    }
+    int status;
+    while ((waitpid(pid, &status, 0) == -1) && (errno == EINTR));
+    double t = (latency_now() - start) / 1e6;
+    stop_mmanage(mm);
+    TEST_AND_EXIT(!WIFEXITED(status) || (WEXITSTATUS(status) != 0), (stderr, "vmbench: %s %s failed\n", path, a->argv[1]));
+    return t;
+}
+
+void bench_e2e(void) {
+    for (int s = 0; s < sizeof(sorts) / sizeof(sorts[0]); s++) {
+        for (int p = 0; p < sizeof(mmanage_policies) / sizeof(mmanage_policies[0]); p++) {
+            struct bench_arg arg = { 0, { mmanage_policies[p], sorts[s] } };
+            struct bench_result r;
+            memset(&r, 0, sizeof(r));
+            snprintf(r.name, sizeof(r.name), "e2e");
+            snprintf(r.params, sizeof(r.params), "\"sort\": \"%s\", \"policy\": \"%s\"", sorts[s] + 1, mmanage_policies[p] + 1);
+            snprintf(r.unit, sizeof(r.unit), "ms");
+            bench_measure(&r, bench_e2e_run, &arg);
+            bench_json_result(stdout, &r);
+        }
+    }
+}
+
+void scan_params(int argc, char **argv) {
+    static const char *groups[] = { "-hit", "-ipc", "-pagefile", "-victim", "-e2e" };
+    bool *selected[] = { &run_hit, &run_ipc, &run_pagefile, &run_victim, &run_e2e };
+    bool any = false;
+    for (int i = 1; i < argc; i++) {
+        bool param_ok = bench_param(argv[i]);
+        for (int g = 0; g < 5; g++) {
+            if (0 == strcasecmp(groups[g], argv[i])) {
+                *selected[g] = any = param_ok = true;
+            }
+        }
+        if (!param_ok) print_usage_info_and_exit("Undefined parameter.\n");
+    }
+    if (!any) {
+        run_hit = run_ipc = run_pagefile = run_victim = run_e2e = true;
+    }
+}
+
+void print_usage_info_and_exit(char *err_str) {
+    fprintf(stderr, "Wrong parameter: %s\n", err_str);
+    fprintf(stderr, "Usage : vmbench [OPTIONS]\n");
+    fprintf(stderr, " -hit      : vmem_read / vmem_write of resident pages\n");
+    fprintf(stderr, " -ipc      : Round trip of a message to mmanage\n");
+    fprintf(stderr, " -pagefile : Page-in and page-out of each pagefile backend\n");
+    fprintf(stderr, " -victim   : Victim selection of each policy\n");
+    fprintf(stderr, " -e2e      : Wall clock time of the sorts\n");
+    fprintf(stderr, "             Without a selection all benchmarks are run.\n");
+    fprintf(stderr, " -warmup=<n> : Unrecorded runs per benchmark, default %d\n", BENCH_WARMUP);
+    fprintf(stderr, " -reps=<n> : Recorded runs per benchmark, default %d\n", BENCH_REPS);
+    fflush(stderr);
+    exit(EXIT_FAILURE);
+}
+
+// EOF
@@ -10,13 +10,20 @@
  * Dec 2015 : Add some documentation (Franz Korf, HAW Hamburg)
  * April 2018 : New IPC for mmanage and vmappl (Franz Korf, HAW Hamburg)
  * May   2022 : Change to byte machine 
+ * Oct   2026 : Optional hashed inverted page table 
+ * Oct   2026 : Several clients with separate address spaces 
+ * Oct   2026 : Dirty bitmaps with blocks smaller than a page 
+ * Oct   2026 : POSIX shared memory found by name instead of ftok 
+ * Oct   2026 : Page tables protected by VMEM_NPTLOCKS locks instead of one 
  */
 
 #ifndef VMEM_H
 #define VMEM_H
 
-#define SHMKEY          "./src/vmem.h" //!< First paremater for shared memory generation via ftok function
-#define SHMPROCID       1234           //!< Second paremater for shared memory generation via ftok function
+#include <stddef.h>
+#include <pthread.h>
+
+#define VMEM_SHMNAME    "/vmem_vm_simulation" //!< Name of the shared memory segment, see shmseg.h
 
 /**
  * Constant VMEM_PAGESIZE will be sete via compiler -D option. 
@@ -33,15 +40,62 @@
 #define VMEM_NPAGES     (VMEM_VIRTMEMSIZE / VMEM_PAGESIZE)	//!< Total number of pages 
 #define VMEM_NFRAMES (VMEM_PHYSMEMSIZE / VMEM_PAGESIZE)		//!< Total number of (page) frames 
 
+/**
+ * mmanage serves up to VMEM_MAXCLIENTS applications. Each has its own address space
+ * identified by its client number (asid). mmanage numbers the pages of all address 
+ * spaces globally: page p of client c is page c * VMEM_NPAGES + p. The global page
+ * numbers of client 0 equal its page numbers. 
+ */
+#define VMEM_MAXCLIENTS  4                                      //!< Max. number of clients
+#define VMEM_MAXPAGES    (VMEM_MAXCLIENTS * VMEM_NPAGES)        //!< Number of pages of all address spaces
+
 /**
  * page table flags used by this simulation
  */
 #define PTF_PRESENT     1 // present/absent
 #define PTF_DIRTY       2 //!< store: need to write /* modify */
 #define PTF_REF         4 //
+#define PTF_PINNED      8 //!< page has been pinned with vmem_pin and will not be evicted
 
 #define VOID_IDX -1       //!< Constant for invalid page or frame reference 
 
+/**
+ * Page table organisation, selected by mmanage at startup
+ */
+#define VMEM_PT_FLAT      0 //!< flat page table pt[] with one entry per page
+#define VMEM_PT_INVERTED  1 //!< hashed inverted page table with one entry per frame
+
+/**
+ * Access hints of vmem_advise (see vmaccess.h)
+ */
+#define VMEM_ADV_NORMAL     0 //!< No special treatment
+#define VMEM_ADV_RANDOM     1 //!< Random access: no read-around
+#define VMEM_ADV_SEQUENTIAL 2 //!< Sequential access: read-around and drop-behind
+#define VMEM_ADV_WILLNEED   3 //!< Pages will be accessed soon: load them asynchronously
+#define VMEM_ADV_DONTNEED   4 //!< Pages will not be accessed soon: free their frames
+
+/**
+ * Page replacement policy of the next run, selected with vmem_reset (see vmaccess.h)
+ */
+#define VMEM_POLICY_KEEP     0 //!< Keep the policy of mmanage
+#define VMEM_POLICY_FIFO     1 //!< First in first out
+#define VMEM_POLICY_CLOCK    2 //!< Second chance with clock hand
+#define VMEM_POLICY_AGING    3 //!< Aging with 8 bit counters
+#define VMEM_POLICY_ADAPTIVE 4 //!< Switch between fifo, clock and aging
+
+#define VMEM_LABELSIZE 32      //!< Size of the label of a run including the terminating '\0'
+
+/**
+ * Dirty blocks. With mmanage -dirtyblock=<n> vmem_write also marks the block of n 
+ * bytes it has written in the dirty bitmap of the frame. A dirty page is written 
+ * back block by block, clean blocks are skipped.
+ */
+#define VMEM_MAXBLOCKS (8 * sizeof(unsigned long long)) //!< Max. number of blocks per page
+
+#define VMEM_ASID_DEFAULT 0                   //!< Address space id of the first application
+#define VMEM_IPT_HASHSIZE (2 * VMEM_NFRAMES)  //!< Number of hash anchors of the inverted page table
+#define VMEM_NPTLOCKS     16                  //!< Number of page table locks, see struct vmem_adm
+
 /**
  * Page table entry
  */
@@ -51,13 +105,46 @@ struct pt_entry {
 };
 
 /**
- * The data structure stored in shared memory
+ * Inverted page table entry. There is one entry per frame. Entries with the same
+ * hash value of (asid, page) are chained via next.
+ */
+struct ipt_entry {
+	int asid;              //!< Address space the page belongs to
+	int page;              //!< Page stored in this frame; page == VOID_IDX: frame unused
+	int flags;             //!< See definition of PTF_* flags
+	int next;              //!< Next frame of the collision chain; VOID_IDX: end of chain
+};
+
+/**
+ * Administrative data shared by mmanage and vmappl
+ */
+struct vmem_adm {
+	int pt_mode;           //!< VMEM_PT_FLAT or VMEM_PT_INVERTED
+	int start_g_count;     //!< g_count at which vmappl starts; > 0 if mmanage restored a snapshot
+	int nclients;          //!< Number of clients served by mmanage
+	int block_size;        //!< Size of the dirty blocks in bytes; 0: no dirty bitmaps
+	char label[VMEM_LABELSIZE]; //!< Label of the next run, written by vmem_reset
+	pthread_mutex_t lock[VMEM_NPTLOCKS]; //!< Page table locks. The entry of a page is protected by
+	                       //!< lock[ipt_lock_idx()]. A client holds it from translation until the 
+	                       //!< access is done, mmanage while it changes the entry
+};
+
+/**
+ * The data structure stored in shared memory.
+ * The flat page tables must be the last member. There is one flat page table of 
+ * VMEM_NPAGES entries per client; the entry of a page is indexed by its global page 
+ * number. They will not be allocated when the inverted page table is used.
  */
 struct vmem_struct {
-	struct pt_entry pt[VMEM_NPAGES];               //!< page table 
+	struct vmem_adm adm;                           //!< administrative data
+	int ipt_hash[VMEM_IPT_HASHSIZE];               //!< hash anchors of inverted page table 
+	struct ipt_entry ipt[VMEM_NFRAMES];            //!< inverted page table 
 	unsigned char mainMemory[VMEM_NFRAMES * VMEM_PAGESIZE];  //!< main memory used by virtual memory simulation 
+	unsigned long long dirty_blocks[VMEM_NFRAMES]; //!< dirty bitmap per frame, bit i: block i has been written
+	struct pt_entry pt[];                          //!< flat page tables 
 };
 
-#define SHMSIZE (sizeof(struct vmem_struct)) //!< size of virtual memory 
+#define SHMSIZE_INVERTED (offsetof(struct vmem_struct, pt)) //!< size of virtual memory without flat page table
+#define SHMSIZE(nclients) (SHMSIZE_INVERTED + (nclients) * VMEM_NPAGES * sizeof(struct pt_entry)) //!< size of virtual memory 
 
 #endif /* VMEM_H */
@@ -0,0 +1,197 @@
+/**
+ * @file vmmon.c
+ * @date Oct 2026
+ * @brief Monitor of a running mmanage in the style of vmstat.
+ *        vmmon maps the statistics segment of mmanage (see vmstats.h) read-only and
+ *        prints a line per interval: the rates of messages, IPC round trips, page
+ *        faults, prefetches, evictions and write backs, the mean scan length of the
+ *        policy and the current state of the queue and the frames. With several
+ *        clients the page fault rate of each client follows. mmanage is not paused
+ *        or signalled, so short intervals are possible.
+ *        vmmon exits when mmanage has terminated.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include "vmstats.h"
+#include "error.h"
+
+#define VMMON_HEADER_LINES 20       //!< The header is repeated after this many lines
+
+/**
+ * Copy of the counters that change over time
+ */
+struct sample {
+    double t;                       //!< Time in seconds
+    long msgs, acks, faults, prefetches, evictions, writebacks, victims, scan_steps;
+    long client_faults[VMEM_MAXCLIENTS];
+};
+
+static int interval_ms = 1000;      //!< Sampling interval according to parameters of vmmon
+static long count = 0;              //!< Number of lines according to parameters of vmmon; 0: unlimited
+static bool totals = false;         //!< Print the totals since the start of mmanage instead of rates
+
+/**
+ *****************************************************************************************
+ *  @brief      This function scans all parameters of the program.
+ *              The corresponding global variables interval_ms, count and totals will be set.
+ *
+ *  @param      argc number of parameter
+ *
+ *  @param      argv parameter list
+ *
+ *  @return     void
+ ****************************************************************************************/
+static void scan_params(int argc, char **argv);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function prints an error message and the usage information of
+ *              this program.
+ *
+ *  @param      err_str pointer to the error string that should be printed.
+ *
+ *  @return     void
+ ****************************************************************************************/
+static void print_usage_info_and_exit(char *err_str);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function copies the counters of the segment.
+ *
+ *  @param      s The segment.
+ *
+ *  @param      smp Filled with the counters.
+ *
+ *  @return     void
+ ****************************************************************************************/
+static void take_sample(const struct vmstats *s, struct sample *smp);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function prints the column headers.
+ *
+ *  @param      nclients Number of clients of mmanage.
+ *
+ *  @return     void
+ ****************************************************************************************/
+static void print_header(int nclients);
+
+int main(int argc, char **argv) {
+    scan_params(argc, argv);
+    const struct vmstats *s = vmstats_attach();
+    TEST_AND_EXIT(!s, (stderr, "vmmon: mmanage is not running\n"));
+    int nclients = s->nclients;
+    printf("mmanage pid %d, policy %s, %d clients, %d frames of %d bytes\n",
+           s->pid, s->policy, nclients, s->nframes, s->pagesize);
+
+    struct sample prev, cur;
+    memset(&prev, 0, sizeof(prev));
+    if (!totals) {
+        take_sample(s, &prev);
+    }
+    struct timespec delay = { interval_ms / 1000, (interval_ms % 1000) * 1000000L };
+    for (long line = 0; (count == 0) || (line < count); line++) {
+        while ((nanosleep(&delay, &delay) == -1) && (errno == EINTR));
+        delay.tv_sec = interval_ms / 1000;
+        delay.tv_nsec = (interval_ms % 1000) * 1000000L;
+        if ((kill(s->pid, 0) == -1) && (errno == ESRCH)) {
+            printf("mmanage has terminated\n");
+            break;
+        }
+        take_sample(s, &cur);
+        if (line % VMMON_HEADER_LINES == 0) {
+            print_header(nclients);
+        }
+        // rates per second, or totals if prev is zero
+        double dt = totals ? 1.0 : cur.t - prev.t;
+        long victims = cur.victims - prev.victims;
+        printf("%8.0f %8.0f %8.0f %8.0f %8.0f %8.0f %6.1f %5ld %5ld %5ld %5ld %4ld",
+               (cur.msgs - prev.msgs) / dt, (cur.acks - prev.acks) / dt, (cur.faults - prev.faults) / dt,
+               (cur.prefetches - prev.prefetches) / dt, (cur.evictions - prev.evictions) / dt,
+               (cur.writebacks - prev.writebacks) / dt,
+               victims ? (double) (cur.scan_steps - prev.scan_steps) / victims : 0.0, VMSTATS_GET(s->scan_max),
+               VMSTATS_GET(s->queue_depth), VMSTATS_GET(s->queue_max), VMSTATS_GET(s->resident), VMSTATS_GET(s->pinned));
+        for (int c = 0; (nclients > 1) && (c < nclients); c++) {
+            printf(" %8.0f", (cur.client_faults[c] - prev.client_faults[c]) / dt);
+        }
+        printf("\n");
+        fflush(stdout);
+        if (!totals) {
+            prev = cur;
+        }
+    }
+    return 0;
+}
+
+void take_sample(const struct vmstats *s, struct sample *smp) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    smp->t = ts.tv_sec + ts.tv_nsec / 1e9;
+    smp->msgs = VMSTATS_GET(s->msgs);
+    smp->acks = VMSTATS_GET(s->acks);
+    smp->faults = VMSTATS_GET(s->faults);
+    smp->prefetches = VMSTATS_GET(s->prefetches);
+    smp->evictions = VMSTATS_GET(s->evictions);
+    smp->writebacks = VMSTATS_GET(s->writebacks);
+    smp->victims = VMSTATS_GET(s->victims);
+    smp->scan_steps = VMSTATS_GET(s->scan_steps);
+    for (int c = 0; c < VMEM_MAXCLIENTS; c++) {
+        smp->client_faults[c] = VMSTATS_GET(s->client_faults[c]);
+    }
+}
+
+void print_header(int nclients) {
+    const char *unit = totals ? "" : "/s";
+    char col[16];
+    printf("%6s%-2s %6s%-2s %6s%-2s %6s%-2s %6s%-2s %6s%-2s %6s %5s %5s %5s %5s %4s",
+           "msgs", unit, "acks", unit, "flts", unit, "pref", unit, "evict", unit, "wb", unit,
+           "scan", "smax", "qdep", "qmax", "res", "pin");
+    for (int c = 0; (nclients > 1) && (c < nclients); c++) {
+        snprintf(col, sizeof(col), "c%d%s", c, unit);
+        printf(" %8s", col);
+    }
+    printf("\n");
+}
+
+void scan_params(int argc, char **argv) {
+    const char *interval_str = "-interval=";
+    const char *count_str = "-count=";
+    for (int i = 1; i < argc; i++) {
+        bool param_ok = false;
+        if (0 == strncasecmp(interval_str, argv[i], strlen(interval_str))) {
+            // sampling interval in milliseconds
+            if ((1 == sscanf(argv[i] + strlen(interval_str), "%d", &interval_ms)) && (interval_ms >= 1)) {
+                param_ok = true;
+            }
+        }
+        if (0 == strncasecmp(count_str, argv[i], strlen(count_str))) {
+            // number of lines
+            if ((1 == sscanf(argv[i] + strlen(count_str), "%ld", &count)) && (count >= 0)) {
+                param_ok = true;
+            }
+        }
+        if (0 == strcasecmp("-totals", argv[i])) {
+            totals = true;
+            param_ok = true;
+        }
+        if (!param_ok) print_usage_info_and_exit("Undefined parameter.\n");
+    }
+}
+
+void print_usage_info_and_exit(char *err_str) {
+    fprintf(stderr, "Wrong parameter: %s\n", err_str);
+    fprintf(stderr, "Usage : vmmon [OPTIONS]\n");
+    fprintf(stderr, " -interval=<ms> : Sampling interval in milliseconds, default 1000\n");
+    fprintf(stderr, " -count=<n> : Stop after n lines, default 0 (unlimited)\n");
+    fprintf(stderr, " -totals : Print the totals since the start of mmanage instead of rates\n");
+    fflush(stderr);
+    exit(EXIT_FAILURE);
+}
+
+// EOF
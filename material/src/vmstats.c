@@ -0,0 +1,72 @@
+/**
+ * @file vmstats.c
+ * @date Oct 2026
+ * @brief This module implements the statistics segment of mmanage, see vmstats.h.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "vmstats.h"
+#include "error.h"
+
+static struct vmstats *stats = NULL;    //!< Segment created by this process
+
+void vmstats_max(long *counter, long v) {
+    long old = __atomic_load_n(counter, __ATOMIC_RELAXED);
+    while ((old < v) && !__atomic_compare_exchange_n(counter, &old, v, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+struct vmstats *vmstats_create(int nclients, const char *policy) {
+    // a monitor may still map the segment of a previous run
+    shm_unlink(VMSTATS_SHMNAME);
+    int fd = shm_open(VMSTATS_SHMNAME, O_CREAT | O_EXCL | O_RDWR, 0644);
+    TEST_AND_EXIT_ERRNO(fd == -1, "vmstats_create: shm_open failed");
+    TEST_AND_EXIT_ERRNO(ftruncate(fd, sizeof(struct vmstats)) == -1, "vmstats_create: ftruncate failed");
+    stats = mmap(NULL, sizeof(struct vmstats), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    TEST_AND_EXIT_ERRNO(stats == MAP_FAILED, "vmstats_create: mmap failed");
+    close(fd);
+
+    memset(stats, 0, sizeof(struct vmstats));
+    stats->pid = getpid();
+    stats->nclients = nclients;
+    stats->nframes = VMEM_NFRAMES;
+    stats->pagesize = VMEM_PAGESIZE;
+    strncpy(stats->policy, policy, sizeof(stats->policy) - 1);
+    __atomic_store_n(&stats->magic, VMSTATS_MAGIC, __ATOMIC_RELEASE);
+    return stats;
+}
+
+void vmstats_reset(const char *policy) {
+    __atomic_store_n(&stats->magic, 0, __ATOMIC_RELEASE);
+    memset(&stats->msgs, 0, sizeof(struct vmstats) - offsetof(struct vmstats, msgs));
+    memset(stats->policy, 0, sizeof(stats->policy));
+    strncpy(stats->policy, policy, sizeof(stats->policy) - 1);
+    __atomic_store_n(&stats->magic, VMSTATS_MAGIC, __ATOMIC_RELEASE);
+}
+
+void vmstats_destroy(void) {
+    if (stats) {
+        // threads of mmanage may still update the counters until it exits
+        shm_unlink(VMSTATS_SHMNAME);
+        stats = NULL;
+    }
+}
+
+const struct vmstats *vmstats_attach(void) {
+    int fd = shm_open(VMSTATS_SHMNAME, O_RDONLY, 0);
+    if (fd == -1) {
+        return NULL;
+    }
+    const struct vmstats *s = mmap(NULL, sizeof(struct vmstats), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if ((s == MAP_FAILED) || (__atomic_load_n(&s->magic, __ATOMIC_ACQUIRE) != VMSTATS_MAGIC)) {
+        return NULL;
+    }
+    return s;
+}
+
+// EOF
@@ -0,0 +1,108 @@
+/**
+ * @file vmstats.h
+ * @date Oct 2026
+ * @brief Header file of the statistics segment of mmanage.
+ *        mmanage publishes its counters in a POSIX shared memory segment. Monitors
+ *        like vmmon map it read-only and sample it while mmanage runs, without any
+ *        interaction with mmanage.
+ *
+ *        mmanage updates the counters with relaxed atomic operations. A reader never
+ *        sees a torn counter, but two counters read one after the other may belong
+ *        to slightly different moments.
+ */
+
+#ifndef VMSTATS_H
+#define VMSTATS_H
+
+#include "vmem.h"
+
+#define VMSTATS_SHMNAME "/vmstats_vm_simulation" //!< Name of the shared memory segment
+#define VMSTATS_MAGIC   0x564D5354               //!< Identifies an initialized segment ("VMST")
+
+/**
+ * Counters of mmanage. All counters except the configuration only grow, unless
+ * noted otherwise.
+ */
+struct vmstats {
+    int magic;                  //!< VMSTATS_MAGIC, set when the configuration is valid
+    int pid;                    //!< Process id of mmanage
+    int nclients;               //!< Number of clients served
+    int nframes;                //!< VMEM_NFRAMES
+    int pagesize;               //!< VMEM_PAGESIZE
+    char policy[16];            //!< Name of the page replacement policy
+    long msgs;                  //!< Messages received from the clients
+    long acks;                  //!< Messages acknowledged, i.e. completed IPC round trips
+    long faults;                //!< Page faults
+    long prefetches;            //!< Pages loaded due to access hints
+    long evictions;             //!< Pages removed from memory
+    long writebacks;            //!< Dirty pages written back to the pagefile
+    long victims;               //!< Victims selected by the policy
+    long scan_steps;            //!< Reference bits and pins tested by the policy while selecting victims
+    long scan_max;              //!< Max. number of steps to select one victim
+    long queue_depth;           //!< Messages waiting for a worker thread (may shrink)
+    long queue_max;             //!< Max. of queue_depth
+    long resident;              //!< Frames storing a page (may shrink)
+    long pinned;                //!< Pinned pages (may shrink)
+    long client_faults[VMEM_MAXCLIENTS]; //!< Page faults of each client
+};
+
+/**
+ * Access to the counters. Writers use VMSTATS_ADD, VMSTATS_SET and vmstats_max,
+ * readers VMSTATS_GET.
+ */
+#define VMSTATS_ADD(counter, n) __atomic_fetch_add(&(counter), (n), __ATOMIC_RELAXED)
+#define VMSTATS_SET(counter, v) __atomic_store_n(&(counter), (v), __ATOMIC_RELAXED)
+#define VMSTATS_GET(counter)    __atomic_load_n(&(counter), __ATOMIC_RELAXED)
+
+/**
+ *****************************************************************************************
+ *  @brief      This function raises a counter to a value, if it is lower.
+ *
+ *  @param      counter The counter, e.g. &stats->queue_max.
+ *  @param      v The value.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void vmstats_max(long *counter, long v);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function creates the segment. It is called by mmanage, which is
+ *              the only writer.
+ *
+ *  @param      nclients Number of clients served.
+ *  @param      policy Name of the page replacement policy.
+ *
+ *  @return     The segment, all counters are zero.
+ ****************************************************************************************/
+struct vmstats *vmstats_create(int nclients, const char *policy);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function sets all counters of the segment to zero when mmanage 
+ *              starts a new run (CMD_RESET). A monitor sees them shrink once.
+ *
+ *  @param      policy Name of the page replacement policy of the new run.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void vmstats_reset(const char *policy);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function removes the name of the segment. The mappings of mmanage
+ *              and of the monitors stay valid.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void vmstats_destroy(void);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function maps the segment of a running mmanage read-only.
+ *
+ *  @return     The segment; NULL if mmanage has not created it.
+ ****************************************************************************************/
+const struct vmstats *vmstats_attach(void);
+
+#endif /* VMSTATS_H */
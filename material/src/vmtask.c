@@ -0,0 +1,147 @@
+/**
+ * @file vmtask.c
+ * @date Oct 2026
+ * @brief This module implements the lightweight tasks of an application, see vmtask.h.
+ *        The scheduler runs on the stack of the caller of vmtask_run. A task waiting
+ *        for the memory manager switches back to the scheduler, which resumes the next
+ *        ready task. The scheduler blocks only if no task is ready.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ucontext.h>
+#include "vmtask.h"
+#include "vmem.h"
+#include "error.h"
+
+#define TASK_READY        0             //!< Task can run
+#define TASK_WAIT_CHANNEL 1             //!< Task waits until the channel to mmanage is free
+#define TASK_WAIT_ACK     2             //!< Task waits for the ACK of its message
+#define TASK_DONE         3             //!< Task has finished
+
+struct task {
+    ucontext_t ctx;
+    void (*fn)(void *arg);
+    void *arg;
+    int state;                          //!< TASK_*
+    void *stack;
+};
+
+static struct task tasks[VMTASK_MAX];
+static int ntasks = 0;                  //!< Number of tasks
+static int current = VOID_IDX;          //!< Running task; VOID_IDX: scheduler or no tasks
+static int channel_owner = VOID_IDX;    //!< Task whose message is outstanding
+static ucontext_t sched_ctx;            //!< Context of the scheduler
+static long nmsgs = 0;                  //!< Number of messages sent by tasks
+static long nswitches = 0;              //!< Number of task switches
+static long nblocked = 0;               //!< Number of times no task could run
+
+static void task_main(int t) {
+    tasks[t].fn(tasks[t].arg);
+    tasks[t].state = TASK_DONE;
+    // returning resumes the scheduler via uc_link
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function switches from the running task to the scheduler.
+ ****************************************************************************************/
+static void yield(void) {
+    TEST_AND_EXIT_ERRNO(swapcontext(&tasks[current].ctx, &sched_ctx) == -1, "vmtask: swapcontext failed");
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function is called when the ACK of the outstanding message has
+ *              arrived. The channel becomes free.
+ ****************************************************************************************/
+static void ack_received(void) {
+    tasks[channel_owner].state = TASK_READY;
+    channel_owner = VOID_IDX;
+    for (int t = 0; t < ntasks; t++) {
+        if (tasks[t].state == TASK_WAIT_CHANNEL) {
+            tasks[t].state = TASK_READY;
+        }
+    }
+}
+
+void vmtask_spawn(void (*fn)(void *arg), void *arg) {
+    TEST_AND_EXIT(ntasks >= VMTASK_MAX, (stderr, "vmtask_spawn: too many tasks\n"));
+    struct task *t = &tasks[ntasks];
+    t->fn = fn;
+    t->arg = arg;
+    t->state = TASK_READY;
+    t->stack = malloc(VMTASK_STACKSIZE);
+    TEST_AND_EXIT_ERRNO(!t->stack, "vmtask_spawn: malloc failed");
+    TEST_AND_EXIT_ERRNO(getcontext(&t->ctx) == -1, "vmtask_spawn: getcontext failed");
+    t->ctx.uc_stack.ss_sp = t->stack;
+    t->ctx.uc_stack.ss_size = VMTASK_STACKSIZE;
+    t->ctx.uc_link = &sched_ctx;
+    makecontext(&t->ctx, (void (*)(void)) task_main, 1, ntasks);
+    ntasks++;
+}
+
+void vmtask_run(void) {
+    int next = 0;
+    int done = 0;
+    while (done < ntasks) {
+        // round robin over the ready tasks
+        int t = next;
+        while (tasks[t].state != TASK_READY) {
+            t = (t + 1) % ntasks;
+            if (t == next) {
+                break;
+            }
+        }
+        if (tasks[t].state == TASK_READY) {
+            current = t;
+            nswitches++;
+            TEST_AND_EXIT_ERRNO(swapcontext(&sched_ctx, &tasks[t].ctx) == -1, "vmtask: swapcontext failed");
+            current = VOID_IDX;
+            if (tasks[t].state == TASK_DONE) {
+                free(tasks[t].stack);
+                tasks[t].stack = NULL;
+                done++;
+            }
+            next = (t + 1) % ntasks;
+            if ((channel_owner != VOID_IDX) && pollAckFromMmanager(false)) {
+                ack_received();
+            }
+        } else if (channel_owner != VOID_IDX) {
+            // all tasks wait for the memory manager
+            nblocked++;
+            pollAckFromMmanager(true);
+            ack_received();
+        }
+    }
+    ntasks = 0;
+}
+
+bool vmtask_wait_channel(void) {
+    bool waited = false;
+    while ((current != VOID_IDX) && (channel_owner != VOID_IDX)) {
+        tasks[current].state = TASK_WAIT_CHANNEL;
+        yield();
+        waited = true;
+    }
+    return waited;
+}
+
+void vmtask_send(struct msg msg) {
+    if (current == VOID_IDX) {
+        sendMsgToMmanager(msg);
+        return;
+    }
+    vmtask_wait_channel();
+    postMsgToMmanager(msg);
+    nmsgs++;
+    channel_owner = current;
+    tasks[current].state = TASK_WAIT_ACK;
+    yield();
+}
+
+void vmtask_stats(void) {
+    fprintf(stderr, "Tasks: %ld messages, %ld task switches, %ld times all tasks waited\n", nmsgs, nswitches, nblocked);
+}
+
+// EOF
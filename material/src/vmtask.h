@@ -0,0 +1,73 @@
+/**
+ * @file vmtask.h
+ * @date Oct 2026
+ * @brief Header file of the lightweight tasks of an application of the virtual memory.
+ *        Tasks are coroutines with their own stacks (ucontext). If a task causes a
+ *        page fault while it runs under vmtask_run, only this task waits for the memory
+ *        manager; the other tasks keep running on resident pages. Since a client has
+ *        a single channel to mmanage, one message is outstanding at a time; further
+ *        faults wait until the channel is free.
+ */
+
+#ifndef VMTASK_H
+#define VMTASK_H
+
+#include <stdbool.h>
+#include "syncdataexchange.h"
+
+#define VMTASK_MAX       16             //!< Max. number of tasks
+#define VMTASK_STACKSIZE (64 * 1024)    //!< Stack size of a task in bytes
+
+/**
+ *****************************************************************************************
+ *  @brief      This function creates a task. It starts running with vmtask_run.
+ *
+ *  @param      fn Function of the task.
+ *  @param      arg Argument passed to fn.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void vmtask_spawn(void (*fn)(void *arg), void *arg);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function runs all tasks created by vmtask_spawn until they have
+ *              finished. The tasks are switched in round robin order whenever the
+ *              running task waits for the memory manager.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void vmtask_run(void);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function suspends the calling task until the channel to the memory
+ *              manager is free. Outside a task it returns at once.
+ *
+ *  @return     true if the task had to wait. Other tasks may have changed the memory
+ *              meanwhile, e.g. their page faults may have loaded the page.
+ ****************************************************************************************/
+bool vmtask_wait_channel(void);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function sends a message to the memory manager and returns after
+ *              its ACK. Called by a task, it suspends only this task. Otherwise it
+ *              blocks like sendMsgToMmanager.
+ *
+ *  @param      msg Message to be send.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void vmtask_send(struct msg msg);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function prints the number of messages and how often all tasks
+ *              had to wait for the memory manager.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void vmtask_stats(void);
+
+#endif /* VMTASK_H */
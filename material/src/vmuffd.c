@@ -0,0 +1,299 @@
+/**
+ * @file vmuffd.c
+ * @date Oct 2026
+ * @brief This module implements the native mode of the virtual memory, see vmuffd.h.
+ *        The handler thread is the only one that changes the state of the frames,
+ *        the application only causes faults.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "vmuffd.h"
+#include "vmem.h"
+#include "error.h"
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/userfaultfd.h>
+
+static unsigned char *region = NULL;    //!< Start of the region
+static long psize = 0;                  //!< Page size of the operating system
+static int npages = 0;                  //!< Number of pages of the region
+static int nframes = 0;                 //!< Max. number of resident pages
+static int nused = 0;                   //!< Number of frames in use
+static struct policy policy;            //!< Instance of the page replacement policy
+static int uffd = -1;                   //!< userfaultfd of the region
+static int stop_pipe[2] = { -1, -1 };   //!< Written to stop the handler thread
+static FILE *backing = NULL;            //!< Backing file, removed when closed
+static pthread_t handler;
+static unsigned char *buf = NULL;       //!< Page buffer for UFFDIO_COPY
+static struct vmuffd_stats stats;
+
+static int *frame_page = NULL;          //!< Page stored in each frame; VOID_IDX: unused
+static bool *frame_dirty = NULL;        //!< Page has been written since it was loaded
+static bool *frame_ref = NULL;          //!< Page has been written since the reference bit was reset
+static int *page_frame = NULL;          //!< Frame of each page; VOID_IDX: not resident
+static bool *page_stored = NULL;        //!< Backing file holds the contents of the page; otherwise it is zero
+
+/**
+ *****************************************************************************************
+ *  @brief      This function sets or removes the write protection of a resident page.
+ *              Removing it wakes the thread that waits for the page.
+ ****************************************************************************************/
+static void protect(int page, bool wp) {
+    struct uffdio_writeprotect w;
+    w.range.start = (unsigned long) (region + (size_t) page * psize);
+    w.range.len = psize;
+    w.mode = wp ? UFFDIO_WRITEPROTECT_MODE_WP : 0;
+    TEST_AND_EXIT_ERRNO(ioctl(uffd, UFFDIO_WRITEPROTECT, &w) == -1, "vmuffd: UFFDIO_WRITEPROTECT failed");
+}
+
+/*
+ * Functions passed to the policy, see struct policy_env
+ */
+static int env_page_of_frame(const struct policy_env *env, int frame) {
+    return frame_page[frame];
+}
+
+static bool env_test_ref(const struct policy_env *env, int frame) {
+    return (frame_page[frame] != VOID_IDX) && frame_ref[frame];
+}
+
+static void env_clear_ref(const struct policy_env *env, int frame) {
+    if ((frame_page[frame] != VOID_IDX) && frame_ref[frame]) {
+        // the next write traps again and sets the bit
+        frame_ref[frame] = false;
+        protect(frame_page[frame], true);
+    }
+}
+
+static bool env_pinned(const struct policy_env *env, int frame) {
+    return false;
+}
+
+static struct policy_env env = { 0, env_page_of_frame, env_test_ref, env_clear_ref, env_pinned };
+
+/**
+ *****************************************************************************************
+ *  @brief      This function removes the page stored in a frame from memory. A dirty
+ *              page is written to the backing file first.
+ ****************************************************************************************/
+static void evict(int frame) {
+    int page = frame_page[frame];
+    unsigned char *addr = region + (size_t) page * psize;
+    if (frame_dirty[frame]) {
+        // the page is still write protected if it has not been written since the last tick
+        if (frame_ref[frame]) {
+            protect(page, true);
+        }
+        TEST_AND_EXIT_ERRNO(pwrite(fileno(backing), addr, psize, (off_t) page * psize) != psize,
+                            "vmuffd: Error writing page to backing file");
+        page_stored[page] = true;
+        stats.writes++;
+    }
+    TEST_AND_EXIT_ERRNO(madvise(addr, psize, MADV_DONTNEED) == -1, "vmuffd: madvise failed");
+    page_frame[page] = VOID_IDX;
+    frame_page[frame] = VOID_IDX;
+    stats.evictions++;
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function loads a page into a frame. It is mapped write protected,
+ *              the thread waiting for it is woken.
+ ****************************************************************************************/
+static void load(int page) {
+    int frame;
+    if (nused < nframes) {
+        frame = nused++;
+    } else {
+        frame = policy.ops->choose_victim(policy.state, &env, page);
+        evict(frame);
+    }
+    if (page_stored[page]) {
+        TEST_AND_EXIT_ERRNO(pread(fileno(backing), buf, psize, (off_t) page * psize) != psize,
+                            "vmuffd: Error reading page from backing file");
+        stats.reads++;
+    } else {
+        memset(buf, 0, psize);
+    }
+    struct uffdio_copy c;
+    c.dst = (unsigned long) (region + (size_t) page * psize);
+    c.src = (unsigned long) buf;
+    c.len = psize;
+    c.mode = UFFDIO_COPY_MODE_WP;
+    c.copy = 0;
+    TEST_AND_EXIT_ERRNO(ioctl(uffd, UFFDIO_COPY, &c) == -1, "vmuffd: UFFDIO_COPY failed");
+    frame_page[frame] = page;
+    frame_dirty[frame] = false;
+    frame_ref[frame] = true;
+    page_frame[page] = frame;
+    if (policy.ops->on_fault) {
+        policy.ops->on_fault(policy.state, &env, page, frame);
+    }
+    stats.faults++;
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function passes the reference bits to the policy and resets them,
+ *              like harvest_references in mmanage.
+ ****************************************************************************************/
+static void tick(void) {
+    if (policy.ops->on_access) {
+        for (int i = 0; i < nused; i++) {
+            if (env_test_ref(&env, i)) {
+                policy.ops->on_access(policy.state, &env, i);
+                env_clear_ref(&env, i);
+            }
+        }
+    }
+    if (policy.ops->on_tick) {
+        policy.ops->on_tick(policy.state, &env);
+    }
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function is the main function of the handler thread.
+ ****************************************************************************************/
+static void *handle_faults(void *arg) {
+    struct pollfd fds[2] = { { uffd, POLLIN, 0 }, { stop_pipe[0], POLLIN, 0 } };
+    long events = 0;
+    while (1) {
+        TEST_AND_EXIT_ERRNO((poll(fds, 2, -1) == -1) && (errno != EINTR), "vmuffd: poll failed");
+        if (fds[1].revents) {
+            return NULL;
+        }
+        if (!(fds[0].revents & POLLIN)) {
+            continue;
+        }
+        struct uffd_msg msg;
+        ssize_t n = read(uffd, &msg, sizeof(msg));
+        if ((n == -1) && (errno == EAGAIN)) {
+            continue;
+        }
+        TEST_AND_EXIT_ERRNO(n != sizeof(msg), "vmuffd: Error reading userfaultfd");
+        if (msg.event != UFFD_EVENT_PAGEFAULT) {
+            continue;
+        }
+        int page = (msg.arg.pagefault.address - (unsigned long) region) / psize;
+        int frame = page_frame[page];
+        if (frame == VOID_IDX) {
+            // the page may have been evicted after a write protection fault was queued
+            load(page);
+        } else if (msg.arg.pagefault.flags & UFFD_PAGEFAULT_FLAG_WP) {
+            frame_dirty[frame] = true;
+            frame_ref[frame] = true;
+            protect(page, false);
+            stats.wp_faults++;
+        } else {
+            // another thread has caused the fault that loaded the page
+            struct uffdio_range r = { (unsigned long) (region + (size_t) page * psize), psize };
+            TEST_AND_EXIT_ERRNO(ioctl(uffd, UFFDIO_WAKE, &r) == -1, "vmuffd: UFFDIO_WAKE failed");
+        }
+        if (++events % VMUFFD_TICK == 0) {
+            tick();
+        }
+    }
+}
+
+unsigned char *vmuffd_map(size_t size, int frames, const struct policy_ops *ops) {
+    TEST_AND_EXIT(region != NULL, (stderr, "vmuffd_map: region already mapped\n"));
+    TEST_AND_EXIT((size == 0) || (frames < 1), (stderr, "vmuffd_map: invalid size or number of frames\n"));
+    psize = sysconf(_SC_PAGESIZE);
+    npages = (size + psize - 1) / psize;
+    nframes = (frames < npages) ? frames : npages;
+    nused = 0;
+    memset(&stats, 0, sizeof(stats));
+
+    frame_page = malloc(nframes * sizeof(int));
+    frame_dirty = calloc(nframes, sizeof(bool));
+    frame_ref = calloc(nframes, sizeof(bool));
+    page_frame = malloc(npages * sizeof(int));
+    page_stored = calloc(npages, sizeof(bool));
+    buf = malloc(psize);
+    TEST_AND_EXIT_ERRNO(!frame_page || !frame_dirty || !frame_ref || !page_frame || !page_stored || !buf,
+                        "vmuffd_map: malloc failed");
+    for (int i = 0; i < nframes; i++) {
+        frame_page[i] = VOID_IDX;
+    }
+    for (int i = 0; i < npages; i++) {
+        page_frame[i] = VOID_IDX;
+    }
+    backing = tmpfile();
+    TEST_AND_EXIT_ERRNO(!backing, "vmuffd_map: Cannot create backing file");
+
+    region = mmap(NULL, (size_t) npages * psize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    TEST_AND_EXIT_ERRNO(region == MAP_FAILED, "vmuffd_map: mmap failed");
+
+    // user mode faults suffice and need no privileges
+    uffd = syscall(SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK | UFFD_USER_MODE_ONLY);
+    if ((uffd == -1) && (errno == EINVAL)) {
+        uffd = syscall(SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK);
+    }
+    TEST_AND_EXIT_ERRNO(uffd == -1, "vmuffd_map: userfaultfd failed");
+    struct uffdio_api api = { .api = UFFD_API, .features = UFFD_FEATURE_PAGEFAULT_FLAG_WP };
+    TEST_AND_EXIT_ERRNO(ioctl(uffd, UFFDIO_API, &api) == -1, "vmuffd_map: UFFDIO_API failed");
+    struct uffdio_register reg;
+    reg.range.start = (unsigned long) region;
+    reg.range.len = (size_t) npages * psize;
+    reg.mode = UFFDIO_REGISTER_MODE_MISSING | UFFDIO_REGISTER_MODE_WP;
+    TEST_AND_EXIT_ERRNO(ioctl(uffd, UFFDIO_REGISTER, &reg) == -1, "vmuffd_map: UFFDIO_REGISTER failed");
+
+    env.nframes = nframes;
+    policy_start(&policy, ops, &env);
+    TEST_AND_EXIT_ERRNO(pipe(stop_pipe) == -1, "vmuffd_map: pipe failed");
+    TEST_AND_EXIT(pthread_create(&handler, NULL, handle_faults, NULL) != 0, (stderr, "vmuffd_map: Cannot create handler thread\n"));
+    return region;
+}
+
+void vmuffd_unmap(void) {
+    if (region == NULL) {
+        return;
+    }
+    TEST_AND_EXIT_ERRNO(write(stop_pipe[1], "", 1) != 1, "vmuffd_unmap: write failed");
+    pthread_join(handler, NULL);
+    close(stop_pipe[0]);
+    close(stop_pipe[1]);
+    close(uffd);
+    munmap(region, (size_t) npages * psize);
+    fclose(backing);
+    policy_stop(&policy);
+    free(frame_page);
+    free(frame_dirty);
+    free(frame_ref);
+    free(page_frame);
+    free(page_stored);
+    free(buf);
+    region = NULL;
+}
+
+#else /* __linux__ */
+
+static struct vmuffd_stats stats;
+
+unsigned char *vmuffd_map(size_t size, int nframes, const struct policy_ops *policy) {
+    TEST_AND_EXIT(true, (stderr, "vmuffd_map: the native mode requires Linux (userfaultfd)\n"));
+    return NULL;
+}
+
+void vmuffd_unmap(void) {
+}
+
+#endif /* __linux__ */
+
+void vmuffd_get_stats(struct vmuffd_stats *st) {
+    *st = stats;
+}
+
+// EOF
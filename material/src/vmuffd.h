@@ -0,0 +1,73 @@
+/**
+ * @file vmuffd.h
+ * @date Oct 2026
+ * @brief Header file of the native mode of the virtual memory (Linux only).
+ *        The application gets a real mapped region and accesses it with ordinary
+ *        pointers. The region is registered with userfaultfd: the first touch of a
+ *        page that is not resident traps to a handler thread, which loads the page
+ *        from a backing file. At most nframes pages are resident; if all frames are
+ *        in use, a page replacement policy of policy.h selects the victim, which is
+ *        removed with madvise(MADV_DONTNEED).
+ *
+ *        Resident pages are write protected until the first write after they have
+ *        been loaded or their reference bit has been reset. The write protection
+ *        fault marks the page dirty and referenced. Reads of resident pages do not
+ *        trap, so the policies see writes only.
+ *
+ *        Pages have the size of the pages of the operating system, not VMEM_PAGESIZE.
+ *        The handler runs in the process of the application, mmanage is not involved.
+ */
+
+#ifndef VMUFFD_H
+#define VMUFFD_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include "policy.h"
+
+#define VMUFFD_TICK  8      //!< Page faults per time interval of the policy
+
+/**
+ * Counters of the native mode
+ */
+struct vmuffd_stats {
+    long faults;            //!< Page faults (first touch of a page that is not resident)
+    long wp_faults;         //!< Write protection faults (first write to a resident page)
+    long evictions;         //!< Pages removed from memory
+    long reads;             //!< Pages read from the backing file
+    long writes;            //!< Pages written to the backing file
+};
+
+/**
+ *****************************************************************************************
+ *  @brief      This function creates the region and starts the handler thread.
+ *              Only one region can exist at a time.
+ *
+ *  @param      size Size of the region in bytes.
+ *  @param      nframes Max. number of resident pages, >= 1.
+ *  @param      policy Page replacement policy, e.g. &policy_clock.
+ *
+ *  @return     Start address of the region. Its contents are initially zero.
+ ****************************************************************************************/
+unsigned char *vmuffd_map(size_t size, int nframes, const struct policy_ops *policy);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function stops the handler thread and removes the region and the
+ *              backing file.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void vmuffd_unmap(void);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function returns the counters of the native mode.
+ *
+ *  @param      st Filled with the counters.
+ *
+ *  @return     void
+ ****************************************************************************************/
+void vmuffd_get_stats(struct vmuffd_stats *st);
+
+#endif /* VMUFFD_H */
@@ -0,0 +1,364 @@
+/**
+ * @file workload.c
+ * @date Oct 2026
+ * @brief This module implements the workloads of vmappl, see workload.h.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "workload.h"
+#include "vmem.h"
+#include "my_rand.h"
+#include "error.h"
+
+#define WORKLOAD_NODESIZE 4     //!< Size of a node of list in bytes
+#define WORKLOAD_SLOTSIZE 3     //!< Size of a slot of hash in bytes
+#define WORKLOAD_MAXINDEX 65536 //!< Number of values of a 16 bit index or key
+
+/**
+ *****************************************************************************************
+ *  @brief      These functions read and write a 16 bit value (big endian).
+ ****************************************************************************************/
+static int get16(const struct workload_mem *m, int addr) {
+    return (m->get(addr) << 8) | m->get(addr + 1);
+}
+
+static void put16(const struct workload_mem *m, int addr, int val) {
+    m->put(addr, val >> 8);
+    m->put(addr + 1, val & 0xff);
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function fills a range with random bytes.
+ ****************************************************************************************/
+static void fill_random(const struct workload_mem *m, int start, int length) {
+    for (int i = 0; i < length; i++) {
+        m->put(start + i, my_rand() % 256);
+    }
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function creates a random permutation of 0 .. n-1 (Fisher-Yates).
+ *
+ *  @return     The permutation, to be released with free.
+ ****************************************************************************************/
+static int *random_permutation(int n) {
+    int *perm = malloc(n * sizeof(int));
+    TEST_AND_EXIT_ERRNO(!perm, "workload: malloc failed");
+    for (int i = 0; i < n; i++) {
+        perm[i] = i;
+    }
+    for (int i = n - 1; i > 0; i--) {
+        int j = my_rand() % (i + 1);
+        int tmp = perm[i];
+        perm[i] = perm[j];
+        perm[j] = tmp;
+    }
+    return perm;
+}
+
+static int ops_of(const struct workload_params *p) {
+    return (p->ops > 0) ? p->ops : 4 * p->size;
+}
+
+/*
+ * mergesort
+ */
+
+static int mergesort_footprint(const struct workload_params *p) {
+    return 2 * p->size;
+}
+
+static void sort_init(const struct workload_mem *m, const struct workload_params *p) {
+    fill_random(m, 0, p->size);
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function merges the sorted runs src[lo, mid) and src[mid, hi) into
+ *              dst[lo, hi). Each element is read once.
+ ****************************************************************************************/
+static void merge(const struct workload_mem *m, int src, int dst, int lo, int mid, int hi) {
+    int i = lo, j = mid;
+    unsigned char a = (i < mid) ? m->get(src + i) : 0;
+    unsigned char b = (j < hi) ? m->get(src + j) : 0;
+    for (int k = lo; k < hi; k++) {
+        if ((j >= hi) || ((i < mid) && (a <= b))) {
+            m->put(dst + k, a);
+            if (++i < mid) a = m->get(src + i);
+        } else {
+            m->put(dst + k, b);
+            if (++j < hi) b = m->get(src + j);
+        }
+    }
+}
+
+static unsigned long mergesort_run(const struct workload_mem *m, const struct workload_params *p) {
+    int n = p->size;
+    int src = 0, dst = n;
+    for (int width = 1; width < n; width *= 2) {
+        for (int lo = 0; lo < n; lo += 2 * width) {
+            int mid = (lo + width < n) ? lo + width : n;
+            int hi = (lo + 2 * width < n) ? lo + 2 * width : n;
+            merge(m, src, dst, lo, mid, hi);
+        }
+        src = dst;
+        dst = n - dst;
+    }
+    if (src != 0) {
+        for (int i = 0; i < n; i++) {
+            m->put(i, m->get(src + i));
+        }
+    }
+    return 0;
+}
+
+/*
+ * heapsort
+ */
+
+static int heapsort_footprint(const struct workload_params *p) {
+    return p->size;
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      This function moves the element at root down into the heap [0, end).
+ ****************************************************************************************/
+static void sift_down(const struct workload_mem *m, int root, int end) {
+    int start = root;
+    unsigned char v = m->get(root);
+    while (2 * root + 1 < end) {
+        int child = 2 * root + 1;
+        unsigned char c = m->get(child);
+        if (child + 1 < end) {
+            unsigned char c2 = m->get(child + 1);
+            if (c2 > c) {
+                child++;
+                c = c2;
+            }
+        }
+        if (c <= v) {
+            break;
+        }
+        m->put(root, c);
+        root = child;
+    }
+    if (root != start) {
+        m->put(root, v);
+    }
+}
+
+static unsigned long heapsort_run(const struct workload_mem *m, const struct workload_params *p) {
+    int n = p->size;
+    for (int i = n / 2 - 1; i >= 0; i--) {
+        sift_down(m, i, n);
+    }
+    for (int end = n - 1; end > 0; end--) {
+        unsigned char top = m->get(0);
+        m->put(0, m->get(end));
+        m->put(end, top);
+        sift_down(m, 0, end);
+    }
+    return 0;
+}
+
+/*
+ * matmul
+ */
+
+static int matmul_footprint(const struct workload_params *p) {
+    return ((p->block >= 1) && (p->block <= p->size)) ? 3 * p->size * p->size : 0;
+}
+
+static void matmul_init(const struct workload_mem *m, const struct workload_params *p) {
+    int nn = p->size * p->size;
+    fill_random(m, 0, 2 * nn);
+    for (int i = 0; i < nn; i++) {
+        m->put(2 * nn + i, 0);
+    }
+}
+
+static unsigned long matmul_run(const struct workload_mem *m, const struct workload_params *p) {
+    int n = p->size, b = p->block;
+    int a_start = 0, b_start = n * n, c_start = 2 * n * n;
+    unsigned long sum = 0;
+    for (int ii = 0; ii < n; ii += b) {
+        for (int jj = 0; jj < n; jj += b) {
+            for (int kk = 0; kk < n; kk += b) {
+                for (int i = ii; (i < ii + b) && (i < n); i++) {
+                    for (int j = jj; (j < jj + b) && (j < n); j++) {
+                        unsigned char s = m->get(c_start + i * n + j);
+                        for (int k = kk; (k < kk + b) && (k < n); k++) {
+                            s += m->get(a_start + i * n + k) * m->get(b_start + k * n + j);
+                        }
+                        m->put(c_start + i * n + j, s);
+                        if (kk + b >= n) {
+                            // element of C is complete
+                            sum += (unsigned long) s * (i * n + j + 1);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return sum;
+}
+
+/*
+ * hash
+ */
+
+static int hash_footprint(const struct workload_params *p) {
+    return WORKLOAD_SLOTSIZE * p->size;
+}
+
+static void hash_init(const struct workload_mem *m, const struct workload_params *p) {
+    for (int i = 0; i < WORKLOAD_SLOTSIZE * p->size; i++) {
+        m->put(i, 0);
+    }
+}
+
+static unsigned long hash_run(const struct workload_mem *m, const struct workload_params *p) {
+    int n = p->size;
+    // twice as many keys as slots, a key is inserted while the table is less than 3/4 full
+    int nkeys = (2 * n < WORKLOAD_MAXINDEX - 1) ? 2 * n : WORKLOAD_MAXINDEX - 1;
+    long used = 0, hits = 0;
+    for (int op = 0; op < ops_of(p); op++) {
+        int key = 1 + my_rand() % nkeys;
+        int slot = (int) (((unsigned) key * 2654435761u) % n);
+        for (int probe = 0; probe < n; probe++) {
+            int addr = WORKLOAD_SLOTSIZE * slot;
+            int k = get16(m, addr);
+            if (k == key) {
+                m->put(addr + 2, m->get(addr + 2) + 1);
+                hits++;
+                break;
+            }
+            if (k == 0) {
+                if (4 * used < 3 * n) {
+                    put16(m, addr, key);
+                    m->put(addr + 2, 1);
+                    used++;
+                }
+                break;
+            }
+            slot = (slot + 1) % n;
+        }
+    }
+    return hits * WORKLOAD_MAXINDEX + used;
+}
+
+/*
+ * list
+ */
+
+static int list_footprint(const struct workload_params *p) {
+    return ((p->size >= 2) && (p->size <= WORKLOAD_MAXINDEX)) ? WORKLOAD_NODESIZE * p->size : 0;
+}
+
+static void list_init(const struct workload_mem *m, const struct workload_params *p) {
+    int n = p->size;
+    int *order = random_permutation(n);
+    for (int i = 0; i < n; i++) {
+        int node = WORKLOAD_NODESIZE * order[i];
+        put16(m, node, order[(i + 1) % n] % WORKLOAD_MAXINDEX);
+        m->put(node + 2, my_rand() % 256);
+        m->put(node + 3, 0);
+    }
+    free(order);
+}
+
+static unsigned long list_run(const struct workload_mem *m, const struct workload_params *p) {
+    unsigned long sum = 0;
+    int node = 0;
+    for (int op = 0; op < ops_of(p); op++) {
+        sum += m->get(WORKLOAD_NODESIZE * node + 2);
+        node = get16(m, WORKLOAD_NODESIZE * node);
+    }
+    return sum;
+}
+
+/*
+ * zipf
+ */
+
+static int zipf_footprint(const struct workload_params *p) {
+    return (p->skew >= 0.0) ? p->size : 0;
+}
+
+static void zipf_init(const struct workload_mem *m, const struct workload_params *p) {
+    fill_random(m, 0, p->size);
+}
+
+static unsigned long zipf_run(const struct workload_mem *m, const struct workload_params *p) {
+    int n = p->size;
+    int npages = (n + VMEM_PAGESIZE - 1) / VMEM_PAGESIZE;
+    double *cdf = malloc(npages * sizeof(double));
+    TEST_AND_EXIT_ERRNO(!cdf, "workload: malloc failed");
+    double total = 0.0;
+    for (int r = 0; r < npages; r++) {
+        total += 1.0 / pow(r + 1, p->skew);
+        cdf[r] = total;
+    }
+    int *page_of_rank = random_permutation(npages);
+    unsigned long sum = 0;
+    for (int op = 0; op < ops_of(p); op++) {
+        // smallest rank whose cumulative weight exceeds u
+        double u = my_rand() / 2147483648.0 * total;
+        int lo = 0, hi = npages - 1;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (cdf[mid] > u) {
+                hi = mid;
+            } else {
+                lo = mid + 1;
+            }
+        }
+        int start = page_of_rank[lo] * VMEM_PAGESIZE;
+        int len = (n - start < VMEM_PAGESIZE) ? n - start : VMEM_PAGESIZE;
+        int addr = start + my_rand() % len;
+        unsigned char v = m->get(addr);
+        m->put(addr, v + 1);
+        sum += v;
+    }
+    free(page_of_rank);
+    free(cdf);
+    return sum;
+}
+
+static const struct workload workloads[] = {
+    { "mergesort", VMEM_VIRTMEMSIZE / 2, true,  mergesort_footprint, sort_init,   mergesort_run },
+    { "heapsort",  550,                  true,  heapsort_footprint,  sort_init,   heapsort_run },
+    { "matmul",    16,                   false, matmul_footprint,    matmul_init, matmul_run },
+    { "hash",      256,                  false, hash_footprint,      hash_init,   hash_run },
+    { "list",      256,                  false, list_footprint,      list_init,   list_run },
+    { "zipf",      VMEM_VIRTMEMSIZE,     false, zipf_footprint,      zipf_init,   zipf_run },
+};
+
+#define NWORKLOADS (sizeof(workloads) / sizeof(workloads[0])) //!< Number of workloads
+
+const struct workload *find_workload(const char *name) {
+    for (int i = 0; i < NWORKLOADS; i++) {
+        if (0 == strcasecmp(workloads[i].name, name)) {
+            return &workloads[i];
+        }
+    }
+    return NULL;
+}
+
+const char *workload_names(void) {
+    static char names[128] = "";
+    if (names[0] == '\0') {
+        for (int i = 0; i < NWORKLOADS; i++) {
+            strcat(names, i ? "|" : "");
+            strcat(names, workloads[i].name);
+        }
+    }
+    return names;
+}
+
+// EOF
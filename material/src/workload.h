@@ -0,0 +1,78 @@
+/**
+ * @file workload.h
+ * @date Oct 2026
+ * @brief Header file of the workloads of vmappl besides quicksort and bubblesort.
+ *        A workload accesses the memory only through a struct workload_mem, so it runs
+ *        on the simulated virtual memory as well as on the mapped region of -native.
+ *        The data are created by init with my_rand, which must be seeded before; run
+ *        continues the random number sequence. Hence the accesses and the result of
+ *        a workload depend only on the seed and the parameters.
+ *
+ *        Workloads and their memory layout (n: size):
+ *        - mergesort: bottom-up merge sort of n bytes, the second n bytes are the
+ *          buffer of the merge passes.
+ *        - heapsort: heap sort of n bytes in place.
+ *        - matmul: C = A * B of n x n byte matrices (modulo 256) in tiles of
+ *          block x block elements; A, B and C are stored one after another.
+ *        - hash: open addressing table of n slots with linear probing, a slot holds
+ *          a 16 bit key and an 8 bit counter. Each operation increments the counter
+ *          of a random key, inserting the key if it is missing.
+ *        - list: n nodes of 4 bytes (16 bit index of the next node, value, unused)
+ *          linked in random order into one cycle, which is followed.
+ *        - zipf: read-modify-write of random bytes of n bytes, the page of a byte is
+ *          drawn from a Zipf distribution with exponent skew. The ranks are assigned
+ *          to random pages, so the hot pages are not adjacent.
+ */
+
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <stdbool.h>
+
+/**
+ * Access to the memory of a workload
+ */
+struct workload_mem {
+    unsigned char (*get)(int addr);                 //!< Read a byte
+    void (*put)(int addr, unsigned char val);       //!< Write a byte
+};
+
+/**
+ * Parameters of a workload
+ */
+struct workload_params {
+    int size;               //!< Size n of the workload, see above
+    int block;              //!< Edge length of the tiles of matmul
+    int ops;                //!< Number of operations of hash, list and zipf; 0: 4 * size
+    double skew;            //!< Exponent of the Zipf distribution; 0: uniform
+};
+
+/**
+ * A workload
+ */
+struct workload {
+    const char *name;                                                   //!< Name, selected by vmappl -<name>
+    int default_size;                                                   //!< Size if not set by vmappl -length=
+    bool sorts;                                                         //!< The first size bytes are sorted by run
+    int  (*footprint)(const struct workload_params *p);                 //!< Number of bytes used; 0: parameters invalid
+    void (*init)(const struct workload_mem *m, const struct workload_params *p); //!< Create the data
+    unsigned long (*run)(const struct workload_mem *m, const struct workload_params *p); //!< Run, return a checksum of the result
+};
+
+/**
+ *****************************************************************************************
+ *  @brief      This function looks up a workload.
+ *
+ *  @param      name Name of the workload, the case is ignored.
+ *
+ *  @return     The workload; NULL if there is none with this name.
+ ****************************************************************************************/
+const struct workload *find_workload(const char *name);
+
+/**
+ *****************************************************************************************
+ *  @brief      This function returns the names of all workloads, separated by '|'.
+ ****************************************************************************************/
+const char *workload_names(void);
+
+#endif /* WORKLOAD_H */